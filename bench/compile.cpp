@@ -0,0 +1,218 @@
+//
+// Copyright (c) 2023, Jan Sladek <keddelzz@web.de>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+//
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <string>
+
+#include <sigil/CompileStatistics.h>
+#include <sigil/Grammar.h>
+
+// Compile time of Grammar::compile, swept over the size of specifications.
+// Every result is printed as one JSON object per line:
+//
+//   sigil-compile-bench [largest literal count]
+
+constexpr static Size DefaultMaxLiteralCount { 50000 };
+// Compiles faster than this are repeated, the fastest run is reported
+constexpr static double RepeatBelowSeconds { 1.0 };
+constexpr static Size RepeatCount { 3 };
+
+// The specification only keeps views of its patterns
+using Patterns = std::deque<std::string>;
+
+static StringView keep(Patterns &patterns, std::string pattern)
+{
+    const auto &kept = patterns.emplace_back(std::move(pattern));
+    return StringView(kept.data(), s64(kept.size()));
+}
+
+// Distinct lowercase words, the same on every run. The index is scrambled
+// (a bijection on 32 bits), so consecutive words share few prefixes and
+// suffixes.
+static std::string word(Size index)
+{
+    auto scrambled = u32(index) * 2654435761u;
+    std::string result = "w";
+    do {
+        result += char('a' + scrambled % 26);
+        scrambled /= 26;
+    } while (scrambled > 0);
+    return result;
+}
+
+static sigil::Specification literals(Patterns &patterns, Size count)
+{
+    sigil::Specification specification;
+    for (Index i = 0; i < count; ++i) {
+        specification.add_literal_token(
+            s32(i), "Literal", keep(patterns, word(i)));
+    }
+    return specification;
+}
+
+static sigil::Specification dictionary(Patterns &patterns, Size count)
+{
+    List<StringView> words(count);
+    for (Index i = 0; i < count; ++i) words.add(keep(patterns, word(i)));
+
+    sigil::Specification specification;
+    specification.add_literal_tokens(0, "Word", words.to_view());
+    return specification;
+}
+
+// (a(b(c...)*)*)*, every level a concatenation below a Kleene star
+static sigil::Specification nesting(Patterns &patterns, Size depth)
+{
+    std::string pattern;
+    for (Index i = 0; i < depth; ++i) {
+        pattern += "(";
+        pattern += char('a' + i % 26);
+    }
+    for (Index i = 0; i < depth; ++i) pattern += ")*";
+
+    sigil::Specification specification;
+    specification.add_regex_token(
+        0, "Nested", keep(patterns, std::move(pattern)));
+    specification.add_regex_token(1, "Identifier", "[a-z]+");
+    return specification;
+}
+
+// wa|wb|wc|..., a single token with many alternatives
+static sigil::Specification alternation(Patterns &patterns, Size width)
+{
+    std::string pattern;
+    for (Index i = 0; i < width; ++i) {
+        if (i > 0)
+            pattern += "|";
+        pattern += word(i);
+    }
+
+    sigil::Specification specification;
+    specification.add_regex_token(
+        0, "Alternation", keep(patterns, std::move(pattern)));
+    return specification;
+}
+
+// Eight overlapping tokens [...]+, each class with the given percentage of
+// the alphanumeric characters. Denser classes overlap more, which yields
+// more subsets of tokens and so more DFA states.
+static sigil::Specification class_density(Patterns &patterns, Size percent)
+{
+    static const char Alphabet[] =
+        "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+    constexpr Size alphabet_size = sizeof(Alphabet) - 1;
+    constexpr Size token_count = 8;
+
+    sigil::Specification specification;
+    u64 random = 0x9E3779B97F4A7C15ull;
+    for (Index token = 0; token < token_count; ++token) {
+        std::string pattern = "[";
+        for (Index i = 0; i < alphabet_size; ++i) {
+            random ^= random << 13;
+            random ^= random >> 7;
+            random ^= random << 17;
+            if (random % 100 < percent)
+                pattern += Alphabet[i];
+        }
+        if (pattern.size() == 1)
+            pattern += Alphabet[token];
+        pattern += "]+";
+
+        specification.add_regex_token(
+            s32(token), "Class", keep(patterns, std::move(pattern)));
+    }
+    return specification;
+}
+
+static long peak_rss_kib()
+{
+    rusage usage {};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+static void report(
+    const char *sweep,
+    Size parameter,
+    sigil::Specification (*create)(Patterns &, Size))
+{
+    sigil::CompileStatistics best;
+    double best_seconds = 0.0;
+    for (Index run = 0; run < RepeatCount; ++run) {
+        Patterns patterns;
+        const auto specification = create(patterns, parameter);
+
+        sigil::CompileStatistics statistics;
+        auto either_grammar =
+            sigil::Grammar::compile(specification, &statistics);
+        if (not either_grammar.isRight()) {
+            fprintf(stderr, "%s %zu: could not compile\n", sweep, parameter);
+            exit(EXIT_FAILURE);
+        }
+
+        const auto seconds =
+            double(
+                statistics.parse_microseconds + statistics.nfa_microseconds +
+                statistics.dfa_microseconds) /
+            1e6;
+        if (run == 0 or seconds < best_seconds) {
+            best = statistics;
+            best_seconds = seconds;
+        }
+        if (seconds >= RepeatBelowSeconds)
+            break;
+    }
+
+    // The high-water mark of the process, sweeps run from small to large
+    printf(
+        "{\"sweep\": \"%s\", \"parameter\": %zu, \"seconds\": %.6f, "
+        "\"parse_seconds\": %.6f, \"nfa_seconds\": %.6f, "
+        "\"dfa_seconds\": %.6f, \"nfa_states\": %zu, \"dfa_states\": %zu, "
+        "\"dfa_arcs\": %zu, \"largest_nfa_state_set\": %zu, "
+        "\"estimated_arena_bytes\": %zu, \"peak_rss_kib\": %ld}\n",
+        sweep,
+        parameter,
+        best_seconds,
+        double(best.parse_microseconds) / 1e6,
+        double(best.nfa_microseconds) / 1e6,
+        double(best.dfa_microseconds) / 1e6,
+        best.nfa_state_count,
+        best.dfa_state_count,
+        best.dfa_arc_count,
+        best.largest_nfa_state_set,
+        best.estimated_arena_bytes,
+        peak_rss_kib());
+    fflush(stdout);
+}
+
+int main(int argc, char **argv)
+{
+    auto max_literal_count = DefaultMaxLiteralCount;
+    if (argc > 1)
+        max_literal_count = Size(strtoull(argv[1], nullptr, 10));
+
+    for (const Size count : { 10, 100, 1000, 5000, 10000, 50000 }) {
+        if (count <= max_literal_count)
+            report("literals", count, literals);
+    }
+    for (const Size count : { 10, 100, 1000, 5000, 10000, 50000 }) {
+        if (count <= max_literal_count)
+            report("dictionary", count, dictionary);
+    }
+    for (const Size depth : { 1, 2, 4, 8, 16, 32, 64 })
+        report("nesting", depth, nesting);
+    for (const Size width : { 2, 10, 100, 1000 })
+        report("alternation", width, alternation);
+    for (const Size percent : { 5, 10, 25, 50, 75, 100 })
+        report("class-density", percent, class_density);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,809 @@
+//
+// Copyright (c) 2023, Jan Sladek <keddelzz@web.de>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <sigil/BatchScanner.h>
+#include <sigil/BitParallelScannerDriver.h>
+#include <sigil/CompiledScanner.h>
+#include <sigil/DfaScannerDriver.h>
+#include <sigil/DfaTableScannerDriver.h>
+#include <sigil/Grammar.h>
+#include <sigil/LazyDfaScannerDriver.h>
+#include <sigil/LiteralPrefilter.h>
+#include <sigil/Nfa.h>
+#include <sigil/NfaScannerDriver.h>
+#include <sigil/ScanCursor.h>
+#include <sigil/Searcher.h>
+#include <sigil/ShuffleScanner.h>
+#include <sigil/StaticTableScannerDriver.h>
+
+// Scanner throughput of all drivers on synthetic corpora. Every result is
+// printed as one JSON object per line, the median of several passes over the
+// corpus after a warm-up pass:
+//
+//   sigil-bench [corpus size in KiB]
+
+constexpr static Size DefaultCorpusKiB { 4096 };
+constexpr static Size SampleCount { 5 };
+// DfaScannerDriver searches all arcs per byte and NfaScannerDriver visits all
+// active NFA states, they get smaller corpora
+constexpr static Size DfaCorpusDivisor { 64 };
+
+// xorshift64, the corpora have to be the same on every platform
+class Random
+{
+public:
+    u64 next()
+    {
+        m_state ^= m_state << 13;
+        m_state ^= m_state >> 7;
+        m_state ^= m_state << 17;
+        return m_state;
+    }
+    u64 below(u64 bound) { return next() % bound; }
+    bool chance(u64 percent) { return below(100) < percent; }
+
+private:
+    u64 m_state { 0x9E3779B97F4A7C15ull };
+};
+
+// Everything from the opening quote up to the closing quote, without escapes
+static void build_delimited(sigil::nfa::Automaton &automaton, u8 open, u8 close)
+{
+    auto start = automaton.create_state();
+    auto inside = automaton.create_state();
+    auto end = automaton.create_state();
+    start->start = true;
+    end->accepting = true;
+
+    auto content = ~sigil::CharSet(close);
+    content.set('\n', false);
+    automaton.create_character_arc(start, inside, sigil::CharSet(open));
+    automaton.create_character_arc(inside, inside, content);
+    automaton.create_character_arc(inside, end, sigil::CharSet(close));
+}
+
+static void add_identifier(std::string &out, Random &random)
+{
+    static const char *const Words[] = {
+        "value", "count", "index", "buffer", "node", "result", "x", "tmp",
+    };
+    out += Words[random.below(std::size(Words))];
+    if (random.chance(50))
+        out += std::to_string(random.below(1000));
+}
+
+struct Corpus
+{
+    const char *name { nullptr };
+    sigil::Specification (*specification)() { nullptr };
+    std::string (*generate)(Size) { nullptr };
+    /// Slow corpora are scaled down
+    Size size_divisor { 1 };
+};
+
+static sigil::Specification c_like_specification()
+{
+    enum Type : s32
+    {
+        Identifier,
+        Number,
+        String,
+        Comment,
+        Whitespace,
+        Operator,
+        Keyword,
+    };
+
+    sigil::Specification specification;
+    specification.add_regex_token(
+        Identifier, "Identifier", "[a-zA-Z_][a-zA-Z0-9_]*");
+    specification.add_regex_token(Number, "Number", "[0-9]+");
+    specification.add_nfa_token(
+        String, "String", [](sigil::nfa::Automaton &automaton) {
+            build_delimited(automaton, '"', '"');
+        });
+    specification.add_regex_token(Comment, "Comment", "//[^\\n]*");
+    specification.add_regex_token(Whitespace, "Whitespace", "[ \\n\\t]+");
+    specification.skip_token_type(Whitespace);
+    specification.skip_token_type(Comment);
+    for (const auto op : { "+", "-", "*", "/", "=", "==", "<", ">", "(", ")",
+                           "{", "}", ";", "," })
+        specification.add_literal_token(Operator, "Operator", op);
+    for (const auto keyword : { "int", "if", "else", "return", "while" })
+        specification.add_keyword_token(
+            Keyword, "Keyword", keyword, Identifier);
+    return specification;
+}
+
+static std::string generate_c_like(Size size)
+{
+    static const char *const Operators[] = { " + ", " - ", " * ", " / " };
+
+    Random random;
+    std::string out;
+    while (out.size() < size) {
+        switch (random.below(5)) {
+            case 0:
+                out += "int ";
+                add_identifier(out, random);
+                out += " = ";
+                out += std::to_string(random.below(100000));
+                out += ";\n";
+                break;
+            case 1:
+                out += "if (";
+                add_identifier(out, random);
+                out += " < ";
+                add_identifier(out, random);
+                out += ") {\n    return ";
+                add_identifier(out, random);
+                out += ";\n} else {\n    return 0;\n}\n";
+                break;
+            case 2:
+                add_identifier(out, random);
+                out += " = ";
+                add_identifier(out, random);
+                out += Operators[random.below(std::size(Operators))];
+                out += "(";
+                add_identifier(out, random);
+                out += " - ";
+                out += std::to_string(random.below(100));
+                out += ");\n";
+                break;
+            case 3:
+                out += "// ";
+                add_identifier(out, random);
+                out += " keeps the running total of the loop below\n";
+                break;
+            case 4:
+                add_identifier(out, random);
+                out += "(\"message ";
+                out += std::to_string(random.below(1000));
+                out += "\", ";
+                add_identifier(out, random);
+                out += ");\n";
+                break;
+        }
+    }
+    return out;
+}
+
+static sigil::Specification json_specification()
+{
+    enum Type : s32
+    {
+        Punctuation,
+        Constant,
+        Number,
+        String,
+        Whitespace,
+    };
+
+    sigil::Specification specification;
+    for (const auto punctuation : { "{", "}", "[", "]", ":", "," }) {
+        specification.add_literal_token(
+            Punctuation, "Punctuation", punctuation);
+    }
+    for (const auto constant : { "true", "false", "null" })
+        specification.add_literal_token(Constant, "Constant", constant);
+    specification.add_regex_token(
+        Number, "Number", "-?[0-9]+(\\.[0-9]+)?([eE](\\+|-)?[0-9]+)?");
+    specification.add_nfa_token(
+        String, "String", [](sigil::nfa::Automaton &automaton) {
+            build_delimited(automaton, '"', '"');
+        });
+    specification.add_regex_token(Whitespace, "Whitespace", "[ \\n\\t]+");
+    specification.skip_token_type(Whitespace);
+    return specification;
+}
+
+static void add_json_value(std::string &out, Random &random, Size depth)
+{
+    const auto kind = random.below(depth < 3 ? 7 : 5);
+    switch (kind) {
+        case 0: out += std::to_string(random.below(1000000)); break;
+        case 1:
+            out += "-";
+            out += std::to_string(random.below(1000));
+            out += ".";
+            out += std::to_string(random.below(1000));
+            out += "e+";
+            out += std::to_string(random.below(10));
+            break;
+        case 2:
+            out += "\"";
+            add_identifier(out, random);
+            out += " text\"";
+            break;
+        case 3: out += random.chance(50) ? "true" : "false"; break;
+        case 4: out += "null"; break;
+        case 5: {
+            out += "[";
+            const auto count = random.below(6);
+            for (u64 i = 0; i < count; ++i) {
+                if (i > 0)
+                    out += ", ";
+                add_json_value(out, random, depth + 1);
+            }
+            out += "]";
+        } break;
+        case 6: {
+            out += "{\n";
+            const auto count = random.below(6);
+            for (u64 i = 0; i < count; ++i) {
+                if (i > 0)
+                    out += ",\n";
+                out += std::string(2 * (depth + 1), ' ');
+                out += "\"";
+                add_identifier(out, random);
+                out += "\": ";
+                add_json_value(out, random, depth + 1);
+            }
+            out += "\n";
+            out += std::string(2 * depth, ' ');
+            out += "}";
+        } break;
+    }
+}
+
+static std::string generate_json(Size size)
+{
+    Random random;
+    std::string out = "[\n";
+    while (out.size() < size) {
+        add_json_value(out, random, 1);
+        out += ",\n";
+    }
+    out += "null\n]\n";
+    return out;
+}
+
+static sigil::Specification access_log_specification()
+{
+    enum Type : s32
+    {
+        Address,
+        Number,
+        Dash,
+        Timestamp,
+        Request,
+        Whitespace,
+    };
+
+    sigil::Specification specification;
+    specification.add_regex_token(
+        Address, "Address", "[0-9]{1,3}(\\.[0-9]{1,3}){3}");
+    specification.add_regex_token(Number, "Number", "[0-9]+");
+    specification.add_literal_token(Dash, "Dash", "-");
+    specification.add_nfa_token(
+        Timestamp, "Timestamp", [](sigil::nfa::Automaton &automaton) {
+            build_delimited(automaton, '[', ']');
+        });
+    specification.add_nfa_token(
+        Request, "Request", [](sigil::nfa::Automaton &automaton) {
+            build_delimited(automaton, '"', '"');
+        });
+    specification.add_regex_token(Whitespace, "Whitespace", "[ \\n]+");
+    specification.skip_token_type(Whitespace);
+    return specification;
+}
+
+static std::string generate_access_log(Size size)
+{
+    static const char *const Methods[] = { "GET", "POST", "PUT", "DELETE" };
+    static const char *const Months[] = { "Jan", "Apr", "Jul", "Oct" };
+    static const char *const Statuses[] = { "200", "301", "404", "500" };
+
+    Random random;
+    std::string out;
+    while (out.size() < size) {
+        for (auto i = 0; i < 4; ++i) {
+            if (i > 0)
+                out += ".";
+            out += std::to_string(random.below(256));
+        }
+        out += " - - [";
+        out += std::to_string(1 + random.below(28));
+        out += "/";
+        out += Months[random.below(std::size(Months))];
+        out += "/2023:";
+        out += std::to_string(10 + random.below(14));
+        out += ":";
+        out += std::to_string(10 + random.below(50));
+        out += ":";
+        out += std::to_string(10 + random.below(50));
+        out += " +0000] \"";
+        out += Methods[random.below(std::size(Methods))];
+        out += " /";
+        add_identifier(out, random);
+        out += "/";
+        add_identifier(out, random);
+        out += ".html HTTP/1.1\" ";
+        out += Statuses[random.below(std::size(Statuses))];
+        out += " ";
+        out += std::to_string(random.below(100000));
+        out += "\n";
+    }
+    return out;
+}
+
+// Unquoted comma-separated values, a grammar small enough for ShuffleScanner
+static sigil::Specification csv_specification()
+{
+    enum Type : s32
+    {
+        Field,
+        Number,
+        Comma,
+        Newline,
+        Whitespace,
+    };
+
+    sigil::Specification specification;
+    specification.add_regex_token(Field, "Field", "[A-Za-z_][A-Za-z_0-9]*");
+    specification.add_regex_token(Number, "Number", "[0-9]+");
+    specification.add_literal_token(Comma, "Comma", ",");
+    specification.add_literal_token(Newline, "Newline", "\n");
+    specification.add_regex_token(Whitespace, "Whitespace", " +");
+    specification.skip_token_type(Whitespace);
+    return specification;
+}
+
+static std::string generate_csv(Size size)
+{
+    Random random;
+    std::string out;
+    while (out.size() < size) {
+        for (auto i = 0; i < 6; ++i) {
+            if (i > 0)
+                out += random.chance(20) ? ", " : ",";
+            if (random.chance(50))
+                add_identifier(out, random);
+            else
+                out += std::to_string(random.below(100000));
+        }
+        out += "\n";
+    }
+    return out;
+}
+
+// Every token reads up to the end of its run of a's looking for a b, before
+// backtracking to the single a: quadratic in the length of the run
+static sigil::Specification backtracking_specification()
+{
+    enum Type : s32
+    {
+        A,
+        AB,
+        Newline,
+    };
+
+    sigil::Specification specification;
+    specification.add_literal_token(A, "A", "a");
+    specification.add_regex_token(AB, "AB", "a+b");
+    specification.add_literal_token(Newline, "Newline", "\n");
+    specification.skip_token_type(Newline);
+    return specification;
+}
+
+static std::string generate_backtracking(Size size)
+{
+    Random random;
+    std::string out;
+    while (out.size() < size) {
+        out += std::string(64 + random.below(192), 'a');
+        out += random.chance(50) ? "b\n" : "\n";
+    }
+    return out;
+}
+
+constexpr static Size DictionaryWordCount { 4000 };
+
+// Random lowercase words, the trie of which doesn't fit into the caches
+static const std::vector<std::string> &dictionary_words()
+{
+    static const auto words = [] {
+        Random random;
+        std::vector<std::string> result;
+        for (Index i = 0; i < DictionaryWordCount; ++i) {
+            std::string word;
+            const auto length = 4 + random.below(9);
+            for (Index j = 0; j < length; ++j)
+                word += char('a' + random.below(26));
+            result.push_back(word);
+        }
+        return result;
+    }();
+    return words;
+}
+
+static sigil::Specification dictionary_specification()
+{
+    enum Type : s32
+    {
+        Word,
+        Whitespace,
+    };
+
+    sigil::Specification specification;
+    for (const auto &word : dictionary_words()) {
+        specification.add_literal_token(
+            Word, "Word", StringView(word.data(), s64(word.size())));
+    }
+    specification.add_regex_token(Whitespace, "Whitespace", "[ \\n]+");
+    specification.skip_token_type(Whitespace);
+    return specification;
+}
+
+static std::string generate_dictionary(Size size)
+{
+    const auto &words = dictionary_words();
+    Random random;
+    std::string out;
+    while (out.size() < size) {
+        const auto count = 4 + random.below(12);
+        for (Index i = 0; i < count; ++i) {
+            out += words[random.below(words.size())];
+            out += i + 1 < count ? ' ' : '\n';
+        }
+    }
+    return out;
+}
+
+// One rare request in the access log, the way grep would look for it
+static sigil::Specification search_specification()
+{
+    enum Type : s32
+    {
+        Request,
+    };
+
+    sigil::Specification specification;
+    specification.add_regex_token(
+        Request, "Request", "DELETE /tmp/[a-z]+\\.html");
+    return specification;
+}
+
+enum class Access : u8
+{
+    Next,
+    Lookahead,
+};
+
+struct Sample
+{
+    u64 tokens { 0 };
+    u64 errors { 0 };
+    double seconds { 0.0 };
+};
+
+static Sample scan(
+    sigil::ScannerDriver &scanner, StringView input, Access access)
+{
+    using Clock = std::chrono::steady_clock;
+    constexpr auto Error = s32(sigil::SpecialTokenType::Error);
+
+    Sample sample;
+    const auto start = Clock::now();
+    scanner.initialize("<bench>", input);
+    switch (access) {
+        case Access::Next:
+            while (scanner.has_next()) {
+                const auto token = scanner.next();
+                sample.errors += token.type == Error;
+                ++sample.tokens;
+            }
+            break;
+        case Access::Lookahead:
+            while (scanner.can_lookahead()) {
+                const auto &token = scanner.lookahead();
+                sample.errors += token.type == Error;
+                ++sample.tokens;
+                scanner.consume();
+            }
+            break;
+    }
+    const auto elapsed = Clock::now() - start;
+    sample.seconds = std::chrono::duration<double>(elapsed).count();
+    return sample;
+}
+
+static void report(
+    const char *corpus,
+    const char *driver,
+    sigil::ScannerDriver &scanner,
+    const std::string &input)
+{
+    const StringView view(input.data(), s64(input.size()));
+    for (const auto access : { Access::Next, Access::Lookahead }) {
+        const auto warm_up = scan(scanner, view, access);
+        if (warm_up.errors != 0) {
+            fprintf(
+                stderr, "%s: %s could not scan the corpus\n", corpus, driver);
+            exit(EXIT_FAILURE);
+        }
+
+        double seconds[SampleCount];
+        for (Index i = 0; i < SampleCount; ++i)
+            seconds[i] = scan(scanner, view, access).seconds;
+        std::sort(seconds, seconds + SampleCount);
+        const auto median = seconds[SampleCount / 2];
+
+        printf(
+            "{\"corpus\": \"%s\", \"driver\": \"%s\", \"access\": \"%s\", "
+            "\"bytes\": %zu, \"tokens\": %llu, \"seconds\": %.6f, "
+            "\"mb_per_s\": %.2f, \"tokens_per_s\": %.0f}\n",
+            corpus,
+            driver,
+            access == Access::Next ? "next" : "lookahead",
+            input.size(),
+            (unsigned long long)warm_up.tokens,
+            median,
+            double(input.size()) / median / 1e6,
+            double(warm_up.tokens) / median);
+        fflush(stdout);
+    }
+}
+
+static void report_search(
+    const char *corpus,
+    const char *driver,
+    sigil::Searcher searcher,
+    const std::string &input)
+{
+    using Clock = std::chrono::steady_clock;
+
+    const StringView view(input.data(), s64(input.size()));
+    const auto match_count = searcher.find_all(view).size();
+    double seconds[SampleCount];
+    for (Index i = 0; i < SampleCount; ++i) {
+        const auto start = Clock::now();
+        const auto matches = searcher.find_all(view);
+        const auto elapsed = Clock::now() - start;
+        seconds[i] = std::chrono::duration<double>(elapsed).count();
+    }
+    std::sort(seconds, seconds + SampleCount);
+    const auto median = seconds[SampleCount / 2];
+
+    printf(
+        "{\"corpus\": \"%s\", \"driver\": \"%s\", \"access\": \"search\", "
+        "\"bytes\": %zu, \"tokens\": %zu, \"seconds\": %.6f, "
+        "\"mb_per_s\": %.2f, \"tokens_per_s\": %.0f}\n",
+        corpus,
+        driver,
+        input.size(),
+        match_count,
+        median,
+        double(input.size()) / median / 1e6,
+        double(match_count) / median);
+    fflush(stdout);
+}
+
+// The callback scans the input once and returns the token count
+template<typename ScanInput>
+static void report_scans(
+    const char *corpus,
+    const char *driver,
+    const char *access,
+    const std::string &input,
+    ScanInput scan_input)
+{
+    using Clock = std::chrono::steady_clock;
+
+    const auto token_count = scan_input();
+    double seconds[SampleCount];
+    for (Index i = 0; i < SampleCount; ++i) {
+        const auto start = Clock::now();
+        scan_input();
+        const auto elapsed = Clock::now() - start;
+        seconds[i] = std::chrono::duration<double>(elapsed).count();
+    }
+    std::sort(seconds, seconds + SampleCount);
+    const auto median = seconds[SampleCount / 2];
+
+    printf(
+        "{\"corpus\": \"%s\", \"driver\": \"%s\", \"access\": \"%s\", "
+        "\"bytes\": %zu, \"tokens\": %llu, \"seconds\": %.6f, "
+        "\"mb_per_s\": %.2f, \"tokens_per_s\": %.0f}\n",
+        corpus,
+        driver,
+        access,
+        input.size(),
+        (unsigned long long)token_count,
+        median,
+        double(input.size()) / median / 1e6,
+        double(token_count) / median);
+    fflush(stdout);
+}
+
+// Every line is scanned on its own, like independent records
+static void report_batches(
+    const char *corpus,
+    const sigil::CompiledScanner &scanner,
+    const std::string &input)
+{
+    List<StringView> lines;
+    Index line_start = 0;
+    for (Index i = 0; i < input.size(); ++i) {
+        if (input[i] == '\n') {
+            lines.add(StringView(input.data() + line_start, i - line_start));
+            line_start = i + 1;
+        }
+    }
+
+    report_scans(corpus, "cursor", "lines", input, [&]() {
+        u64 token_count = 0;
+        for (const auto &line : lines) {
+            sigil::ScanCursor cursor(scanner, "<bench>", line);
+            for (auto token = cursor.next();
+                 token.type != s32(sigil::SpecialTokenType::Eof) and
+                 token.type != s32(sigil::SpecialTokenType::Error);
+                 token = cursor.next())
+                ++token_count;
+        }
+        return token_count;
+    });
+
+    for (const auto lane_count : { Size(4), Size(8), Size(16) }) {
+        char driver[32];
+        snprintf(driver, sizeof(driver), "batch-%zu", lane_count);
+        sigil::BatchScanner batch(scanner, lane_count);
+        report_scans(corpus, driver, "lines", input, [&]() {
+            u64 token_count = 0;
+            batch.scan(lines.to_view(), [&](Index, s32 type, StringView) {
+                token_count += type >= 0;
+            });
+            return token_count;
+        });
+    }
+}
+
+// Only small DFAs fit into the state maps
+static void report_shuffles(
+    const char *corpus,
+    const sigil::CompiledScanner &scanner,
+    const std::string &input)
+{
+    auto either_shuffle = sigil::ShuffleScanner::create(scanner);
+    if (not either_shuffle.isRight())
+        return;
+    const auto shuffle = std::move(either_shuffle.release_right());
+
+    const StringView view(input.data(), s64(input.size()));
+    for (const auto chunk_count : { Size(1), Size(8), Size(64) }) {
+        char driver[32];
+        snprintf(driver, sizeof(driver), "shuffle-%zu", chunk_count);
+        report_scans(corpus, driver, "chunks", input, [&]() {
+            u64 token_count = 0;
+            shuffle.scan(view, chunk_count, [&](s32 type, StringView) {
+                token_count += type >= 0;
+            });
+            return token_count;
+        });
+    }
+
+    // The states at the chunk boundaries alone, which is the part chunks
+    // scanned on separate threads have to share
+    report_scans(corpus, "shuffle-states", "chunks", input, [&]() {
+        const auto states = shuffle.chunk_states(view, 64);
+        return u64(states[states.size() - 1]);
+    });
+}
+
+int main(int argc, char **argv)
+{
+    auto corpus_size = DefaultCorpusKiB * 1024;
+    if (argc > 1)
+        corpus_size = Size(strtoull(argv[1], nullptr, 10)) * 1024;
+
+    const Corpus corpora[] = {
+        { "c-like", c_like_specification, generate_c_like, 1 },
+        { "json", json_specification, generate_json, 1 },
+        { "access-log", access_log_specification, generate_access_log, 1 },
+        { "csv", csv_specification, generate_csv, 1 },
+        {
+            "backtracking",
+            backtracking_specification,
+            generate_backtracking,
+            16,
+        },
+    };
+
+    for (const auto &corpus : corpora) {
+        auto either_grammar = sigil::Grammar::compile(corpus.specification());
+        if (not either_grammar.isRight()) {
+            fprintf(stderr, "%s: could not compile the grammar\n", corpus.name);
+            return EXIT_FAILURE;
+        }
+        auto grammar = std::move(either_grammar.release_right());
+
+        const auto size = std::max(corpus_size / corpus.size_divisor, Size(1));
+        const auto input = corpus.generate(size);
+        const auto small_input =
+            corpus.generate(std::max(size / DfaCorpusDivisor, Size(1)));
+
+        sigil::DfaScannerDriver dfa_driver(grammar.dfa());
+        report(corpus.name, "dfa", dfa_driver, small_input);
+
+        auto table_driver = sigil::DfaTableScannerDriver::create(grammar.dfa());
+        report(corpus.name, "dfa-table", table_driver, input);
+
+        sigil::StaticTableScannerDriver static_driver(
+            table_driver.static_table());
+        report(corpus.name, "static-table", static_driver, input);
+
+        // The warm-up pass fills the state cache
+        auto either_lazy_driver =
+            sigil::LazyDfaScannerDriver::create(corpus.specification());
+        if (not either_lazy_driver.isRight()) {
+            fprintf(stderr, "%s: could not create the lazy DFA\n", corpus.name);
+            return EXIT_FAILURE;
+        }
+        auto lazy_driver = std::move(either_lazy_driver.release_right());
+        report(corpus.name, "lazy-dfa", lazy_driver, input);
+
+        auto either_nfa_driver =
+            sigil::NfaScannerDriver::create(corpus.specification());
+        if (not either_nfa_driver.isRight()) {
+            fprintf(stderr, "%s: could not create the NFAs\n", corpus.name);
+            return EXIT_FAILURE;
+        }
+        auto nfa_driver = std::move(either_nfa_driver.release_right());
+        report(corpus.name, "nfa", nfa_driver, small_input);
+
+        // Only small specifications fit into the masks
+        auto either_bit_parallel_driver =
+            sigil::BitParallelScannerDriver::create(corpus.specification());
+        if (either_bit_parallel_driver.isRight()) {
+            auto bit_parallel_driver =
+                std::move(either_bit_parallel_driver.release_right());
+            report(corpus.name, "bit-parallel", bit_parallel_driver, input);
+        }
+
+        report_batches(corpus.name, table_driver.compiled_scanner(), input);
+        report_shuffles(corpus.name, table_driver.compiled_scanner(), input);
+    }
+
+    // Only the lines of the dictionary are scanned, its DFA is too large for
+    // the drivers which don't read a table
+    auto either_dictionary =
+        sigil::CompiledScanner::create(dictionary_specification());
+    if (not either_dictionary.isRight()) {
+        fprintf(stderr, "dictionary: could not compile the grammar\n");
+        return EXIT_FAILURE;
+    }
+    report_batches(
+        "dictionary",
+        either_dictionary.right(),
+        generate_dictionary(corpus_size));
+
+    auto either_grammar = sigil::Grammar::compile(search_specification());
+    auto either_prefilter =
+        sigil::LiteralPrefilter::create(search_specification());
+    if (not either_grammar.isRight() or not either_prefilter.isRight()) {
+        fprintf(stderr, "access-log: could not compile the search\n");
+        return EXIT_FAILURE;
+    }
+    auto grammar = std::move(either_grammar.release_right());
+    auto table_driver = sigil::DfaTableScannerDriver::create(grammar.dfa());
+    const auto table = table_driver.static_table();
+    const auto input = generate_access_log(corpus_size);
+    report_search("access-log", "search", sigil::Searcher(table), input);
+    report_search(
+        "access-log",
+        "search-prefilter",
+        sigil::Searcher(table, std::move(either_prefilter.release_right())),
+        input);
+
+    return EXIT_SUCCESS;
+}
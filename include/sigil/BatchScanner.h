@@ -0,0 +1,227 @@
+//
+// Copyright (c) 2023, Jan Sladek <keddelzz@web.de>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+//
+
+#pragma once
+
+#include <limits>  // std::numeric_limits
+
+#include <core/ListView.h>
+#include <core/StringView.h>
+
+#include <sigil/CompiledScanner.h>
+#include <sigil/SpecialTokenType.h>
+#include <sigil/Types.h>
+
+namespace sigil {
+
+// Tokenizes many independent inputs, e.g. log lines, over one shared table.
+// A single scan is a chain of dependent table loads, so the scanner keeps
+// several inputs in flight as lanes and advances each of them by one byte
+// per round, which lets the loads of different lanes overlap. A lane takes
+// the next input as soon as its input is done.
+//
+// A round doesn't branch on the lanes' tokens: a lane whose DFA fails records
+// its longest match and backs up to its end with conditional moves. Recorded
+// tokens are reported when a lane reaches the end of its input, fails to
+// match or runs out of records, so a round only branches once for all lanes.
+//
+// This pays off when the table doesn't fit into the caches, e.g. a trie of a
+// few thousand literal words, where the lanes overlap their misses: there, the
+// benchmark's "dictionary" lines are scanned about 1.7 times as fast as with
+// a ScanCursor per line, with four lanes or more. A table that fits into L1
+// is read faster by a ScanCursor per input.
+//
+// Every input is scanned in mode 0 from its beginning, with the same longest
+// match as ScanCursor. Tokens carry no file range, their offset within the
+// input follows from the lexeme.
+class BatchScanner
+{
+public:
+    constexpr static Size MaxLaneCount { 16 };
+    constexpr static Size DefaultLaneCount { 4 };
+
+    /// The scanner has to outlive the batch scanner
+    explicit BatchScanner(
+        const CompiledScanner &scanner, Size lane_count = DefaultLaneCount)
+        : m_table(&scanner.table())
+        , m_lane_count(lane_count)
+    {
+        assert(lane_count > 0 and lane_count <= MaxLaneCount);
+    }
+
+    /// Calls back with the index of the input, the token type and the
+    /// lexeme for every token of every input. Tokens of one input are
+    /// reported in order, each input ends with an Eof or an Error token.
+    template<typename Callback>
+    void scan(core::ListView<StringView> inputs, Callback callback) const;
+
+private:
+    constexpr static Size RecordCount { 32 };
+
+    /// A token ends where the next one starts
+    struct Record
+    {
+        const u8 *end { nullptr };
+        TokenType type { s32(SpecialTokenType::Error) };
+    };
+
+    struct Lane
+    {
+        Index input { 0 };
+        const u8 *position { nullptr };
+        const u8 *end { nullptr };
+        /// Start of the first token that isn't reported yet
+        const u8 *start { nullptr };
+        const u8 *last_end { nullptr };
+        TokenType last_type { s32(SpecialTokenType::Error) };
+        State state { 0 };
+        Size record_count { 0 };
+        Record records[RecordCount];
+    };
+
+    const StaticTable *m_table { nullptr };
+    Size m_lane_count { DefaultLaneCount };
+};
+
+template<typename Callback>
+void BatchScanner::scan(
+    core::ListView<StringView> inputs, Callback callback) const
+{
+    constexpr auto char_count = std::numeric_limits<u8>::max() + 1;
+    constexpr auto Error = s32(SpecialTokenType::Error);
+    constexpr auto Skip = s32(SpecialTokenType::Skip);
+
+    const auto start_state = m_table->start_state(0);
+    const auto error_state = m_table->error_state();
+    const auto transitions = m_table->transitions();
+    const auto accepting = m_table->accepting();
+    const auto start_type = accepting[start_state];
+
+    Lane lanes[MaxLaneCount];
+    Size lane_count = 0;
+    Index next_input = 0;
+
+    const auto start_token = [&](Lane &lane, const u8 *start) {
+        lane.position = start;
+        lane.start = start;
+        lane.last_end = start;
+        lane.state = start_state;
+        lane.last_type = start_type;
+    };
+    const auto take_input = [&](Lane &lane) {
+        const auto &input = inputs[next_input];
+        const auto data = reinterpret_cast<const u8 *>(input.data());
+        lane.input = next_input++;
+        lane.end = data + input.size();
+        lane.record_count = 0;
+        start_token(lane, data);
+    };
+    // Reports a finished token, returns false if it ends the input
+    const auto report = [&](const Lane &lane, const u8 *start, Record record) {
+        const StringView lexeme {
+            reinterpret_cast<const char *>(start),
+            record.end - start,
+        };
+        // An empty skipped token does not make progress, so it's an error
+        if (record.type == Error or
+            (record.type == Skip and lexeme.size() == 0)) {
+            callback(lane.input, Error, StringView());
+            return false;
+        }
+        if (record.type != Skip) {
+            callback(
+                lane.input,
+                m_table->keywords().classify(record.type, lexeme),
+                lexeme);
+        }
+        return true;
+    };
+
+    // Reports the recorded tokens of a lane, and its last tokens at the end
+    // of its input, until it can read another byte. Returns false if there
+    // is no input left for the lane.
+    const auto settle = [&](Lane &lane) {
+        for (;;) {
+            bool is_done = false;
+            for (Index i = 0; i < lane.record_count and not is_done; ++i) {
+                is_done = not report(lane, lane.start, lane.records[i]);
+                lane.start = lane.records[i].end;
+            }
+            lane.record_count = 0;
+
+            if (not is_done and lane.position < lane.end)
+                return true;
+            if (not is_done) {
+                // Tokens end at the end of the input, unless nothing matched
+                const auto is_empty = lane.last_end == lane.start;
+                if (lane.start == lane.end or lane.last_type == Error or
+                    (lane.last_type == Skip and is_empty)) {
+                    callback(lane.input, s32(SpecialTokenType::Eof), {});
+                } else if (report(
+                               lane,
+                               lane.start,
+                               { lane.last_end, lane.last_type })) {
+                    start_token(lane, lane.last_end);
+                    continue;
+                }
+            }
+
+            if (next_input == inputs.size())
+                return false;
+            take_input(lane);
+        }
+    };
+    // The last lane takes the place of a lane without input
+    const auto settle_or_remove = [&](Index i) {
+        if (not settle(lanes[i]))
+            lanes[i] = lanes[--lane_count];
+    };
+
+    while (lane_count < m_lane_count and next_input < inputs.size()) {
+        take_input(lanes[lane_count++]);
+        settle_or_remove(lane_count - 1);
+    }
+
+    while (lane_count > 0) {
+        u32 unsettled = 0;
+        for (Index i = 0; i < lane_count; ++i) {
+            auto &lane = lanes[i];
+            const auto next =
+                transitions[*lane.position + lane.state * char_count];
+            const auto is_failed = next == error_state;
+
+            // Recorded on every byte, but only kept when the DFA fails
+            auto &record = lane.records[lane.record_count];
+            record.end = lane.last_end;
+            record.type = lane.last_type;
+            lane.record_count += is_failed;
+            const auto is_error = is_failed and lane.last_type == Error;
+
+            lane.position = is_failed ? lane.last_end : lane.position + 1;
+            lane.state = is_failed ? start_state : next;
+            const auto type = accepting[lane.state];
+            const auto is_end = is_failed or type != Error;
+            lane.last_end = is_end ? lane.position : lane.last_end;
+            lane.last_type = is_end ? type : lane.last_type;
+
+            const auto is_unsettled = is_error or
+                                      lane.position == lane.end or
+                                      lane.record_count == RecordCount;
+            unsettled |= u32(is_unsettled) << i;
+        }
+        if (unsettled == 0)
+            continue;
+
+        // From the last lane on, so a removed lane is replaced by one that
+        // was settled already
+        for (auto i = lane_count; i-- > 0;) {
+            if ((unsettled & (u32(1) << i)) != 0)
+                settle_or_remove(i);
+        }
+    }
+}
+
+}  // namespace sigil
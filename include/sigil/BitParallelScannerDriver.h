@@ -0,0 +1,138 @@
+//
+// Copyright (c) 2023, Jan Sladek <keddelzz@web.de>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+//
+
+#pragma once
+
+#include <core/Either.h>
+#include <core/List.h>
+
+#include <sigil/KeywordTable.h>
+#include <sigil/ScannerDriver.h>
+#include <sigil/Specification.h>
+
+namespace sigil {
+
+// Simulates the Glushkov automaton of a small specification in a bit mask.
+// Every character arc of the token NFAs is a position, all arcs into a
+// position read the same characters. Advancing the set of active positions
+// by a byte is one table lookup per eight positions for their successors,
+// and a mask of the positions reading the byte:
+//
+//   active' = follow(active) & reads[c]
+//
+// Positions are numbered in token order, so the lowest accepting position
+// belongs to the token added first.
+class BitParallelScannerDriver final : public ScannerDriver
+{
+public:
+    constexpr static Size MaxPositions { 128 };
+
+    BitParallelScannerDriver(const BitParallelScannerDriver &) = delete;
+    BitParallelScannerDriver(BitParallelScannerDriver &&) = default;
+    BitParallelScannerDriver &operator=(const BitParallelScannerDriver &) =
+        delete;
+    BitParallelScannerDriver &operator=(BitParallelScannerDriver &&) = default;
+
+    /// Fails for specifications with more than MaxPositions positions
+    static Either<StringView, BitParallelScannerDriver> create(
+        const Specification &);
+
+    [[nodiscard]] Size position_count() const { return m_position_count; }
+
+private:
+    struct Mask
+    {
+        constexpr static Size WordCount { MaxPositions / 64 };
+
+        void set(Index position)
+        {
+            words[position / 64] |= u64(1) << (position % 64);
+        }
+        [[nodiscard]] bool is_empty() const
+        {
+            for (const auto word : words) {
+                if (word != 0)
+                    return false;
+            }
+            return true;
+        }
+        /// The lowest position in the mask, which must not be empty
+        [[nodiscard]] Index first() const;
+
+        Mask &operator|=(const Mask &other)
+        {
+            for (Index i = 0; i < WordCount; ++i) words[i] |= other.words[i];
+            return *this;
+        }
+        Mask operator&(const Mask &other) const
+        {
+            Mask result;
+            for (Index i = 0; i < WordCount; ++i)
+                result.words[i] = words[i] & other.words[i];
+            return result;
+        }
+
+        u64 words[WordCount] { 0 };
+    };
+
+    BitParallelScannerDriver(
+        List<TokenType> token_types, KeywordTable::Storage keywords);
+
+    [[nodiscard]] State start_state(Mode) const final;
+    [[nodiscard]] State error_state() const final { return ErrorState; }
+    [[nodiscard]] State next_state(State state, u8 c) const final;
+    [[nodiscard]] bool is_accepting_state(State state) const final
+    {
+        return m_step_tokens[state] != s32(SpecialTokenType::Error);
+    }
+    [[nodiscard]] bool is_error_state(State state) const final
+    {
+        return state == ErrorState;
+    }
+    [[nodiscard]] TokenType accepting_token(State state) const final
+    {
+        assert(is_accepting_state(state));
+        return m_step_tokens[state];
+    }
+    [[nodiscard]] TokenType classify_token(
+        TokenType token_type, StringView lexeme) const final
+    {
+        return m_keywords.classify(token_type, lexeme);
+    }
+
+    constexpr static State ErrorState { 0 };
+    constexpr static Size ChunkBits { 8 };
+    constexpr static Size ChunkSize { 1 << ChunkBits };
+
+    [[nodiscard]] Mask follow(const Mask &) const;
+    /// Records the token accepted after the next step
+    State add_step(TokenType) const;
+
+    List<TokenType> m_token_types;
+    KeywordTable::Storage m_keyword_storage;
+    KeywordTable m_keywords;
+
+    Size m_position_count { 0 };
+    /// The successors of any combination of the eight positions of a chunk,
+    /// indexed by chunk * ChunkSize + the chunk's bits
+    List<Mask> m_follow;
+    /// Positions reading a byte, by byte
+    List<Mask> m_reads;
+    Mask m_accepting;
+    List<Index> m_position_tokens;
+    /// Positions reached by the first byte of a token, by mode
+    List<Mask> m_mode_first;
+    /// Tokens accepting the empty string, by mode
+    List<TokenType> m_mode_empty_tokens;
+
+    mutable Mode m_mode { 0 };
+    mutable Mask m_active;
+    /// The accepted token type per step of the current token, the first step
+    /// is the start of the token
+    mutable List<TokenType> m_step_tokens;
+};
+
+}  // namespace sigil
@@ -14,7 +14,8 @@
 
 namespace sigil {
 
-// @TODO: Also support non-ascii characters
+// Set of bytes. Non-ascii characters are represented by CodePointSet and
+// lowered to UTF-8 byte sequences, see CodePoints.
 
 class CharSet
 {
@@ -36,6 +37,8 @@ public:
     void set(u8, bool);
     void set(u8 first, u8 last, bool);
     void negate();
+    /// Add the other case of every contained ascii letter
+    void fold_case();
 
     bool operator==(const CharSet &other) const;
     bool operator!=(const CharSet &other) const { return not(*this == other); }
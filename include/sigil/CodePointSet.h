@@ -0,0 +1,96 @@
+//
+// Copyright (c) 2023, Jan Sladek <keddelzz@web.de>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+//
+
+#pragma once
+
+#include <core/Either.h>
+#include <core/Formatter.h>
+#include <core/List.h>
+#include <core/StringView.h>
+#include <core/Types.h>
+
+namespace sigil {
+
+// Set of Unicode code points as sorted, disjoint and non-adjacent ranges.
+// Unlike CharSet it is never materialized as a bitmap, which keeps classes
+// like \p{L} at a few hundred ranges.
+class CodePointSet
+{
+public:
+    struct Range
+    {
+        u32 first { 0 };
+        u32 last { 0 };
+
+        bool operator==(const Range &other) const
+        {
+            return first == other.first and last == other.last;
+        }
+    };
+
+    // Sequence of byte ranges, matching the UTF-8 encodings of a code point
+    // range, e.g. [D0-D3][80-BF]
+    struct Utf8Sequence
+    {
+        u8 length { 0 };
+        u8 first[4] { 0 };
+        u8 last[4] { 0 };
+    };
+
+    constexpr static u32 Last { 0x10FFFF };
+    constexpr static u32 FirstSurrogate { 0xD800 };
+    constexpr static u32 LastSurrogate { 0xDFFF };
+
+    CodePointSet() = default;
+    explicit CodePointSet(u32 c)
+        : CodePointSet(c, c)
+    {
+    }
+    CodePointSet(u32 first, u32 last);
+
+    /// General categories (L, Lu, Ll, M, N, Nd, P, S, Z), Any and ASCII
+    static Either<StringView, CodePointSet> unicode_property(StringView name);
+
+    [[nodiscard]] bool contains(u32) const;
+    [[nodiscard]] bool is_empty() const { return m_ranges.is_empty(); }
+    [[nodiscard]] bool non_empty() const { return not is_empty(); }
+    [[nodiscard]] const List<Range> &ranges() const { return m_ranges; }
+
+    void add(u32 first, u32 last);
+    /// Complement with respect to all Unicode scalar values
+    void negate();
+    /// Add the other case of every contained ascii letter
+    void fold_case();
+
+    bool operator==(const CodePointSet &other) const;
+    bool operator!=(const CodePointSet &other) const
+    {
+        return not(*this == other);
+    }
+
+    CodePointSet operator~() const;
+    CodePointSet operator|(const CodePointSet &other) const;
+    CodePointSet &operator|=(const CodePointSet &other);
+
+    /// Surrogates are not encodable and thus never part of a sequence
+    [[nodiscard]] List<Utf8Sequence> utf8_sequences() const;
+
+private:
+    List<Range> m_ranges;
+};
+
+}  // namespace sigil
+
+namespace core {
+
+template<>
+class Formatter<sigil::CodePointSet>
+{
+public:
+    static void format(StringBuilder &, const sigil::CodePointSet &);
+};
+
+}  // namespace core
@@ -0,0 +1,41 @@
+//
+// Copyright (c) 2023, Jan Sladek <keddelzz@web.de>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+//
+
+#pragma once
+
+#include <core/Either.h>
+#include <core/StringView.h>
+
+#include <sigil/Specification.h>
+#include <sigil/StaticTableFile.h>
+
+namespace sigil {
+
+// Content-addressed directory of compiled tables. Entries are named after
+// Specification::hash(), so specifications compiled before (by any process
+// on any host sharing the directory) are mapped instead of recompiled. The
+// hash is stored in the entry as well, an entry of another specification is
+// recompiled.
+class CompileCache
+{
+public:
+    explicit CompileCache(StringView directory);
+
+    /// Specifications which are not hashable are compiled into memory
+    Either<StringView, StaticTableFile> load_or_compile(const Specification &);
+
+    /// Calls of load_or_compile which mapped an existing entry
+    [[nodiscard]] Size hit_count() const { return m_hit_count; }
+    /// Calls of load_or_compile which compiled the specification
+    [[nodiscard]] Size compile_count() const { return m_compile_count; }
+
+private:
+    StringView m_directory;
+    Size m_hit_count { 0 };
+    Size m_compile_count { 0 };
+};
+
+}  // namespace sigil
@@ -0,0 +1,134 @@
+//
+// Copyright (c) 2023, Jan Sladek <keddelzz@web.de>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+//
+
+#pragma once
+
+#include <core/Arena.h>
+#include <core/List.h>
+#include <core/Map.h>
+#include <core/Set.h>
+
+#include <sigil/CharSet.h>
+#include <sigil/Dfa.h>
+#include <sigil/Nfa.h>
+#include <sigil/Specification.h>
+
+namespace sigil {
+
+struct NfaState
+{
+    nfa::Automaton *nfa { nullptr };
+    nfa::State *state { nullptr };
+
+    bool operator==(const NfaState &other) const
+    {
+        return nfa == other.nfa and state == other.state;
+    }
+};
+
+/// The states themselves, and the states reachable from them by epsilon arcs
+Set<NfaState> reachable_by_epsilon(const Set<NfaState> &);
+/// The states reachable from the states by a single arc reading c
+Set<NfaState> reachable_by_char(const Set<NfaState> &, u8 c);
+
+// Token automata and subset construction results of earlier compiles, passed
+// to Grammar::compile when a specification is recompiled after adding or
+// removing tokens. Unchanged tokens keep their automaton, and DFA states made
+// up of NFA states of unchanged tokens keep their successors, so only states
+// involving added or removed tokens are determinized again.
+//
+// Only construction is memoized. A recompile still visits every DFA state,
+// creates the DFA and its arcs again and the table drivers build their
+// tables from the whole DFA, so that part takes time in proportion to the
+// grammar, not to the change.
+//
+// Automata of removed tokens stay in the memo until more than half of it is
+// unused, the next compile then starts over.
+class CompileMemo
+{
+public:
+    struct DeterminizedState;
+
+    struct Successor
+    {
+        DeterminizedState *target { nullptr };
+        CharSet char_set;
+    };
+
+    struct DeterminizedState
+    {
+        explicit DeterminizedState(Set<NfaState> nfa_states)
+            : nfa_states(std::move(nfa_states))
+        {
+        }
+
+        Set<NfaState> nfa_states;
+        /// Valid across compiles, only depends on the automata in nfa_states
+        List<Successor> successors;
+        bool expanded { false };
+        /// Another state whose NFA states have the same digest
+        DeterminizedState *next { nullptr };
+
+        /// Only valid within the compile numbered compile
+        u32 compile { 0 };
+        dfa::State *dfa_state { nullptr };
+        bool queued { false };
+    };
+
+    CompileMemo() = default;
+    CompileMemo(const CompileMemo &) = delete;
+    CompileMemo(CompileMemo &&) = default;
+    CompileMemo &operator=(const CompileMemo &) = delete;
+    CompileMemo &operator=(CompileMemo &&) = default;
+
+    /// Forget all earlier compiles
+    void clear();
+
+    /// Called by Grammar::compile, drops the memo if it is mostly unused
+    void begin_compile();
+    core::Arena &arena() { return m_arena; }
+
+    /// The automaton of an equal token of an earlier compile under the same
+    /// repetition limit, which is not used by another token of this compile
+    /// yet
+    nfa::Automaton *take_nfa(
+        const Specification::TokenSpec &, Size repetition_limit);
+    /// Moves the automaton into the memo, keyed by the token and everything
+    /// else its construction depends on
+    nfa::Automaton *add_nfa(
+        const Specification::TokenSpec &,
+        Size repetition_limit,
+        nfa::Automaton);
+
+    /// The state of distinct NFA states. Successors are kept from earlier
+    /// compiles, the DFA state is not.
+    DeterminizedState *state(const List<NfaState> &);
+    /// Resets the DFA state of a state from an earlier compile
+    void use(DeterminizedState *);
+
+private:
+    struct CachedNfa
+    {
+        List<u8> signature;
+        nfa::Automaton *automaton { nullptr };
+        /// Another automaton whose signature has the same digest
+        CachedNfa *next { nullptr };
+        u32 compile { 0 };
+    };
+
+    core::Arena m_arena;
+    Map<u64, CachedNfa *> m_nfas;
+    Map<u64, DeterminizedState *> m_states;
+    u32 m_compile { 0 };
+
+    Size m_nfa_count { 0 };
+    Size m_state_count { 0 };
+    /// Of the current or last compile
+    Size m_used_nfa_count { 0 };
+    Size m_used_state_count { 0 };
+};
+
+}  // namespace sigil
@@ -0,0 +1,90 @@
+//
+// Copyright (c) 2023, Jan Sladek <keddelzz@web.de>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+//
+
+#pragma once
+
+#include <chrono>
+
+#include <core/Formatter.h>
+
+#include <sigil/Types.h>
+
+namespace sigil {
+
+// Filled in by Grammar::compile and DfaTableScannerDriver::create when passed
+// in, to budget compile latency and memory of a specification
+struct CompileStatistics
+{
+    /// Wall time per phase, in microseconds. Regex parsing includes
+    /// simplification, NFA construction excludes parsing.
+    u64 parse_microseconds { 0 };
+    u64 nfa_microseconds { 0 };
+    u64 dfa_microseconds { 0 };
+    u64 table_microseconds { 0 };
+
+    Size regex_node_count { 0 };  // after simplification
+    Size nfa_state_count { 0 };
+    Size nfa_arc_count { 0 };
+    Size dfa_state_count { 0 };
+    Size dfa_arc_count { 0 };
+    /// Most NFA states making up a single DFA state
+    Size largest_nfa_state_set { 0 };
+    /// Taken from a CompileMemo instead of being built again
+    Size reused_nfa_count { 0 };
+    Size reused_dfa_state_count { 0 };
+    /// Epsilon closures computed by the subset construction, at most one per
+    /// run of bytes with the same successor
+    Size closure_count { 0 };
+
+    /// Bytes of the objects compile constructs in the grammar's arena and in
+    /// the memo, counted from the object sizes. The arenas themselves do not
+    /// report their usage, so block slack and alignment are missing.
+    Size estimated_arena_bytes { 0 };
+    /// Bytes of regex trees in the scratch arena, released by compile
+    Size scratch_bytes { 0 };
+
+    Size table_bytes { 0 };
+    Size table_transition_count { 0 };
+    /// Transitions not leading into the error state
+    Size table_live_transition_count { 0 };
+
+    [[nodiscard]] double table_density() const
+    {
+        if (table_transition_count == 0)
+            return 0.0;
+        return double(table_live_transition_count) /
+               double(table_transition_count);
+    }
+};
+
+// Adds the wall time of its scope to a phase, unless the phase is nullptr
+class PhaseTimer
+{
+public:
+    explicit PhaseTimer(u64 *microseconds);
+    ~PhaseTimer();
+    PhaseTimer(const PhaseTimer &) = delete;
+    PhaseTimer &operator=(const PhaseTimer &) = delete;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    u64 *m_microseconds { nullptr };
+    Clock::time_point m_start;
+};
+
+}  // namespace sigil
+
+namespace core {
+
+template<>
+class Formatter<sigil::CompileStatistics>
+{
+public:
+    static void format(StringBuilder &, const sigil::CompileStatistics &);
+};
+
+}  // namespace core
@@ -0,0 +1,58 @@
+//
+// Copyright (c) 2023, Jan Sladek <keddelzz@web.de>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+//
+
+#pragma once
+
+#include <core/Either.h>
+#include <core/List.h>
+#include <core/StringView.h>
+
+#include <sigil/CompileStatistics.h>
+#include <sigil/Dfa.h>
+#include <sigil/KeywordTable.h>
+#include <sigil/Specification.h>
+#include <sigil/StaticTable.h>
+
+namespace sigil {
+
+// The transition table of a grammar with its keywords, without any scan
+// state. It is never modified after creation, so one instance can be shared
+// by any number of ScanCursors on any number of threads.
+class CompiledScanner
+{
+public:
+    CompiledScanner(const CompiledScanner &) = delete;
+    CompiledScanner(CompiledScanner &&) = default;
+    CompiledScanner &operator=(const CompiledScanner &) = delete;
+    CompiledScanner &operator=(CompiledScanner &&) = default;
+
+    static CompiledScanner create(
+        const dfa::Automaton &, CompileStatistics * = nullptr);
+    static Either<StringView, CompiledScanner> create(
+        const Specification &, CompileStatistics * = nullptr);
+    /// Refers to the table instead of owning it, e.g. to a table read by
+    /// StaticTableFile, which has to outlive the scanner
+    explicit CompiledScanner(const StaticTable &);
+
+    [[nodiscard]] const StaticTable &table() const { return m_table; }
+
+private:
+    CompiledScanner(
+        List<State> transitions,
+        List<TokenType> accepting,
+        List<State> mode_start_states,
+        KeywordTable::Storage keywords,
+        StaticTable table);
+
+    List<State> m_transitions;
+    List<TokenType> m_accepting;
+    List<State> m_mode_start_states;
+    KeywordTable::Storage m_keywords;
+    /// Views the lists above, unless the table is owned by someone else
+    StaticTable m_table;
+};
+
+}  // namespace sigil
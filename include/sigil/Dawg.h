@@ -0,0 +1,68 @@
+//
+// Copyright (c) 2023, Jan Sladek <keddelzz@web.de>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+//
+
+#pragma once
+
+#include <core/List.h>
+#include <core/StringView.h>
+
+#include <sigil/Nfa.h>
+
+namespace sigil {
+
+// Minimal deterministic acyclic automaton of a literal dictionary, built
+// incrementally (Daciuk et al., "Incremental Construction of Minimal Acyclic
+// Finite-State Automata"). Only the path of the last added literal is kept
+// unminimized, every other state is already unique in the register.
+class Dawg
+{
+public:
+    Dawg();
+
+    /// Literals have to be added in ascending byte order, repeating the last
+    /// literal has no effect
+    void add(StringView literal);
+    /// Minimize the remaining path, no literals can be added afterwards
+    void finish();
+
+    /// Reachable states, valid after finish()
+    [[nodiscard]] Size state_count() const;
+
+    /// Add the dictionary as a deterministic component with a single start
+    /// state and accepting states for all literals
+    void create_nfa(nfa::Automaton &) const;
+
+private:
+    struct Edge
+    {
+        u8 c { 0 };
+        Index target { 0 };
+    };
+
+    struct Node
+    {
+        List<Edge> edges;  // ascending by c
+        bool accepting { false };
+    };
+
+    [[nodiscard]] u64 node_hash(Index node) const;
+    [[nodiscard]] bool equivalent(Index, Index) const;
+    void replace_or_register(Index node);
+    Index find_or_register(Index node);
+    void grow_register();
+
+    template<typename Callback>
+    void foreach_reachable(Callback) const;
+
+    List<Node> m_nodes;
+    List<Index> m_register;  // open addressing, 0 is empty (root is never)
+    Size m_register_count { 0 };
+    List<u8> m_last_literal;
+    Size m_literal_count { 0 };
+    bool m_finished { false };
+};
+
+}  // namespace sigil
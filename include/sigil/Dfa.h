@@ -11,6 +11,8 @@
 #include <core/List.h>
 
 #include <sigil/CharSet.h>
+#include <sigil/KeywordTable.h>
+#include <sigil/Types.h>
 
 namespace sigil::dfa {
 
@@ -63,6 +65,11 @@ public:
 
     State *create_state();
     Arc *create_arc(State *origin, State *target, CharSet char_set = CharSet());
+    /// The n-th start state added is the start state of mode n
+    void add_start_state(State *);
+    void add_keyword(Keyword);
+    /// The table built from the keywords, once they are all added
+    void set_keyword_table(KeywordTable::Storage);
 
     [[nodiscard]] constexpr const List<State *> &states() const
     {
@@ -71,8 +78,14 @@ public:
     [[nodiscard]] constexpr List<State *> &states() { return m_states; }
     [[nodiscard]] constexpr const List<Arc *> &arcs() const { return m_arcs; }
 
-    [[nodiscard]] const dfa::State *start_state() const;
+    [[nodiscard]] const dfa::State *start_state(Mode mode = 0) const;
     [[nodiscard]] const dfa::State *error_state() const;
+    [[nodiscard]] Size mode_count() const { return m_start_states.size(); }
+    [[nodiscard]] const List<Keyword> &keywords() const { return m_keywords; }
+    [[nodiscard]] const KeywordTable::Storage &keyword_table() const
+    {
+        return m_keyword_table;
+    }
 
 private:
     core::Arena &arena() { return *m_arena; }
@@ -80,6 +93,9 @@ private:
     core::Arena *m_arena { nullptr };
     List<State *> m_states;
     List<Arc *> m_arcs;
+    List<State *> m_start_states;
+    List<Keyword> m_keywords;
+    KeywordTable::Storage m_keyword_table;
 };
 
 }  // namespace sigil::dfa
@@ -17,12 +17,14 @@ public:
     explicit DfaScannerDriver(const dfa::Automaton &dfa);
 
 private:
-    [[nodiscard]] State start_state() const final;
+    [[nodiscard]] State start_state(Mode) const final;
     [[nodiscard]] State error_state() const final;
     [[nodiscard]] State next_state(State state, u8 c) const final;
     [[nodiscard]] bool is_accepting_state(State state) const final;
     [[nodiscard]] bool is_error_state(State state) const final;
     [[nodiscard]] TokenType accepting_token(State state) const final;
+    [[nodiscard]] TokenType classify_token(
+        TokenType token_type, StringView lexeme) const final;
 
     [[nodiscard]] const dfa::State *state_by_id(State) const;
     const dfa::Automaton &m_dfa;
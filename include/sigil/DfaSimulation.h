@@ -45,7 +45,8 @@ private:
     StringView m_token_name;
 };
 
-SimulationResult simulate(const sigil::Grammar &, StringView source);
+SimulationResult simulate(
+    const sigil::Grammar &, StringView source, Mode mode = 0);
 
 }  // namespace sigil::dfa
 
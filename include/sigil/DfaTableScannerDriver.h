@@ -6,6 +6,8 @@
 
 #pragma once
 
+#include <sigil/CompileStatistics.h>
+#include <sigil/CompiledScanner.h>
 #include <sigil/Dfa.h>
 #include <sigil/ScannerDriver.h>
 #include <sigil/StaticTableScannerDriver.h>
@@ -22,16 +24,21 @@ public:
     DfaTableScannerDriver &operator=(DfaTableScannerDriver &&) = default;
 
     // @TODO: Option<DfaTableScannerDriver> for error handling
-    static DfaTableScannerDriver create(const dfa::Automaton &);
+    static DfaTableScannerDriver create(
+        const dfa::Automaton &, CompileStatistics * = nullptr);
 
     [[nodiscard]] StaticTable static_table() const
     {
         return m_underlying.static_table();
     }
+    [[nodiscard]] const CompiledScanner &compiled_scanner() const
+    {
+        return m_compiled;
+    }
 
-    [[nodiscard]] State start_state() const final
+    [[nodiscard]] State start_state(Mode mode) const final
     {
-        return m_underlying.start_state();
+        return m_underlying.start_state(mode);
     }
     [[nodiscard]] State error_state() const final
     {
@@ -53,21 +60,16 @@ public:
     {
         return m_underlying.accepting_token(state);
     }
-
-private:
-    DfaTableScannerDriver(
-        List<State> transitions,
-        List<TokenType> accepting,
-        StaticTableScannerDriver underlying);
-
-    inline static Index table_index(State state, u8 c)
+    [[nodiscard]] TokenType classify_token(
+        TokenType token_type, StringView lexeme) const final
     {
-        constexpr auto char_count = std::numeric_limits<u8>::max() + 1;
-        return c + state * char_count;
+        return m_underlying.classify_token(token_type, lexeme);
     }
 
-    List<State> m_transitions;
-    List<TokenType> m_accepting;
+private:
+    explicit DfaTableScannerDriver(CompiledScanner);
+
+    CompiledScanner m_compiled;
     StaticTableScannerDriver m_underlying;
 };
 
@@ -11,11 +11,31 @@
 #include <core/List.h>
 #include <core/StringView.h>
 
+#include <sigil/CompileStatistics.h>
 #include <sigil/Dfa.h>
 #include <sigil/Specification.h>
 
 namespace sigil {
 
+class CompileMemo;
+
+namespace nfa {
+class Automaton;
+}
+
+struct CompileError
+{
+    enum class Kind : u8
+    {
+        Invalid,
+        /// The DFA outgrew the budget set by Specification::set_dfa_budget
+        DfaBudgetExceeded,
+    };
+
+    Kind kind { Kind::Invalid };
+    StringView message;
+};
+
 class Grammar
 {
 public:
@@ -26,7 +46,27 @@ public:
     Grammar &operator=(const Grammar &) = delete;
     Grammar &operator=(Grammar &&) = default;
 
-    static Either<StringView, Grammar> compile(const Specification &);
+    static Either<StringView, Grammar> compile(
+        const Specification &, CompileStatistics * = nullptr);
+    /// Reuses the automata of earlier compiles with the same memo, but builds
+    /// the whole DFA, see CompileMemo
+    static Either<StringView, Grammar> compile(
+        const Specification &, CompileMemo &, CompileStatistics * = nullptr);
+    /// Like compile, telling a DFA over its budget apart from invalid
+    /// specifications
+    static Either<CompileError, Grammar> compile_checked(
+        const Specification &, CompileStatistics * = nullptr);
+    static Either<CompileError, Grammar> compile_checked(
+        const Specification &, CompileMemo &, CompileStatistics * = nullptr);
+    /// The message of a CompileError::Kind::DfaBudgetExceeded error
+    static StringView dfa_budget_exceeded()
+    {
+        return "DFA exceeds its budget"sv;
+    }
+    /// The automata of the tokens in order, owned by the memo, without
+    /// constructing the DFA
+    static Either<StringView, List<nfa::Automaton *>> compile_nfas(
+        const Specification &, CompileMemo &);
 
     core::Arena &arena() { return m_arena; }
     [[nodiscard]] const List<StringView> &token_names() const
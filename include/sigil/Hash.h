@@ -0,0 +1,46 @@
+//
+// Copyright (c) 2023, Jan Sladek <keddelzz@web.de>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+//
+
+#pragma once
+
+#include <core/StringView.h>
+#include <core/Types.h>
+
+namespace sigil {
+
+// 64-bit FNV-1a, used for on-disk checksums and cache keys. Integers are fed
+// in little-endian order, so digests are stable across hosts.
+class Hasher
+{
+public:
+    void add_bytes(const void *data, Size size)
+    {
+        const auto *p = reinterpret_cast<const u8 *>(data);
+        for (Index i = 0; i < size; ++i) {
+            m_hash ^= p[i];
+            m_hash *= 0x100000001B3ull;
+        }
+    }
+    void add_u64(u64 value)
+    {
+        for (auto i = 0; i < 8; ++i) {
+            const auto byte = u8(value >> (8 * i));
+            add_bytes(&byte, 1);
+        }
+    }
+    void add_string(StringView string)
+    {
+        add_u64(string.size());
+        add_bytes(string.data(), string.size());
+    }
+
+    [[nodiscard]] u64 digest() const { return m_hash; }
+
+private:
+    u64 m_hash { 0xCBF29CE484222325ull };
+};
+
+}  // namespace sigil
@@ -0,0 +1,84 @@
+//
+// Copyright (c) 2023, Jan Sladek <keddelzz@web.de>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+//
+
+#pragma once
+
+#include <core/List.h>
+#include <core/StringView.h>
+
+#include <sigil/FilePosition.h>
+#include <sigil/ScannerDriver.h>
+#include <sigil/Token.h>
+
+namespace sigil {
+
+struct TextEdit
+{
+    u64 offset { 0 };
+    u64 removed_length { 0 };
+    u64 inserted_length { 0 };
+};
+
+// Keeps the token stream of an input up to date across edits. Scanning
+// restarts at the last token boundary before the first token whose scan read
+// edited bytes, and stops as soon as a new token ends where an old token
+// after the edit started, in the same mode. The remaining tokens are shifted.
+//
+// Modes are only replayed as far as they were recorded per token: mode
+// switches made by the user between tokens are not repeated while scanning
+// the edited part.
+class IncrementalScanner
+{
+public:
+    struct Entry
+    {
+        TokenType type { s32(SpecialTokenType::Error) };
+        u64 offset { 0 };
+        u64 length { 0 };
+        FilePosition first;
+        FilePosition end;
+        /// See ScannerDriver::scan_end
+        u64 scan_end { 0 };
+        Mode mode { 0 };
+    };
+
+    /// Tokens [first, first + removed_count) were replaced by tokens
+    /// [first, first + inserted_count)
+    struct Change
+    {
+        Index first { 0 };
+        Size removed_count { 0 };
+        Size inserted_count { 0 };
+    };
+
+    explicit IncrementalScanner(ScannerDriver &);
+
+    void scan(StringView file_path, StringView input, Mode = 0);
+    /// The input is the buffer after applying the edit
+    Change update(StringView input, TextEdit);
+
+    [[nodiscard]] Size token_count() const { return m_entries.size(); }
+    /// The stream always ends in an Eof or Error token
+    [[nodiscard]] Token token(Index) const;
+    [[nodiscard]] const List<Entry> &entries() const { return m_entries; }
+    /// Bytes read by the last scan or update
+    [[nodiscard]] u64 scanned_bytes() const { return m_scanned_bytes; }
+
+private:
+    [[nodiscard]] u64 scan_start(Index) const;
+    [[nodiscard]] FilePosition scan_start_position(Index) const;
+    /// Scan from the current position of the driver until the end of input,
+    /// or until the tokens line up with m_entries from index resync onwards
+    Index scan_until_resync(List<Entry> &, Index resync, s64 delta, u64 after);
+
+    ScannerDriver &m_driver;
+    StringView m_file_path;
+    StringView m_input;
+    List<Entry> m_entries;
+    u64 m_scanned_bytes { 0 };
+};
+
+}  // namespace sigil
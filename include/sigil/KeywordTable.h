@@ -0,0 +1,96 @@
+//
+// Copyright (c) 2023, Jan Sladek <keddelzz@web.de>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+//
+
+#pragma once
+
+#include <core/Either.h>
+#include <core/List.h>
+#include <core/StringView.h>
+
+#include <sigil/Array.h>
+#include <sigil/Types.h>
+
+namespace sigil {
+
+class Specification;
+
+struct Keyword
+{
+    StringView keyword;
+    TokenType identifier_token_type { -3 };
+    TokenType token_type { -3 };
+};
+
+// Minimal perfect hash (hash and displace) over keywords, which are
+// recognized after a token of their identifier type was scanned instead of
+// being part of the DFA. A lookup hashes the lexeme once and compares it
+// against a single slot.
+class KeywordTable
+{
+public:
+    struct Entry
+    {
+        u32 offset { 0 };  // into strings, empty slots have length 0
+        u32 length { 0 };
+        TokenType identifier_token_type { -3 };
+        TokenType token_type { -3 };
+    };
+
+    // Arrays backing a table, built at compile time
+    struct Storage
+    {
+        u64 seed { 0 };
+        List<TokenType> identifier_token_types;
+        List<u32> displacements;
+        List<Entry> entries;
+        List<char> strings;
+    };
+
+    KeywordTable() = default;
+    /// displacements and entries have to have power of two sizes
+    KeywordTable(
+        u64 seed,
+        Array<TokenType> identifier_token_types,
+        Array<u32> displacements,
+        Array<Entry> entries,
+        Array<char> strings);
+    explicit KeywordTable(const Storage &);
+
+    /// Keywords have to be unique per identifier token type
+    static Either<StringView, Storage> build(const List<Keyword> &);
+    /// The keywords of a specification
+    static Either<StringView, Storage> build(const Specification &);
+
+    static u64 hash(u64 seed, TokenType identifier_token_type, StringView);
+
+    /// The token type of the keyword, or identifier_token_type if the lexeme
+    /// is no keyword
+    [[nodiscard]] TokenType classify(
+        TokenType identifier_token_type, StringView lexeme) const;
+
+    /// The largest token type of a keyword, -1 without keywords
+    [[nodiscard]] TokenType max_token_type() const;
+
+    [[nodiscard]] bool is_empty() const { return m_entries.is_empty(); }
+    [[nodiscard]] bool non_empty() const { return not is_empty(); }
+    [[nodiscard]] u64 seed() const { return m_seed; }
+    [[nodiscard]] Array<TokenType> identifier_token_types() const
+    {
+        return m_identifier_token_types;
+    }
+    [[nodiscard]] Array<u32> displacements() const { return m_displacements; }
+    [[nodiscard]] Array<Entry> entries() const { return m_entries; }
+    [[nodiscard]] Array<char> strings() const { return m_strings; }
+
+private:
+    u64 m_seed { 0 };
+    Array<TokenType> m_identifier_token_types;
+    Array<u32> m_displacements;
+    Array<Entry> m_entries;
+    Array<char> m_strings;
+};
+
+}  // namespace sigil
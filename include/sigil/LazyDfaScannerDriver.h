@@ -0,0 +1,108 @@
+//
+// Copyright (c) 2023, Jan Sladek <keddelzz@web.de>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+//
+
+#pragma once
+
+#include <core/Either.h>
+#include <core/List.h>
+#include <core/Map.h>
+#include <core/Set.h>
+
+#include <sigil/CompileMemo.h>
+#include <sigil/KeywordTable.h>
+#include <sigil/ScannerDriver.h>
+#include <sigil/Specification.h>
+
+namespace sigil {
+
+// Scans with the token NFAs of a specification, determinizing DFA states on
+// demand. Discovered states and their transitions are cached, once the cache
+// holds more than its capacity of states it is flushed. Only states the input
+// visits are ever constructed, so specifications whose full DFA explodes can
+// still be scanned at DFA speed once the cache is warm.
+//
+// Flushing waits for the next token: state ids of the token being scanned
+// stay valid, so a single token may grow the cache beyond its capacity.
+class LazyDfaScannerDriver final : public ScannerDriver
+{
+public:
+    constexpr static Size DefaultCacheCapacity { 4096 };
+
+    LazyDfaScannerDriver(const LazyDfaScannerDriver &) = delete;
+    LazyDfaScannerDriver(LazyDfaScannerDriver &&) = default;
+    LazyDfaScannerDriver &operator=(const LazyDfaScannerDriver &) = delete;
+    LazyDfaScannerDriver &operator=(LazyDfaScannerDriver &&) = default;
+
+    static Either<StringView, LazyDfaScannerDriver> create(
+        const Specification &, Size cache_capacity = DefaultCacheCapacity);
+
+    [[nodiscard]] Size cached_state_count() const { return m_states.size(); }
+    [[nodiscard]] Size flush_count() const { return m_flush_count; }
+
+private:
+    LazyDfaScannerDriver(
+        CompileMemo memo,
+        List<nfa::Automaton *> nfas,
+        List<TokenType> token_types,
+        List<Set<NfaState>> mode_start_states,
+        KeywordTable::Storage keywords,
+        Size cache_capacity);
+
+    [[nodiscard]] State start_state(Mode) const final;
+    [[nodiscard]] State error_state() const final { return ErrorState; }
+    [[nodiscard]] State next_state(State state, u8 c) const final;
+    [[nodiscard]] bool is_accepting_state(State state) const final
+    {
+        return m_accepting[state] != s32(SpecialTokenType::Error);
+    }
+    [[nodiscard]] bool is_error_state(State state) const final
+    {
+        return state == ErrorState;
+    }
+    [[nodiscard]] TokenType accepting_token(State state) const final
+    {
+        assert(is_accepting_state(state));
+        return m_accepting[state];
+    }
+    [[nodiscard]] TokenType classify_token(
+        TokenType token_type, StringView lexeme) const final
+    {
+        return m_keywords.classify(token_type, lexeme);
+    }
+
+    constexpr static State ErrorState { 0 };
+    constexpr static State UnknownState { std::numeric_limits<State>::max() };
+
+    inline static Index table_index(State state, u8 c)
+    {
+        constexpr auto char_count = std::numeric_limits<u8>::max() + 1;
+        return c + state * char_count;
+    }
+
+    State create_or_get_state(const Set<NfaState> &) const;
+    void flush() const;
+
+    CompileMemo m_memo;  // owns the automata
+    List<nfa::Automaton *> m_nfas;
+    /// By token index, skipped types are replaced by SpecialTokenType::Skip
+    List<TokenType> m_token_types;
+    List<Set<NfaState>> m_mode_start_states;
+    KeywordTable::Storage m_keyword_storage;
+    KeywordTable m_keywords;
+    Size m_cache_capacity { DefaultCacheCapacity };
+
+    // The cache, filled while scanning
+    mutable Map<Set<NfaState>, State> m_state_ids;
+    mutable List<Set<NfaState>> m_states;
+    mutable List<State> m_transitions;
+    mutable List<TokenType> m_accepting;
+    /// By mode, UnknownState until the mode's start state is cached
+    mutable List<State> m_mode_start_ids;
+    mutable bool m_flush_pending { false };
+    mutable Size m_flush_count { 0 };
+};
+
+}  // namespace sigil
@@ -0,0 +1,76 @@
+//
+// Copyright (c) 2023, Jan Sladek <keddelzz@web.de>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+//
+
+#pragma once
+
+#include <limits>  // std::numeric_limits
+
+#include <core/Either.h>
+#include <core/List.h>
+#include <core/StringView.h>
+
+#include <sigil/CharSet.h>
+#include <sigil/Specification.h>
+#include <sigil/Types.h>
+
+namespace sigil {
+
+class RegExp;
+
+// Every match contains one of the literals, starting at most max_offset bytes
+// after the start of the match. Without literals, nothing is required.
+struct RequiredLiterals
+{
+    constexpr static u32 Unbounded { std::numeric_limits<u32>::max() };
+
+    [[nodiscard]] bool is_empty() const { return literals.is_empty(); }
+
+    List<List<u8>> literals;
+    u32 max_offset { Unbounded };
+};
+
+// Skips the parts of a text no token of a mode can match in, by looking for
+// the literals required by all of its tokens, e.g. "ERROR" in `ERROR: .*` or
+// "://" in `[a-z]+://[^ ]*`. A mode only gets a prefilter if every token
+// which is not skipped requires a literal at a bounded offset from its start.
+// Case-insensitive tokens and NFA tokens are never analyzed.
+class LiteralPrefilter
+{
+public:
+    /// Few enough literals to compare each of them at every candidate
+    constexpr static Size MaxLiterals { 16 };
+    constexpr static Size MaxLiteralSize { 64 };
+
+    /// Skips nothing
+    LiteralPrefilter() = default;
+
+    static Either<StringView, LiteralPrefilter> create(const Specification &);
+
+    /// The literals required by all matches of the expression
+    static RequiredLiterals required_literals(const RegExp *);
+
+    [[nodiscard]] bool is_active(Mode mode) const
+    {
+        return mode < m_modes.size() and m_modes[mode].literals.non_empty();
+    }
+    /// The first offset from `from` on a match in the mode could start at,
+    /// the size of the text if there is none
+    [[nodiscard]] Index skip(StringView text, Index from, Mode mode) const;
+
+private:
+    struct ModeLiterals
+    {
+        List<List<u8>> literals;
+        u32 max_offset { 0 };
+        CharSet first_bytes;
+        /// Literals sharing their first byte are found with memchr
+        bool has_single_first_byte { true };
+    };
+
+    List<ModeLiterals> m_modes;
+};
+
+}  // namespace sigil
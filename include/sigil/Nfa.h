@@ -69,6 +69,10 @@ public:
         return m_states;
     }
     [[nodiscard]] constexpr const List<Arc *> &arcs() const { return m_arcs; }
+    [[nodiscard]] const List<Arc *> &outgoing_arcs(const State *state) const
+    {
+        return m_outgoing_arcs[state->id];
+    }
 
     [[nodiscard]] nfa::State *start_state() const;
 
@@ -78,6 +82,7 @@ private:
     core::Arena *m_arena { nullptr };
     List<State *> m_states;
     List<Arc *> m_arcs;
+    List<List<Arc *>> m_outgoing_arcs;  // indexed by State::id
 };
 
 }  // namespace sigil::nfa
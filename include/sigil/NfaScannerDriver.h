@@ -0,0 +1,134 @@
+//
+// Copyright (c) 2023, Jan Sladek <keddelzz@web.de>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+//
+
+#pragma once
+
+#include <core/Either.h>
+#include <core/List.h>
+
+#include <sigil/CharSet.h>
+#include <sigil/CompileMemo.h>
+#include <sigil/KeywordTable.h>
+#include <sigil/ScannerDriver.h>
+#include <sigil/Specification.h>
+
+namespace sigil {
+
+// Simulates the token NFAs of a specification directly, keeping the set of
+// active NFA states in a sparse set. Nothing is determinized, so memory stays
+// linear in the size of the NFAs no matter the specification, at the cost of
+// visiting every active NFA state per byte.
+//
+// The states the driver hands out are the steps within the current token,
+// only the latest one can be advanced.
+class NfaScannerDriver final : public ScannerDriver
+{
+public:
+    NfaScannerDriver(const NfaScannerDriver &) = delete;
+    NfaScannerDriver(NfaScannerDriver &&) = default;
+    NfaScannerDriver &operator=(const NfaScannerDriver &) = delete;
+    NfaScannerDriver &operator=(NfaScannerDriver &&) = default;
+
+    static Either<StringView, NfaScannerDriver> create(const Specification &);
+
+    /// NFA states of all tokens
+    [[nodiscard]] Size nfa_state_count() const
+    {
+        return m_accepted_tokens.size();
+    }
+
+private:
+    // Set of NFA state numbers below a fixed bound, with constant time
+    // insertion, lookup and clearing
+    class SparseSet
+    {
+    public:
+        void resize(Size bound)
+        {
+            m_sparse.clear();
+            for (Index i = 0; i < bound; ++i) m_sparse.add(0);
+        }
+        [[nodiscard]] bool contains(u32 value) const
+        {
+            const auto index = m_sparse[value];
+            return index < m_dense.size() and m_dense[index] == value;
+        }
+        void add(u32 value)
+        {
+            m_sparse[value] = u32(m_dense.size());
+            m_dense.add(value);
+        }
+        void clear() { m_dense.clear(); }
+        [[nodiscard]] bool is_empty() const { return m_dense.is_empty(); }
+        [[nodiscard]] const List<u32> &values() const { return m_dense; }
+
+    private:
+        List<u32> m_dense;
+        List<u32> m_sparse;
+    };
+
+    struct CharArc
+    {
+        CharSet char_set;
+        u32 target { 0 };
+    };
+
+    NfaScannerDriver(
+        CompileMemo memo,
+        List<TokenType> token_types,
+        KeywordTable::Storage keywords);
+
+    [[nodiscard]] State start_state(Mode) const final;
+    [[nodiscard]] State error_state() const final { return ErrorState; }
+    [[nodiscard]] State next_state(State state, u8 c) const final;
+    [[nodiscard]] bool is_accepting_state(State state) const final
+    {
+        return m_step_tokens[state] != s32(SpecialTokenType::Error);
+    }
+    [[nodiscard]] bool is_error_state(State state) const final
+    {
+        return state == ErrorState;
+    }
+    [[nodiscard]] TokenType accepting_token(State state) const final
+    {
+        assert(is_accepting_state(state));
+        return m_step_tokens[state];
+    }
+    [[nodiscard]] TokenType classify_token(
+        TokenType token_type, StringView lexeme) const final
+    {
+        return m_keywords.classify(token_type, lexeme);
+    }
+
+    constexpr static State ErrorState { 0 };
+
+    /// Adds the state and the states reachable from it by epsilon arcs
+    void add_closure(SparseSet &, u32 state) const;
+    /// Records the accepted token of the current set as the next step
+    State add_step() const;
+
+    CompileMemo m_memo;  // owns the automata
+    List<TokenType> m_token_types;
+    KeywordTable::Storage m_keyword_storage;
+    KeywordTable m_keywords;
+
+    // NFA states of all tokens are numbered consecutively. Arcs of state s
+    // are [offsets[s], offsets[s + 1]).
+    /// The token index of accepting states, the token count otherwise
+    List<Index> m_accepted_tokens;
+    List<Index> m_char_arc_offsets;
+    List<CharArc> m_char_arcs;
+    List<Index> m_epsilon_arc_offsets;
+    List<u32> m_epsilon_arcs;
+    List<List<u32>> m_mode_start_states;
+
+    mutable SparseSet m_current;
+    mutable SparseSet m_next;
+    /// The accepted token type per step of the current token
+    mutable List<TokenType> m_step_tokens;
+};
+
+}  // namespace sigil
@@ -6,10 +6,13 @@
 
 #pragma once
 
+#include <limits>
+
 #include <core/Formatter.h>
 #include <core/Types.h>
 
 #include <sigil/CharSet.h>
+#include <sigil/CodePointSet.h>
 
 namespace sigil {
 
@@ -25,6 +28,8 @@ public:
         Kleene,
         PositiveKleene,
         Optional,
+        CodePoints,
+        Repetition,
     };
 
     [[nodiscard]] Type type() const { return m_type; }
@@ -47,6 +52,21 @@ private:
     CharSet m_char_set;
 };
 
+// Non-ascii code points, lowered to UTF-8 byte sequences by the compiler
+class CodePoints final : public RegExp
+{
+public:
+    explicit CodePoints(CodePointSet);
+
+    [[nodiscard]] const CodePointSet &code_points() const
+    {
+        return m_code_points;
+    }
+
+private:
+    CodePointSet m_code_points;
+};
+
 class Alternative final : public RegExp
 {
 public:
@@ -106,6 +126,25 @@ private:
     RegExp *m_exp { nullptr };
 };
 
+// exp{min}, exp{min,} or exp{min,max}
+class Repetition final : public RegExp
+{
+public:
+    constexpr static u32 Unbounded { std::numeric_limits<u32>::max() };
+
+    Repetition(RegExp *exp, u32 min, u32 max);
+
+    [[nodiscard]] const RegExp *exp() const { return m_exp; }
+    [[nodiscard]] u32 min() const { return m_min; }
+    [[nodiscard]] u32 max() const { return m_max; }
+    [[nodiscard]] bool is_bounded() const { return m_max != Unbounded; }
+
+private:
+    RegExp *m_exp { nullptr };
+    u32 m_min { 0 };
+    u32 m_max { 0 };
+};
+
 }  // namespace sigil
 
 namespace core {
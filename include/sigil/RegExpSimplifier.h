@@ -0,0 +1,61 @@
+//
+// Copyright (c) 2023, Jan Sladek <keddelzz@web.de>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+//
+
+#pragma once
+
+#include <core/Arena.h>
+#include <core/List.h>
+
+#include <sigil/RegExp.h>
+
+namespace sigil {
+
+// Rewrites parsed regular expressions into smaller, canonical trees before
+// Thompson construction:
+//  - alternatives are flattened, their atoms (and code points) merged into
+//    a single set and duplicates dropped, e.g. a|b|c|a becomes [a-c]
+//  - concatenations are flattened into one right-nested chain
+//  - nested quantifiers collapse, e.g. (x*)*, x?* and (x+)? become x*
+//  - trivial repetitions become quantifiers, e.g. x{0,} becomes x*
+// Results are hash-consed: structurally equal subtrees are the same object,
+// across all expressions simplified with one instance. The sharing ends at
+// the tree, Thompson construction still creates states for every occurrence
+// of a subtree, since its fragments are linked into their surroundings.
+class RegExpSimplifier
+{
+public:
+    explicit RegExpSimplifier(core::Arena &);
+
+    RegExp *simplify(const RegExp *);
+
+    /// Distinct nodes created so far
+    [[nodiscard]] Size node_count() const { return m_node_count; }
+    /// Bytes constructed in the arena, including duplicates that were dropped
+    [[nodiscard]] Size allocated_bytes() const { return m_allocated_bytes; }
+
+private:
+    template<typename T, typename... Args>
+    RegExp *create(Args &&...args)
+    {
+        m_allocated_bytes += sizeof(T);
+        return intern(m_arena.construct<T>(std::forward<Args>(args)...));
+    }
+    RegExp *intern(RegExp *);
+
+    RegExp *create_alternative(const RegExp *);
+    RegExp *create_concatenation(const RegExp *);
+    RegExp *create_kleene(RegExp *);
+    RegExp *create_positive_kleene(RegExp *);
+    RegExp *create_optional(RegExp *);
+    RegExp *create_repetition(RegExp *, u32 min, u32 max);
+
+    core::Arena &m_arena;
+    List<RegExp *> m_nodes;  // open addressing
+    Size m_node_count { 0 };
+    Size m_allocated_bytes { 0 };
+};
+
+}  // namespace sigil
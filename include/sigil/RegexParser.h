@@ -12,6 +12,8 @@
 #include <core/StringView.h>
 
 #include <sigil/CharSet.h>
+#include <sigil/CodePointSet.h>
+#include <sigil/Specification.h>
 
 namespace sigil {
 
@@ -21,19 +23,27 @@ class RegexParser
 {
 public:
     explicit RegexParser(core::Arena &arena);
-    void initialize(StringView input);
+    /// Case-insensitive expressions match ascii letters in either case
+    void initialize(
+        StringView input,
+        CaseSensitivity case_sensitivity = CaseSensitivity::Sensitive);
     Either<StringView, RegExp *> parse();
 
+    /// Bytes of all expressions constructed in the arena so far
+    [[nodiscard]] Size allocated_bytes() const { return m_allocated_bytes; }
+
 private:
     template<typename T, typename... Args>
     inline RegExp *create_reg_exp(Args &&...args)
     {
+        m_allocated_bytes += sizeof(T);
         return m_arena.construct<T>(std::forward<Args>(args)...);
     }
 
     RegExp *parse_alternative();
     RegExp *parse_concatenation();
     RegExp *parse_postfix();
+    RegExp *parse_repetition(RegExp *);
     RegExp *parse_atom();
 
     RegExp *parse_nested_atom();
@@ -45,6 +55,20 @@ private:
     /// Parse single atom in a class, which may be a range
     CharSet parse_top_level_chars();
 
+    /// {m}, {m,} or {m,n}, any other brace is a literal
+    [[nodiscard]] bool can_peek_repetition() const;
+    /// \u{hex}, \p{Property} or \P{Property}
+    [[nodiscard]] bool can_peek_code_point_escape() const;
+    bool parse_code_point_escape(CodePointSet &);
+    /// Parse code point escape in a class, which may be a range
+    bool parse_class_code_points(CodePointSet &);
+    RegExp *create_atom(CharSet);
+    RegExp *create_code_points(CodePointSet);
+    /// The complement of the set, folded first so that case-insensitive
+    /// classes exclude both cases of a letter
+    [[nodiscard]] CharSet negated(CharSet) const;
+    [[nodiscard]] CodePointSet negated(CodePointSet) const;
+
     // @TODO: This might be a bit nicer when using Option<char>
     [[nodiscard]] bool can_peek() const;
     u8 peek();
@@ -53,6 +77,8 @@ private:
     core::Arena &m_arena;
     s64 m_offset { -1 };
     StringView m_input;
+    Size m_allocated_bytes { 0 };
+    bool m_fold_case { false };
 };
 
 }  // namespace sigil
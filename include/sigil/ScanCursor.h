@@ -0,0 +1,71 @@
+//
+// Copyright (c) 2023, Jan Sladek <keddelzz@web.de>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+//
+
+#pragma once
+
+#include <core/StringView.h>
+
+#include <sigil/CompiledScanner.h>
+#include <sigil/FileRange.h>
+#include <sigil/SpecialTokenType.h>
+#include <sigil/Token.h>
+#include <sigil/Types.h>
+
+namespace sigil {
+
+// The scan state of one input over a shared CompiledScanner: the position
+// and the modes, without a lookahead buffer. Creating a cursor allocates
+// nothing, so every request can scan with its own cursor.
+class ScanCursor
+{
+public:
+    /// The scanner and the input have to outlive the cursor
+    ScanCursor(
+        const CompiledScanner &, StringView file_path, StringView input);
+
+    /// The next token, an Eof token at the end of the input. After an Error
+    /// token, the cursor stays at the error.
+    Token next();
+
+    /// Offset of the next token
+    [[nodiscard]] u64 offset() const { return m_current.offset; }
+
+    /// Like ScannerDriver, modes can be switched in between tokens
+    [[nodiscard]] Mode mode() const { return m_mode_stack[m_mode_depth - 1]; }
+    void set_mode(Mode mode) { m_mode_stack[m_mode_depth - 1] = mode; }
+    void push_mode(Mode mode)
+    {
+        assert(m_mode_depth < ModeStackDepth);
+        m_mode_stack[m_mode_depth++] = mode;
+    }
+    void pop_mode()
+    {
+        assert(m_mode_depth > 1);
+        --m_mode_depth;
+    }
+
+private:
+    struct Position
+    {
+        u64 offset { 0 };
+        u64 line { 0 };
+        u64 column { 0 };
+    };
+
+    [[nodiscard]] FileRange range(
+        const Position &first, const Position &last) const;
+
+    const StaticTable *m_table { nullptr };
+    StringView m_file_path;
+    StringView m_input;
+    Position m_current;
+    bool m_failed { false };
+
+    Mode m_mode_stack[ModeStackDepth] { 0 };
+    Size m_mode_depth { 1 };
+};
+
+}  // namespace sigil
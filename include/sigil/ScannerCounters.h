@@ -0,0 +1,93 @@
+//
+// Copyright (c) 2023, Jan Sladek <keddelzz@web.de>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+//
+
+#pragma once
+
+#include <core/List.h>
+
+#include <sigil/Types.h>
+
+namespace sigil {
+
+class KeywordTable;
+
+// Runtime counters of a scanner driver, for capacity planning. They are only
+// collected when built with SIGIL_SCANNER_COUNTERS, the per-state histogram
+// only with SIGIL_SCANNER_STATE_HISTOGRAM in addition.
+class ScannerCounters
+{
+public:
+    /// Token types have to be less than token_type_count
+    explicit ScannerCounters(Size token_type_count = 0);
+
+    /// One more than the largest of the token types and keyword token types
+    static Size token_type_count(
+        const List<TokenType> &token_types, const KeywordTable &keywords);
+
+    void reset();
+
+    /// Bytes fed to the automaton, including bytes scanned again
+    [[nodiscard]] u64 bytes_scanned() const { return m_bytes_scanned; }
+    /// Bytes read beyond the longest match, which are scanned again as part
+    /// of the next token
+    [[nodiscard]] u64 bytes_rescanned() const { return m_bytes_rescanned; }
+    [[nodiscard]] u64 error_count() const { return m_error_count; }
+    /// Tokens returned to the user, skipped tokens are not emitted
+    [[nodiscard]] u64 token_count(TokenType) const;
+    /// Transitions into the state, empty without the histogram
+    [[nodiscard]] const List<u64> &state_visits() const
+    {
+        return m_state_visits;
+    }
+
+    inline void count_scan(u64 scanned, u64 rescanned)
+    {
+        m_bytes_scanned += scanned;
+        m_bytes_rescanned += rescanned;
+    }
+    inline void count_token(TokenType token_type)
+    {
+        if (token_type < 0)
+            return;
+        assert(Size(token_type) < m_token_counts.size());
+        ++m_token_counts[token_type];
+    }
+    inline void count_error() { ++m_error_count; }
+    inline void visit_state([[maybe_unused]] State state)
+    {
+#ifdef SIGIL_SCANNER_STATE_HISTOGRAM
+        while (m_state_visits.size() <= state) m_state_visits.add(0);
+        ++m_state_visits[state];
+#endif
+    }
+
+private:
+    u64 m_bytes_scanned { 0 };
+    u64 m_bytes_rescanned { 0 };
+    u64 m_error_count { 0 };
+    List<u64> m_token_counts;  // indexed by token type
+    List<u64> m_state_visits;  // indexed by state
+};
+
+// Stand-in when counters are disabled, all calls compile to nothing
+struct NoScannerCounters
+{
+    explicit NoScannerCounters(Size = 0) {}
+
+    void reset() {}
+    void count_scan(u64, u64) {}
+    void count_token(TokenType) {}
+    void count_error() {}
+    void visit_state(State) {}
+};
+
+#ifdef SIGIL_SCANNER_COUNTERS
+using ScannerInstrumentation = ScannerCounters;
+#else
+using ScannerInstrumentation = NoScannerCounters;
+#endif
+
+}  // namespace sigil
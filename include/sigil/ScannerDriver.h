@@ -6,24 +6,43 @@
 
 #pragma once
 
+#include <memory>
+
+#include <core/Either.h>
 #include <core/RingBuffer.h>
 #include <core/StringView.h>
 
 #include <sigil/FileRange.h>
+#include <sigil/ScannerCounters.h>
 #include <sigil/SpecialTokenType.h>
 #include <sigil/Token.h>
 #include <sigil/Types.h>
 
 namespace sigil {
 
+class Specification;
+struct CompileStatistics;
+
 // @TODO: generate scanner driver implementation
 class ScannerDriver
 {
 public:
-    ScannerDriver() = default;
     virtual ~ScannerDriver() = default;
 
+    /// A DfaTableScannerDriver, or a NfaScannerDriver if the DFA exceeds the
+    /// budget of the specification
+    static Either<StringView, std::unique_ptr<ScannerDriver>> create(
+        const Specification &, CompileStatistics * = nullptr);
+
     virtual void initialize(StringView file_path, StringView input);
+    /// Start scanning at a token boundary within the input instead of at its
+    /// beginning, in the given mode
+    void resume(
+        StringView file_path,
+        StringView input,
+        u64 offset,
+        FilePosition position,
+        Mode mode);
 
     inline bool can_lookahead(Index offset = 0)
     {
@@ -54,6 +73,31 @@ public:
     // @FIXME: Switching to the lookahead api makes the scanner slower
     bool has_next();
     Token next();
+    /// Offset after the last byte read to scan the token buffered by
+    /// has_next(), which includes bytes read beyond the token
+    [[nodiscard]] u64 scan_end() const { return m_scan_end; }
+
+    /// The mode selects the start state for the next token. Modes can only
+    /// be switched between tokens, i.e. not while tokens are buffered by
+    /// has_next() or the lookahead api.
+    [[nodiscard]] Mode mode() const { return m_mode_stack[m_mode_depth - 1]; }
+    void set_mode(Mode);
+    void push_mode(Mode);
+    void pop_mode();
+
+#ifdef SIGIL_SCANNER_COUNTERS
+    /// Accumulated over all inputs until reset
+    [[nodiscard]] const ScannerCounters &counters() const { return m_counters; }
+    ScannerCounters &counters() { return m_counters; }
+#endif
+
+protected:
+    /// Token types reported by the driver have to be less than
+    /// token_type_count
+    explicit ScannerDriver(Size token_type_count)
+        : m_counters(token_type_count)
+    {
+    }
 
 private:
     constexpr static Size Lookahead { 64 };
@@ -68,12 +112,18 @@ private:
         return offset < m_lookahead.size();
     }
 
-    [[nodiscard]] virtual State start_state() const = 0;
+    [[nodiscard]] virtual State start_state(Mode) const = 0;
     [[nodiscard]] virtual State error_state() const = 0;
     [[nodiscard]] virtual State next_state(State state, u8 c) const = 0;
     [[nodiscard]] virtual bool is_accepting_state(State state) const = 0;
     [[nodiscard]] virtual bool is_error_state(State state) const = 0;
     [[nodiscard]] virtual TokenType accepting_token(State state) const = 0;
+    /// Hook for recognizing keywords after a token was scanned
+    [[nodiscard]] virtual TokenType classify_token(
+        TokenType token_type, StringView) const
+    {
+        return token_type;
+    }
 
     u8 get_char();
     void get_next_token();
@@ -96,9 +146,15 @@ private:
     bool m_has_next_token { false };
     bool m_scan_error { false };
     bool m_eof_token_returned { false };
+    u64 m_scan_end { 0 };
     Token m_next_token;
 
     RingBuffer<Token, Lookahead> m_lookahead;
+
+    Mode m_mode_stack[ModeStackDepth] { 0 };
+    Size m_mode_depth { 1 };
+
+    [[no_unique_address]] ScannerInstrumentation m_counters;
 };
 
 }  // namespace sigil
@@ -0,0 +1,111 @@
+//
+// Copyright (c) 2023, Jan Sladek <keddelzz@web.de>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+//
+
+#pragma once
+
+#include <limits>  // std::numeric_limits
+
+#include <core/List.h>
+#include <core/StringView.h>
+
+#include <sigil/LiteralPrefilter.h>
+#include <sigil/SpecialTokenType.h>
+#include <sigil/StaticTable.h>
+#include <sigil/Types.h>
+
+namespace sigil {
+
+struct SearchMatch
+{
+    TokenType type { s32(SpecialTokenType::Error) };
+    Index offset { 0 };
+    StringView lexeme;
+};
+
+// Finds the tokens of a grammar anywhere in a text, like grep does for a
+// regular expression, instead of requiring the whole text to be tokens.
+//
+// The search runs the unanchored variant of the DFA, which has a `.*` loop in
+// front of the start state. Its states are sets of DFA states, here kept as
+// threads, one for every offset a match may start at. When two threads reach
+// the same DFA state, they accept the same continuations, so only the one
+// that started first keeps running, and there is at most one running thread
+// per DFA state. The later thread is merged into it: it keeps its own match
+// and takes the matches the running thread records from then on. A match
+// cutting off the running thread thereby doesn't lose the later one, and
+// every byte of the text is read once.
+//
+// With a prefilter, the search jumps over the bytes no match can start at
+// whenever no thread is running.
+class Searcher
+{
+public:
+    /// The table has to outlive the searcher
+    explicit Searcher(const StaticTable &);
+    /// The prefilter has to be created from the specification of the table
+    Searcher(const StaticTable &, LiteralPrefilter);
+
+    /// The leftmost-longest matches, which do not overlap, from left to
+    /// right. Empty matches and skipped tokens are not reported. Searches
+    /// share the buffers of the searcher, so a searcher can't be used by
+    /// several threads at once.
+    [[nodiscard]] List<SearchMatch> find_all(StringView text, Mode mode = 0);
+
+private:
+    constexpr static Index NoThread { std::numeric_limits<Index>::max() };
+
+    struct Thread
+    {
+        Index start { 0 };
+        Index end { 0 };
+        TokenType type { s32(SpecialTokenType::Error) };
+        /// The error state, once the thread is finished or merged
+        State state { 0 };
+        /// The thread it was merged into before reading the byte at
+        /// merged_at, whose later matches are its matches too
+        Index merged_into { NoThread };
+        Index merged_at { 0 };
+
+        [[nodiscard]] bool has_match() const
+        {
+            return type != s32(SpecialTokenType::Error);
+        }
+    };
+
+    inline static Index table_index(State state, u8 c)
+    {
+        constexpr auto char_count = std::numeric_limits<u8>::max() + 1;
+        return c + state * char_count;
+    }
+
+    void start_thread(Index position, State start_state);
+    /// Where the thread's own match got extended by the threads it was
+    /// merged into. Returns false if one of them is still running.
+    bool resolve(Index thread, Index &end, TokenType &type) const;
+    /// Reports the matches of the first threads as far as they are known, no
+    /// later thread can beat them
+    void report(StringView text, List<SearchMatch> &);
+
+    StaticTable m_table;
+    LiteralPrefilter m_prefilter;
+
+    /// Every thread since the search last ran out of them, by start
+    List<Thread> m_threads;
+    /// The threads which have not finished yet, by start
+    List<Index> m_running;
+    List<Index> m_next_running;
+    /// The first thread which may still be reported
+    Index m_first { 0 };
+    /// The end of the last match, threads starting in front of it are cut off
+    Index m_cut { 0 };
+    /// The step a DFA state was last taken by a thread in, and the thread,
+    /// by state
+    List<u64> m_state_steps;
+    List<Index> m_state_threads;
+    u64 m_step { 1 };
+};
+
+}  // namespace sigil
@@ -0,0 +1,199 @@
+//
+// Copyright (c) 2023, Jan Sladek <keddelzz@web.de>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+//
+
+#pragma once
+
+#include <limits>  // std::numeric_limits
+
+#include <core/Either.h>
+#include <core/List.h>
+#include <core/StringView.h>
+
+#include <sigil/CompiledScanner.h>
+#include <sigil/ScanCursor.h>
+#include <sigil/SpecialTokenType.h>
+#include <sigil/Types.h>
+
+namespace sigil {
+
+// Tokenizes with a DFA of at most 16 states by running it from all of its
+// states at once. The states each state goes to on a byte fit in a 16-byte
+// vector, and reading a byte composes two of these maps with one shuffle,
+// `pshufb` if built with SSSE3. Composition is associative, so the maps of
+// separate chunks of the input are computed independently, and the state at
+// every chunk boundary follows from a prefix over the chunk maps. Each chunk
+// can then be tokenized on its own, without speculation.
+//
+// The maps describe the token DFA: the table DFA, which restarts in the start
+// state instead of failing after a token. That is exact if every token ends
+// right where the table DFA fails, i.e. every state with a transition into
+// the error state accepts. Grammars which need to back up, e.g. for "1." in
+// front of "1.5", are rejected by create, except at the end of the input.
+class ShuffleScanner
+{
+public:
+    constexpr static Size MaxStateCount { 16 };
+
+    /// The state each state of the token DFA goes to
+    struct StateMap
+    {
+        u8 next[MaxStateCount];
+    };
+
+    /// The scanner has to outlive the shuffle scanner
+    static Either<StringView, ShuffleScanner> create(
+        const CompiledScanner &, Mode mode = 0);
+
+    [[nodiscard]] State start_state() const { return m_start_state; }
+
+    /// The map of the whole text
+    [[nodiscard]] StateMap map(StringView text) const;
+    /// The state of the token DFA after reading the text
+    [[nodiscard]] State run(StringView text, State state) const
+    {
+        return map(text).next[state];
+    }
+
+    /// First offset of a chunk, for chunks of about the same size. The chunk
+    /// after the last one begins at the end of the input.
+    [[nodiscard]] static Index chunk_begin(
+        Size input_size, Size chunk_count, Index chunk)
+    {
+        return Index(u64(input_size) * chunk / chunk_count);
+    }
+    /// The state of the token DFA at the beginning of every chunk. The maps
+    /// of the chunks are computed side by side.
+    [[nodiscard]] List<State> chunk_states(
+        StringView input, Size chunk_count) const;
+
+    /// Calls back with the token type and the lexeme of the tokens starting
+    /// between begin and end, from the state chunk_states returned for begin.
+    /// Returns false after an Error token. Chunks can be scanned in any
+    /// order, but the tokens of an input end at the first Error token.
+    template<typename Callback>
+    bool scan_chunk(
+        StringView input,
+        Index begin,
+        Index end,
+        State state,
+        Callback callback) const;
+
+    /// All tokens of the input in order, ending with an Eof or Error token
+    template<typename Callback>
+    void scan(StringView input, Size chunk_count, Callback callback) const;
+
+private:
+    ShuffleScanner(const CompiledScanner &, Mode mode);
+
+    const CompiledScanner *m_scanner { nullptr };
+    Mode m_mode { 0 };
+    State m_start_state { 0 };
+    /// Bytes with the same map share a class
+    u8 m_byte_classes[std::numeric_limits<u8>::max() + 1] { 0 };
+    List<StateMap> m_class_maps;
+};
+
+template<typename Callback>
+bool ShuffleScanner::scan_chunk(
+    StringView input,
+    Index begin,
+    Index end,
+    State state,
+    Callback callback) const
+{
+    constexpr auto char_count = std::numeric_limits<u8>::max() + 1;
+    constexpr auto Error = s32(SpecialTokenType::Error);
+    constexpr auto Skip = s32(SpecialTokenType::Skip);
+
+    const auto &table = m_scanner->table();
+    const auto error_state = table.error_state();
+    const auto transitions = table.transitions();
+    const auto accepting = table.accepting();
+
+    if (begin == end)
+        return true;
+    // The error belongs to the chunk its token started in
+    if (state == error_state)
+        return false;
+
+    const auto report = [&](Index start, Index last, TokenType type) {
+        if (type == Skip)
+            return;
+        const StringView lexeme { input.data() + start, last - start };
+        callback(table.keywords().classify(type, lexeme), lexeme);
+    };
+
+    // Later chunks start within a token of an earlier chunk, the first token
+    // of the chunk starts where that one ends
+    bool has_token = begin == 0;
+    Index start = begin;
+    for (auto offset = begin; offset < input.size(); ++offset) {
+        if (not has_token and offset >= end)
+            return true;
+
+        const auto c = u8(input[offset]);
+        auto next = transitions[c + state * char_count];
+        if (next == error_state) {
+            if (has_token) {
+                if (accepting[state] == Error) {
+                    callback(Error, StringView());
+                    return false;
+                }
+                report(start, offset, accepting[state]);
+            }
+            if (offset >= end)
+                return true;
+
+            has_token = true;
+            start = offset;
+            next = transitions[c + m_start_state * char_count];
+            if (next == error_state) {
+                callback(Error, StringView());
+                return false;
+            }
+        }
+        state = next;
+    }
+
+    if (not has_token or start == input.size())
+        return true;
+    if (accepting[state] != Error) {
+        report(start, input.size(), accepting[state]);
+        return true;
+    }
+
+    // The last token ends in front of the end of the input, so the longest
+    // match has to back up
+    const StringView rest { input.data() + start, input.size() - start };
+    ScanCursor cursor(*m_scanner, {}, rest);
+    cursor.set_mode(m_mode);
+    for (;;) {
+        const auto token = cursor.next();
+        if (token.type == s32(SpecialTokenType::Eof))
+            return true;
+        if (token.type == Error) {
+            callback(Error, StringView());
+            return false;
+        }
+        callback(token.type, token.lexeme);
+    }
+}
+
+template<typename Callback>
+void ShuffleScanner::scan(
+    StringView input, Size chunk_count, Callback callback) const
+{
+    const auto states = chunk_states(input, chunk_count);
+    for (Index chunk = 0; chunk < chunk_count; ++chunk) {
+        const auto begin = chunk_begin(input.size(), chunk_count, chunk);
+        const auto end = chunk_begin(input.size(), chunk_count, chunk + 1);
+        if (not scan_chunk(input, begin, end, states[chunk], callback))
+            return;
+    }
+    callback(s32(SpecialTokenType::Eof), StringView());
+}
+
+}  // namespace sigil
@@ -12,6 +12,7 @@ namespace sigil {
 
 enum class SpecialTokenType : s32
 {
+    Skip = -4,  // Accepted, but never reported by scanner drivers
     Eof = -2,
     Error = -1,
 };
@@ -7,44 +7,113 @@
 #pragma once
 
 #include <functional>
+#include <limits>
 
 #include <core/Formatter.h>
 #include <core/List.h>
+#include <core/ListView.h>
 #include <core/StringView.h>
 
+#include <sigil/Types.h>
+
 namespace sigil {
 
 namespace nfa {
 class Automaton;
 }
 
+enum class CaseSensitivity : u8
+{
+    Sensitive,
+    /// Ascii letters match either case
+    Insensitive,
+};
+
 class Specification
 {
 public:
+    Specification();
+
+    /// Start conditions: every token belongs to exactly one mode, the scanner
+    /// only recognizes tokens of its current mode. Mode 0 is named "Default".
+    Mode add_mode(StringView name);
+    /// Tokens added after this call belong to the given mode
+    void set_mode(Mode);
+
+    /// Tokens of skipped types (e.g. whitespace and comments) are consumed
+    /// by the scanner drivers without ever being returned
+    void skip_token_type(s32 token_type);
+    [[nodiscard]] bool is_skipped(s32 token_type) const
+    {
+        return m_skipped_token_types.contains(token_type);
+    }
+    /// The type the scanner drivers report for the token at the index,
+    /// SpecialTokenType::Skip for skipped types
+    [[nodiscard]] s32 scanned_token_type(Index token) const;
+
     void add_literal_token(
-        s32 token_type, StringView token_name, StringView exact_string);
+        s32 token_type,
+        StringView token_name,
+        StringView exact_string,
+        CaseSensitivity = CaseSensitivity::Sensitive);
+    /// A dictionary of literals with one token type, compiled into a single
+    /// minimal deterministic automaton instead of one chain per literal
+    void add_literal_tokens(
+        s32 token_type,
+        StringView token_name,
+        core::ListView<StringView> literals);
     void add_regex_token(
-        s32 token_type, StringView token_name, StringView regex);
+        s32 token_type,
+        StringView token_name,
+        StringView regex,
+        CaseSensitivity = CaseSensitivity::Sensitive);
+    void add_nfa_token(
+        s32 token_type,
+        StringView token_name,
+        std::function<void(sigil::nfa::Automaton &)> build);
+    /// Keywords are not part of the DFA: tokens of the identifier type are
+    /// looked up in a perfect hash after scanning, matching lexemes are
+    /// returned with the keyword's token type instead
+    void add_keyword_token(
+        s32 token_type,
+        StringView token_name,
+        StringView keyword,
+        s32 identifier_token_type);
+    /// The cache key stands in for the build function when hashing, it has to
+    /// change whenever the automaton built by the function changes
     void add_nfa_token(
         s32 token_type,
         StringView token_name,
+        StringView cache_key,
         std::function<void(sigil::nfa::Automaton &)> build);
 
     struct TokenSpec
     {
         static TokenSpec literal(
-            s32 token_type, StringView token_name, StringView literal);
+            s32 token_type,
+            StringView token_name,
+            StringView literal,
+            CaseSensitivity = CaseSensitivity::Sensitive);
+        static TokenSpec dictionary(
+            s32 token_type,
+            StringView token_name,
+            core::ListView<StringView> literals);
         static TokenSpec regex(
-            s32 token_type, StringView token_name, StringView regex);
+            s32 token_type,
+            StringView token_name,
+            StringView regex,
+            CaseSensitivity = CaseSensitivity::Sensitive);
         static TokenSpec nfa(
             s32 token_type,
             StringView token_name,
+            StringView cache_key,
             std::function<void(sigil::nfa::Automaton &)> build);
 
         enum class Type : u8
         {
             Invalid,
             Literal,
+            Dictionary,
             Regex,
             Nfa,
         };
@@ -54,12 +123,63 @@ public:
         StringView name;
         StringView pattern;
         std::function<void(sigil::nfa::Automaton &)> build;
+        StringView cache_key;
+        Mode mode { 0 };
+        CaseSensitivity case_sensitivity { CaseSensitivity::Sensitive };
+        List<StringView> literals;
     };
 
+    struct KeywordSpec
+    {
+        s32 token_type { -3 };
+        StringView name;
+        StringView keyword;
+        s32 identifier_token_type { -3 };
+    };
+
+    /// Bounded repetitions copy their operand, compilation fails if a token's
+    /// automaton would have more states than this
+    void set_repetition_limit(Size nfa_states)
+    {
+        m_repetition_limit = nfa_states;
+    }
+    [[nodiscard]] Size repetition_limit() const { return m_repetition_limit; }
+
+    /// Grammar::compile gives up once the DFA has more states than this, or
+    /// is estimated to take more bytes including its transition table.
+    /// ScannerDriver::create then simulates the NFAs instead.
+    void set_dfa_budget(Size state_count, Size bytes)
+    {
+        m_dfa_state_budget = state_count;
+        m_dfa_byte_budget = bytes;
+    }
+    [[nodiscard]] Size dfa_state_budget() const { return m_dfa_state_budget; }
+    [[nodiscard]] Size dfa_byte_budget() const { return m_dfa_byte_budget; }
+
     [[nodiscard]] const List<TokenSpec> &tokens() const { return m_tokens; }
+    [[nodiscard]] const List<KeywordSpec> &keywords() const
+    {
+        return m_keywords;
+    }
+    [[nodiscard]] const List<StringView> &modes() const { return m_modes; }
+
+    /// Nfa tokens can only be hashed, if they were given a cache key
+    [[nodiscard]] bool is_hashable() const;
+    /// Stable across processes and hosts, covers everything that influences
+    /// the compiled tables
+    [[nodiscard]] u64 hash() const;
 
 private:
+    void add_token(TokenSpec);
+
     List<TokenSpec> m_tokens;
+    List<KeywordSpec> m_keywords;
+    List<StringView> m_modes;
+    Mode m_current_mode { 0 };
+    List<s32> m_skipped_token_types;
+    Size m_repetition_limit { 1 << 16 };
+    Size m_dfa_state_budget { std::numeric_limits<Size>::max() };
+    Size m_dfa_byte_budget { std::numeric_limits<Size>::max() };
 };
 
 }  // namespace sigil
@@ -10,6 +10,7 @@
 #include <core/ListView.h>
 
 #include <sigil/Array.h>
+#include <sigil/KeywordTable.h>
 #include <sigil/Types.h>
 
 namespace sigil {
@@ -23,17 +24,52 @@ public:
         State error_state,
         Array<State> transitions,
         Array<TokenType> accepting);
+    /// mode_start_states[0] has to be the start state
+    StaticTable(
+        State start_state,
+        State error_state,
+        Array<State> transitions,
+        Array<TokenType> accepting,
+        Array<State> mode_start_states);
+    StaticTable(
+        State start_state,
+        State error_state,
+        Array<State> transitions,
+        Array<TokenType> accepting,
+        Array<State> mode_start_states,
+        KeywordTable keywords);
 
     [[nodiscard]] State start_state() const { return m_start_state; }
+    [[nodiscard]] State start_state(Mode mode) const
+    {
+        if (m_mode_start_states.is_empty()) {
+            assert(mode == 0);
+            return m_start_state;
+        }
+        return m_mode_start_states[mode];
+    }
     [[nodiscard]] State error_state() const { return m_error_state; }
     [[nodiscard]] Array<State> transitions() const { return m_transitions; }
     [[nodiscard]] Array<TokenType> accepting() const { return m_accepting; }
+    [[nodiscard]] Array<State> mode_start_states() const
+    {
+        return m_mode_start_states;
+    }
+    [[nodiscard]] Size mode_count() const
+    {
+        return m_mode_start_states.is_empty() ? 1 : m_mode_start_states.size();
+    }
+    [[nodiscard]] const KeywordTable &keywords() const { return m_keywords; }
+    /// One more than the largest token type the table reports
+    [[nodiscard]] Size token_type_count() const;
 
 private:
     State m_start_state;
     State m_error_state;
     Array<State> m_transitions;
     Array<TokenType> m_accepting;
+    Array<State> m_mode_start_states;  // empty, if there is only one mode
+    KeywordTable m_keywords;
 };
 
 }  // namespace sigil
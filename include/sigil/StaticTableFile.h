@@ -0,0 +1,117 @@
+//
+// Copyright (c) 2023, Jan Sladek <keddelzz@web.de>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+//
+
+#pragma once
+
+#include <core/Either.h>
+#include <core/List.h>
+#include <core/ListView.h>
+#include <core/StringView.h>
+
+#include <sigil/Specification.h>
+#include <sigil/StaticTable.h>
+#include <sigil/StaticTableScannerDriver.h>
+
+namespace sigil {
+
+struct TokenName
+{
+    TokenType token_type { -3 };
+    StringView name;
+};
+
+// Versioned, checksummed binary image of a StaticTable. The arrays of the
+// table are stored aligned and in host byte order, so that a mapped file can
+// be used by a StaticTableScannerDriver without copying anything. Next to the
+// table, the file lists every token type it can report, sorted by type, with
+// its name.
+//
+// Loading checks the structure, everything the scanner drivers index with,
+// which reads the transitions once. Verifying the checksum reads the whole
+// image once more and is left to callers which don't trust the storage.
+class StaticTableFile
+{
+public:
+    constexpr static u32 Version { 8 };
+
+    enum class Verification : u8
+    {
+        Structure,
+        Checksum,
+    };
+
+    StaticTableFile(const StaticTableFile &) = delete;
+    StaticTableFile(StaticTableFile &&);
+    StaticTableFile &operator=(const StaticTableFile &) = delete;
+    StaticTableFile &operator=(StaticTableFile &&);
+    ~StaticTableFile();
+
+    /// The name of every token type, the first one for shared types, sorted
+    /// by type
+    static List<TokenName> token_names(const Specification &);
+
+    static List<u8> serialize(const StaticTable &);
+    /// Token types without a name are stored with an empty name. The hash of
+    /// the specification the table was compiled from is stored as is.
+    static List<u8> serialize(
+        const StaticTable &,
+        core::ListView<TokenName> token_names,
+        u64 specification_hash = 0);
+    static Either<StringView, Size> write(
+        StringView file_path, const StaticTable &);
+    static Either<StringView, Size> write(
+        StringView file_path,
+        const StaticTable &,
+        core::ListView<TokenName> token_names,
+        u64 specification_hash = 0);
+
+    /// Validate an image in memory owned by the caller
+    static Either<StringView, StaticTableFile> view(
+        const void *, Size, Verification = Verification::Structure);
+    /// Validate an image and take ownership of its bytes
+    static Either<StringView, StaticTableFile> adopt(
+        List<u8> bytes, Verification = Verification::Structure);
+    /// Map an image file read-only, the mapping lives as long as the result
+    static Either<StringView, StaticTableFile> map(
+        StringView file_path, Verification = Verification::Structure);
+
+    [[nodiscard]] const StaticTable &static_table() const { return m_table; }
+    /// Number of token types the table can report
+    [[nodiscard]] Size token_count() const { return m_token_entries.size(); }
+    /// Empty for unknown token types
+    [[nodiscard]] StringView token_name(TokenType) const;
+    /// 0 if the writer didn't know the specification
+    [[nodiscard]] u64 specification_hash() const
+    {
+        return m_specification_hash;
+    }
+    [[nodiscard]] StaticTableScannerDriver scanner_driver() const
+    {
+        return StaticTableScannerDriver(m_table);
+    }
+
+private:
+    struct TokenEntry
+    {
+        TokenType token_type { -3 };
+        u32 offset { 0 };  // into the token names
+        u32 length { 0 };
+    };
+
+    StaticTableFile(void *mapping, Size mapping_size, StaticTable table);
+
+    void unmap();
+
+    void *m_mapping { nullptr };
+    Size m_mapping_size { 0 };
+    List<u8> m_bytes;
+    StaticTable m_table;
+    Array<TokenEntry> m_token_entries;
+    Array<char> m_token_names;
+    u64 m_specification_hash { 0 };
+};
+
+}  // namespace sigil
@@ -25,7 +25,14 @@ public:
 
     [[nodiscard]] StaticTable static_table() const;
 
-    [[nodiscard]] State start_state() const final { return m_start_state; }
+    [[nodiscard]] State start_state(Mode mode) const final
+    {
+        if (m_mode_start_states.is_empty()) {
+            assert(mode == 0);
+            return m_start_state;
+        }
+        return m_mode_start_states[mode];
+    }
     [[nodiscard]] State error_state() const final { return m_error_state; }
 
     [[nodiscard]] State next_state(State state, u8 c) const final
@@ -34,7 +41,7 @@ public:
     }
     [[nodiscard]] bool is_accepting_state(State state) const final
     {
-        return accepting_token(state) >= 0;
+        return accepting_token(state) != s32(SpecialTokenType::Error);
     }
     [[nodiscard]] bool is_error_state(State state) const final
     {
@@ -44,6 +51,11 @@ public:
     {
         return m_accepting[state];
     }
+    [[nodiscard]] TokenType classify_token(
+        TokenType token_type, StringView lexeme) const final
+    {
+        return m_keywords.classify(token_type, lexeme);
+    }
 
 private:
     inline static Index table_index(State state, u8 c)
@@ -56,6 +68,8 @@ private:
     State m_error_state;
     Array<State> m_transitions;
     Array<TokenType> m_accepting;
+    Array<State> m_mode_start_states;
+    KeywordTable m_keywords;
 };
 
 }  // namespace sigil
@@ -12,5 +12,9 @@ namespace sigil {
 
 using State = u32;
 using TokenType = s32;
+using Mode = u32;
+
+/// Modes ScannerDriver and ScanCursor can push on top of each other
+constexpr Size ModeStackDepth { 64 };
 
 }  // namespace sigil
@@ -0,0 +1,206 @@
+//
+// Copyright (c) 2023, Jan Sladek <keddelzz@web.de>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+//
+
+#include <bit>  // std::countr_zero
+
+#include <sigil/BitParallelScannerDriver.h>
+
+#include <sigil/CompileMemo.h>
+#include <sigil/Grammar.h>
+#include <sigil/Nfa.h>
+
+namespace sigil {
+
+Index BitParallelScannerDriver::Mask::first() const
+{
+    for (Index i = 0; i < WordCount; ++i) {
+        if (words[i] != 0)
+            return i * 64 + std::countr_zero(words[i]);
+    }
+    assert(false and "The mask is empty");
+    return MaxPositions;
+}
+
+BitParallelScannerDriver::BitParallelScannerDriver(
+    List<TokenType> token_types, KeywordTable::Storage keywords)
+    : ScannerDriver(ScannerCounters::token_type_count(
+          token_types, KeywordTable(keywords)))
+    , m_token_types(std::move(token_types))
+    , m_keyword_storage(std::move(keywords))
+    , m_keywords(m_keyword_storage)
+{
+}
+
+struct GlushkovPosition
+{
+    Index token { 0 };
+    const nfa::Arc *arc { nullptr };
+};
+
+static Index position_of(
+    const List<GlushkovPosition> &positions, const nfa::Arc *arc)
+{
+    for (Index i = 0; i < positions.size(); ++i) {
+        if (positions[i].arc == arc)
+            return i;
+    }
+    assert(false and "Unreachable");
+    return 0;
+}
+
+Either<StringView, BitParallelScannerDriver> BitParallelScannerDriver::create(
+    const Specification &specification)
+{
+    using Result = Either<StringView, BitParallelScannerDriver>;
+
+    // The automata are only needed to derive the tables
+    CompileMemo memo;
+    auto either_nfas = Grammar::compile_nfas(specification, memo);
+    if (not either_nfas.isRight())
+        return Result::left(std::move(either_nfas.release_left()));
+    const auto nfas = std::move(either_nfas.release_right());
+
+    List<GlushkovPosition> positions;
+    for (Index i = 0; i < nfas.size(); ++i) {
+        for (const auto state : nfas[i]->states()) {
+            for (const auto arc : nfas[i]->outgoing_arcs(state)) {
+                if (arc->is_character())
+                    positions.add({ i, arc });
+            }
+        }
+    }
+    if (positions.size() > MaxPositions)
+        return Result::left("Too many positions for bit-parallel scanning"sv);
+
+    auto either_keywords = KeywordTable::build(specification);
+    if (not either_keywords.isRight())
+        return Result::left(either_keywords.left());
+
+    List<TokenType> token_types(nfas.size());
+    for (Index i = 0; i < nfas.size(); ++i)
+        token_types.add(specification.scanned_token_type(i));
+
+    BitParallelScannerDriver driver(
+        std::move(token_types), std::move(either_keywords.release_right()));
+    driver.m_position_count = positions.size();
+
+    // Positions reached by reading a byte from the states, and whether the
+    // states accept
+    const auto after = [&](Index token, nfa::State *state, bool &accepting) {
+        Set<NfaState> states;
+        states.add({ nfas[token], state });
+
+        Mask mask;
+        accepting = false;
+        for (const auto &nfa_state : reachable_by_epsilon(states)) {
+            accepting = accepting or nfa_state.state->accepting;
+            const auto &arcs = nfas[token]->outgoing_arcs(nfa_state.state);
+            for (const auto arc : arcs) {
+                if (arc->is_character())
+                    mask.set(position_of(positions, arc));
+            }
+        }
+        return mask;
+    };
+
+    List<Mask> follow(positions.size());
+    for (Index i = 0; i < positions.size(); ++i) {
+        bool accepting = false;
+        const auto &position = positions[i];
+        follow.add(after(position.token, position.arc->target, accepting));
+        if (accepting)
+            driver.m_accepting.set(i);
+        driver.m_position_tokens.add(position.token);
+    }
+
+    const auto chunk_count = (positions.size() + ChunkBits - 1) / ChunkBits;
+    for (Index chunk = 0; chunk < chunk_count; ++chunk) {
+        for (Index bits = 0; bits < ChunkSize; ++bits) {
+            Mask mask;
+            for (Index bit = 0; bit < ChunkBits; ++bit) {
+                const auto position = chunk * ChunkBits + bit;
+                if ((bits & (1 << bit)) != 0 and position < positions.size())
+                    mask |= follow[position];
+            }
+            driver.m_follow.add(mask);
+        }
+    }
+
+    for (auto c = CharSet::first; c <= CharSet::last; ++c) {
+        Mask mask;
+        for (Index i = 0; i < positions.size(); ++i) {
+            if (positions[i].arc->char_set.contains(c))
+                mask.set(i);
+        }
+        driver.m_reads.add(mask);
+    }
+
+    for (Mode mode = 0; mode < specification.modes().size(); ++mode) {
+        Mask first;
+        TokenType empty_token = s32(SpecialTokenType::Error);
+        for (Index i = 0; i < nfas.size(); ++i) {
+            if (specification.tokens()[i].mode != mode)
+                continue;
+
+            bool accepting = false;
+            first |= after(i, nfas[i]->start_state(), accepting);
+            if (accepting and empty_token == s32(SpecialTokenType::Error))
+                empty_token = driver.m_token_types[i];
+        }
+        driver.m_mode_first.add(first);
+        driver.m_mode_empty_tokens.add(empty_token);
+    }
+
+    return Result::right(std::move(driver));
+}
+
+State BitParallelScannerDriver::start_state(Mode mode) const
+{
+    m_mode = mode;
+    m_active = Mask();
+    m_step_tokens.clear();
+    m_step_tokens.add(s32(SpecialTokenType::Error));
+    return add_step(m_mode_empty_tokens[mode]);
+}
+
+State BitParallelScannerDriver::next_state(State state, u8 c) const
+{
+    assert(state + 1 == m_step_tokens.size() and "Only the latest step");
+
+    // The first step is the start of the token, before any position
+    const auto successors =
+        state == ErrorState + 1 ? m_mode_first[m_mode] : follow(m_active);
+    m_active = successors & m_reads[c];
+    if (m_active.is_empty())
+        return ErrorState;
+
+    const auto accepting = m_active & m_accepting;
+    if (accepting.is_empty())
+        return add_step(s32(SpecialTokenType::Error));
+    return add_step(m_token_types[m_position_tokens[accepting.first()]]);
+}
+
+BitParallelScannerDriver::Mask BitParallelScannerDriver::follow(
+    const Mask &active) const
+{
+    Mask result;
+    const auto chunk_count = m_follow.size() / ChunkSize;
+    for (Index chunk = 0; chunk < chunk_count; ++chunk) {
+        const auto bit = chunk * ChunkBits;
+        const auto bits = (active.words[bit / 64] >> (bit % 64)) & 0xff;
+        if (bits != 0)
+            result |= m_follow[chunk * ChunkSize + bits];
+    }
+    return result;
+}
+
+State BitParallelScannerDriver::add_step(TokenType token_type) const
+{
+    m_step_tokens.add(token_type);
+    return State(m_step_tokens.size() - 1);
+}
+
+}  // namespace sigil
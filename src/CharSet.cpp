@@ -45,6 +45,17 @@ void CharSet::negate()
         set(i, not contains(i));
 }
 
+void CharSet::fold_case()
+{
+    for (u8 c = 'a'; c <= 'z'; ++c) {
+        const u8 upper = c - 'a' + 'A';
+        if (contains(c) or contains(upper)) {
+            set(c, true);
+            set(upper, true);
+        }
+    }
+}
+
 bool CharSet::operator==(const CharSet &other) const
 {
     for (auto i = sigil::CharSet::first; i <= sigil::CharSet::last; ++i)
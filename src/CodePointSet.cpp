@@ -0,0 +1,238 @@
+//
+// Copyright (c) 2023, Jan Sladek <keddelzz@web.de>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+//
+
+#include <sigil/CodePointSet.h>
+
+#include <algorithm>
+#include <cstdio>
+
+#include <core/Formatting.h>
+
+namespace sigil {
+
+CodePointSet::CodePointSet(u32 first, u32 last) { add(first, last); }
+
+bool CodePointSet::contains(u32 c) const
+{
+    Index low = 0;
+    Index high = m_ranges.size();
+    while (low < high) {
+        const auto middle = low + (high - low) / 2;
+        const auto &range = m_ranges[middle];
+        if (c < range.first)
+            high = middle;
+        else if (c > range.last)
+            low = middle + 1;
+        else
+            return true;
+    }
+    return false;
+}
+
+void CodePointSet::add(u32 first, u32 last)
+{
+    assert(first <= last and last <= Last);
+
+    List<Range> result(m_ranges.size() + 1);
+    Range added { first, last };
+    bool inserted = false;
+    for (const auto &range : m_ranges) {
+        if (range.last + 1 < added.first) {
+            result.add(range);
+        } else if (added.last + 1 < range.first) {
+            if (not inserted) {
+                result.add(added);
+                inserted = true;
+            }
+            result.add(range);
+        } else {
+            added.first = std::min(added.first, range.first);
+            added.last = std::max(added.last, range.last);
+        }
+    }
+    if (not inserted)
+        result.add(added);
+    m_ranges = std::move(result);
+}
+
+void CodePointSet::negate()
+{
+    List<Range> result(m_ranges.size() + 2);
+    const auto add_scalar_values = [&](u32 first, u32 last) {
+        if (first > last)
+            return;
+        if (last < FirstSurrogate or first > LastSurrogate) {
+            result.add({ first, last });
+            return;
+        }
+        if (first < FirstSurrogate)
+            result.add({ first, FirstSurrogate - 1 });
+        if (last > LastSurrogate)
+            result.add({ LastSurrogate + 1, last });
+    };
+
+    u32 next = 0;
+    for (const auto &range : m_ranges) {
+        if (range.first > 0)
+            add_scalar_values(next, range.first - 1);
+        next = range.last + 1;
+    }
+    add_scalar_values(next, Last);
+    m_ranges = std::move(result);
+}
+
+void CodePointSet::fold_case()
+{
+    for (u32 c = 'a'; c <= 'z'; ++c) {
+        const u32 upper = c - 'a' + 'A';
+        if (contains(c) or contains(upper)) {
+            add(c, c);
+            add(upper, upper);
+        }
+    }
+}
+
+bool CodePointSet::operator==(const CodePointSet &other) const
+{
+    if (m_ranges.size() != other.m_ranges.size())
+        return false;
+    for (Index i = 0; i < m_ranges.size(); ++i) {
+        if (not(m_ranges[i] == other.m_ranges[i]))
+            return false;
+    }
+    return true;
+}
+
+CodePointSet CodePointSet::operator~() const
+{
+    CodePointSet result = *this;
+    result.negate();
+    return result;
+}
+
+CodePointSet CodePointSet::operator|(const CodePointSet &other) const
+{
+    CodePointSet result = *this;
+    result |= other;
+    return result;
+}
+
+CodePointSet &CodePointSet::operator|=(const CodePointSet &other)
+{
+    for (const auto &range : other.m_ranges) add(range.first, range.last);
+    return *this;
+}
+
+static u8 encode_utf8(u32 c, u8 (&bytes)[4])
+{
+    if (c <= 0x7F) {
+        bytes[0] = u8(c);
+        return 1;
+    }
+    if (c <= 0x7FF) {
+        bytes[0] = u8(0xC0 | (c >> 6));
+        bytes[1] = u8(0x80 | (c & 0x3F));
+        return 2;
+    }
+    if (c <= 0xFFFF) {
+        bytes[0] = u8(0xE0 | (c >> 12));
+        bytes[1] = u8(0x80 | ((c >> 6) & 0x3F));
+        bytes[2] = u8(0x80 | (c & 0x3F));
+        return 3;
+    }
+    bytes[0] = u8(0xF0 | (c >> 18));
+    bytes[1] = u8(0x80 | ((c >> 12) & 0x3F));
+    bytes[2] = u8(0x80 | ((c >> 6) & 0x3F));
+    bytes[3] = u8(0x80 | (c & 0x3F));
+    return 4;
+}
+
+// Split a range of scalar values until both ends encode to the same length
+// and differ only in a suffix of full continuation byte ranges, at which
+// point the range is exactly described by one byte range per position.
+static void split_utf8(
+    u32 first, u32 last, List<CodePointSet::Utf8Sequence> &result)
+{
+    constexpr u32 MaxForLength[] = { 0x7F, 0x7FF, 0xFFFF };
+    for (const auto max : MaxForLength) {
+        if (first <= max and max < last) {
+            split_utf8(first, max, result);
+            split_utf8(max + 1, last, result);
+            return;
+        }
+    }
+
+    if (last > 0x7F) {
+        for (auto i = 1; i < 4; ++i) {
+            const u32 mask = (1u << (6 * i)) - 1;
+            if ((first & ~mask) == (last & ~mask))
+                continue;
+            if ((first & mask) != 0) {
+                split_utf8(first, first | mask, result);
+                split_utf8((first | mask) + 1, last, result);
+                return;
+            }
+            if ((last & mask) != mask) {
+                split_utf8(first, (last & ~mask) - 1, result);
+                split_utf8(last & ~mask, last, result);
+                return;
+            }
+        }
+    }
+
+    CodePointSet::Utf8Sequence sequence;
+    const auto length = encode_utf8(first, sequence.first);
+    [[maybe_unused]] const auto other_length = encode_utf8(last, sequence.last);
+    assert(length == other_length);
+    sequence.length = length;
+    result.add(sequence);
+}
+
+List<CodePointSet::Utf8Sequence> CodePointSet::utf8_sequences() const
+{
+    List<Utf8Sequence> result;
+    for (const auto &range : m_ranges) {
+        if (range.last < FirstSurrogate or range.first > LastSurrogate) {
+            split_utf8(range.first, range.last, result);
+            continue;
+        }
+        if (range.first < FirstSurrogate)
+            split_utf8(range.first, FirstSurrogate - 1, result);
+        if (range.last > LastSurrogate)
+            split_utf8(LastSurrogate + 1, range.last, result);
+    }
+    return result;
+}
+
+}  // namespace sigil
+
+namespace core {
+
+void Formatter<sigil::CodePointSet>::format(
+    StringBuilder &b, const sigil::CodePointSet &set)
+{
+    const auto emit_code_point = [&](u32 c) {
+        char buffer[12] { 0 };
+        auto count = snprintf(buffer, sizeof(buffer), "U+%04X", c);
+        assert(count >= 0 and "snprintf failed");
+        Formatting::format_into(b, StringView(buffer, count));
+    };
+
+    bool first = true;
+    for (const auto &range : set.ranges()) {
+        if (not first)
+            Formatting::format_into(b, ", ");
+        first = false;
+
+        emit_code_point(range.first);
+        if (range.first != range.last) {
+            Formatting::format_into(b, " - ");
+            emit_code_point(range.last);
+        }
+    }
+}
+
+}  // namespace core
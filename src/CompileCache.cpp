@@ -0,0 +1,99 @@
+//
+// Copyright (c) 2023, Jan Sladek <keddelzz@web.de>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+//
+
+#include <sigil/CompileCache.h>
+
+#include <climits>
+#include <cstdio>
+#include <cstdlib>  // mkstemp
+
+#include <unistd.h>
+
+#include <sigil/DfaTableScannerDriver.h>
+#include <sigil/Grammar.h>
+#include <sigil/Hash.h>
+
+namespace sigil {
+
+CompileCache::CompileCache(StringView directory)
+    : m_directory(directory)
+{
+}
+
+Either<StringView, StaticTableFile> CompileCache::load_or_compile(
+    const Specification &specification)
+{
+    using Result = Either<StringView, StaticTableFile>;
+
+    const auto hashable = specification.is_hashable();
+
+    char path[PATH_MAX] { 0 };
+    const auto specification_hash = hashable ? specification.hash() : 0;
+    if (hashable) {
+        Hasher hasher;
+        hasher.add_u64(StaticTableFile::Version);
+        hasher.add_u64(specification_hash);
+        const auto count = snprintf(
+            path,
+            sizeof(path),
+            "%.*s/%016llx.sigil",
+            int(m_directory.size()),
+            m_directory.data(),
+            (unsigned long long)hasher.digest());
+        if (count < 0 or count >= int(sizeof(path)))
+            return Result::left("Cache directory path is too long"sv);
+
+        // A corrupt or outdated entry, or one of another specification whose
+        // name collides, is simply recompiled and replaced
+        auto either_cached = StaticTableFile::map(path);
+        if (either_cached.isRight() and
+            either_cached.right().specification_hash() == specification_hash) {
+            ++m_hit_count;
+            return either_cached;
+        }
+    }
+
+    ++m_compile_count;
+    auto either_grammar = Grammar::compile(specification);
+    if (not either_grammar.isRight())
+        return Result::left(either_grammar.left());
+
+    auto grammar = std::move(either_grammar.release_right());
+    auto scanner_driver = DfaTableScannerDriver::create(grammar.dfa());
+    const auto table = scanner_driver.static_table();
+    const auto token_names = StaticTableFile::token_names(specification);
+
+    if (hashable) {
+        // Write to a private file first, so concurrent readers never observe
+        // a partially written entry. Every call, in any thread or process,
+        // gets a file of its own.
+        char temporary_path[PATH_MAX] { 0 };
+        const auto count = snprintf(
+            temporary_path, sizeof(temporary_path), "%s.XXXXXX", path);
+        const auto fd = count >= 0 and count < int(sizeof(temporary_path))
+                            ? mkstemp(temporary_path)
+                            : -1;
+        if (fd >= 0) {
+            close(fd);
+            auto written = StaticTableFile::write(
+                temporary_path,
+                table,
+                token_names.to_view(),
+                specification_hash);
+            if (written.isRight() and rename(temporary_path, path) == 0) {
+                auto either_cached = StaticTableFile::map(path);
+                if (either_cached.isRight())
+                    return either_cached;
+            }
+            remove(temporary_path);
+        }
+    }
+
+    return StaticTableFile::adopt(StaticTableFile::serialize(
+        table, token_names.to_view(), specification_hash));
+}
+
+}  // namespace sigil
@@ -0,0 +1,262 @@
+//
+// Copyright (c) 2023, Jan Sladek <keddelzz@web.de>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+//
+
+#include <sigil/CompileMemo.h>
+
+#include <cstdint>  // uintptr_t
+
+#include <sigil/Hash.h>
+
+namespace sigil {
+
+template<typename Callback>
+static void foreach_reachable(
+    nfa::Automaton &automaton, nfa::State *state, Callback callback)
+{
+    for (auto arc : automaton.outgoing_arcs(state)) callback(*arc);
+}
+
+Set<NfaState> reachable_by_epsilon(const Set<NfaState> &states)
+{
+    Set<NfaState> result;
+    List<NfaState> work_list(states.size());
+    for (const auto &state : states) {
+        result.add(state);
+        work_list.add(state);
+    }
+
+    // Every state is visited once, states added are visited later on
+    for (Index i = 0; i < work_list.size(); ++i) {
+        const auto nfa_state = work_list[i];
+        auto &nfa = *nfa_state.nfa;
+
+        foreach_reachable(nfa, nfa_state.state, [&](nfa::Arc &arc) {
+            if (arc.is_character())
+                return;
+
+            NfaState target { &nfa, arc.target };
+            if (not result.contains(target)) {
+                result.add(target);
+                work_list.add(target);
+            }
+        });
+    }
+
+    return result;
+}
+
+Set<NfaState> reachable_by_char(const Set<NfaState> &states, u8 c)
+{
+    Set<NfaState> reachable;
+
+    for (auto &state : states) {
+        auto &nfa = *state.nfa;
+
+        foreach_reachable(nfa, state.state, [&](nfa::Arc &arc) {
+            if (arc.is_epsilon())
+                return;
+            if (not arc.char_set.contains(c))
+                return;
+
+            NfaState nfa_state { &nfa, arc.target };
+            reachable.add(std::move(nfa_state));
+        });
+    }
+
+    return reachable;
+}
+
+void CompileMemo::clear()
+{
+    m_arena = core::Arena();
+    m_nfas = Map<u64, CachedNfa *>();
+    m_states = Map<u64, DeterminizedState *>();
+    m_nfa_count = 0;
+    m_state_count = 0;
+    m_used_nfa_count = 0;
+    m_used_state_count = 0;
+}
+
+void CompileMemo::begin_compile()
+{
+    if (m_nfa_count > 2 * m_used_nfa_count or
+        m_state_count > 2 * m_used_state_count)
+        clear();
+
+    ++m_compile;
+    m_used_nfa_count = 0;
+    m_used_state_count = 0;
+}
+
+// Nfa tokens without a cache key are built again on every compile
+static bool is_cacheable(const Specification::TokenSpec &token)
+{
+    return Specification::TokenSpec::Type::Nfa != token.type or
+           token.cache_key.size() > 0;
+}
+
+// Everything create_nfa reads, besides the build function of Nfa tokens. The
+// token type and mode only matter for the DFA.
+static List<u8> token_signature(
+    const Specification::TokenSpec &token, Size repetition_limit)
+{
+    List<u8> signature;
+    const auto add_u64 = [&](u64 value) {
+        for (auto i = 0; i < 8; ++i) signature.add(u8(value >> (8 * i)));
+    };
+    const auto add_string = [&](StringView string) {
+        add_u64(string.size());
+        for (Index i = 0; i < string.size(); ++i) signature.add(u8(string[i]));
+    };
+
+    add_u64(u64(token.type));
+    add_u64(u64(token.case_sensitivity));
+    add_u64(u64(repetition_limit));
+    if (Specification::TokenSpec::Type::Nfa == token.type)
+        add_string(token.cache_key);
+    else
+        add_string(token.pattern);
+    add_u64(token.literals.size());
+    for (const auto &literal : token.literals) add_string(literal);
+    return signature;
+}
+
+static u64 signature_digest(const List<u8> &signature)
+{
+    Hasher hasher;
+    hasher.add_bytes(&signature[0], signature.size());
+    return hasher.digest();
+}
+
+static bool is_same_signature(const List<u8> &a, const List<u8> &b)
+{
+    if (a.size() != b.size())
+        return false;
+    for (Index i = 0; i < a.size(); ++i) {
+        if (a[i] != b[i])
+            return false;
+    }
+    return true;
+}
+
+nfa::Automaton *CompileMemo::take_nfa(
+    const Specification::TokenSpec &token, Size repetition_limit)
+{
+    if (not is_cacheable(token))
+        return nullptr;
+
+    const auto signature = token_signature(token, repetition_limit);
+    const auto digest = signature_digest(signature);
+    if (not m_nfas.contains(digest))
+        return nullptr;
+
+    // Equal tokens of one specification never share an automaton, the DFA
+    // tells tokens apart by their automaton
+    for (auto cached = m_nfas.get(digest); cached != nullptr;
+         cached = cached->next) {
+        if (cached->compile == m_compile or
+            not is_same_signature(cached->signature, signature))
+            continue;
+        cached->compile = m_compile;
+        ++m_used_nfa_count;
+        return cached->automaton;
+    }
+    return nullptr;
+}
+
+nfa::Automaton *CompileMemo::add_nfa(
+    const Specification::TokenSpec &token,
+    Size repetition_limit,
+    nfa::Automaton automaton)
+{
+    auto stored = m_arena.construct<nfa::Automaton>(std::move(automaton));
+    ++m_nfa_count;
+    ++m_used_nfa_count;
+    if (not is_cacheable(token))
+        return stored;
+
+    auto cached = m_arena.construct<CachedNfa>();
+    cached->signature = token_signature(token, repetition_limit);
+    cached->automaton = stored;
+    cached->compile = m_compile;
+
+    const auto digest = signature_digest(cached->signature);
+    if (m_nfas.contains(digest)) {
+        auto first = m_nfas.get(digest);
+        cached->next = first->next;
+        first->next = cached;
+    } else {
+        m_nfas.add(digest, cached);
+    }
+    return stored;
+}
+
+// Independent of the order of the states
+static u64 states_digest(const List<NfaState> &nfa_states)
+{
+    u64 digest = 0;
+    for (const auto &nfa_state : nfa_states) {
+        Hasher hasher;
+        hasher.add_u64(u64(reinterpret_cast<uintptr_t>(nfa_state.nfa)));
+        hasher.add_u64(nfa_state.state->id);
+        digest += hasher.digest();
+    }
+    return digest;
+}
+
+static bool is_same_states(
+    const Set<NfaState> &a, const List<NfaState> &distinct_b)
+{
+    if (a.size() != distinct_b.size())
+        return false;
+    for (const auto &nfa_state : distinct_b) {
+        if (not a.contains(nfa_state))
+            return false;
+    }
+    return true;
+}
+
+CompileMemo::DeterminizedState *CompileMemo::state(
+    const List<NfaState> &nfa_states)
+{
+    const auto digest = states_digest(nfa_states);
+    DeterminizedState *first = nullptr;
+    if (m_states.contains(digest)) {
+        first = m_states.get(digest);
+        for (auto state = first; state != nullptr; state = state->next) {
+            if (is_same_states(state->nfa_states, nfa_states)) {
+                use(state);
+                return state;
+            }
+        }
+    }
+
+    // Only states seen the first time are copied into a set
+    Set<NfaState> distinct;
+    for (const auto &nfa_state : nfa_states) distinct.add(nfa_state);
+    auto state = m_arena.construct<DeterminizedState>(std::move(distinct));
+    if (first != nullptr) {
+        state->next = first->next;
+        first->next = state;
+    } else {
+        m_states.add(digest, state);
+    }
+    ++m_state_count;
+    use(state);
+    return state;
+}
+
+void CompileMemo::use(DeterminizedState *state)
+{
+    if (state->compile == m_compile)
+        return;
+    state->compile = m_compile;
+    state->dfa_state = nullptr;
+    state->queued = false;
+    ++m_used_state_count;
+}
+
+}  // namespace sigil
@@ -0,0 +1,102 @@
+//
+// Copyright (c) 2023, Jan Sladek <keddelzz@web.de>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+//
+
+#include <sigil/CompileStatistics.h>
+
+#include <core/Formatting.h>
+
+namespace sigil {
+
+PhaseTimer::PhaseTimer(u64 *microseconds)
+    : m_microseconds(microseconds)
+{
+    if (m_microseconds != nullptr)
+        m_start = Clock::now();
+}
+
+PhaseTimer::~PhaseTimer()
+{
+    if (m_microseconds == nullptr)
+        return;
+
+    const auto elapsed = Clock::now() - m_start;
+    *m_microseconds +=
+        std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+}
+
+}  // namespace sigil
+
+namespace core {
+
+void Formatter<sigil::CompileStatistics>::format(
+    StringBuilder &b, const sigil::CompileStatistics &statistics)
+{
+    // Per mille, there is no floating point formatting
+    const auto density =
+        statistics.table_transition_count == 0
+            ? 0
+            : statistics.table_live_transition_count * 1000 /
+                  statistics.table_transition_count;
+
+    Formatting::format_into(b, "CompileStatistics {\n"sv);
+    Formatting::format_into(
+        b, "    parse: "sv, statistics.parse_microseconds, "us\n"sv);
+    Formatting::format_into(
+        b, "    nfa: "sv, statistics.nfa_microseconds, "us\n"sv);
+    Formatting::format_into(
+        b, "    dfa: "sv, statistics.dfa_microseconds, "us\n"sv);
+    Formatting::format_into(
+        b, "    table: "sv, statistics.table_microseconds, "us\n"sv);
+    Formatting::format_into(
+        b, "    regex nodes: "sv, statistics.regex_node_count, "\n"sv);
+    Formatting::format_into(
+        b,
+        "    nfa states: "sv,
+        statistics.nfa_state_count,
+        ", arcs: "sv,
+        statistics.nfa_arc_count,
+        "\n"sv);
+    Formatting::format_into(
+        b,
+        "    dfa states: "sv,
+        statistics.dfa_state_count,
+        ", arcs: "sv,
+        statistics.dfa_arc_count,
+        "\n"sv);
+    Formatting::format_into(
+        b,
+        "    largest nfa state set: "sv,
+        statistics.largest_nfa_state_set,
+        "\n"sv);
+    Formatting::format_into(
+        b,
+        "    reused nfas: "sv,
+        statistics.reused_nfa_count,
+        ", dfa states: "sv,
+        statistics.reused_dfa_state_count,
+        "\n"sv);
+    Formatting::format_into(
+        b, "    closures: "sv, statistics.closure_count, "\n"sv);
+    Formatting::format_into(
+        b,
+        "    estimated arena bytes: "sv,
+        statistics.estimated_arena_bytes,
+        ", scratch bytes: "sv,
+        statistics.scratch_bytes,
+        "\n"sv);
+    Formatting::format_into(
+        b, "    table bytes: "sv, statistics.table_bytes, "\n"sv);
+    Formatting::format_into(
+        b,
+        "    table density: "sv,
+        density / 10,
+        "."sv,
+        density % 10,
+        "%\n"sv);
+    Formatting::format_into(b, "}"sv);
+}
+
+}  // namespace core
@@ -0,0 +1,159 @@
+//
+// Copyright (c) 2021-2023, Jan Sladek <keddelzz@web.de>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+//
+
+#include <sigil/CompiledScanner.h>
+
+#include <sigil/Grammar.h>
+#include <sigil/SpecialTokenType.h>
+
+namespace sigil {
+
+static Index table_index(State state, u8 c)
+{
+    constexpr auto char_count = std::numeric_limits<u8>::max() + 1;
+    return c + state * char_count;
+}
+
+template<typename T>
+static List<T> copy(const List<T> &list)
+{
+    List<T> result(list.size());
+    for (const auto &element : list) result.add(element);
+    return result;
+}
+
+static KeywordTable::Storage copy(const KeywordTable::Storage &storage)
+{
+    KeywordTable::Storage result;
+    result.seed = storage.seed;
+    result.identifier_token_types = copy(storage.identifier_token_types);
+    result.displacements = copy(storage.displacements);
+    result.entries = copy(storage.entries);
+    result.strings = copy(storage.strings);
+    return result;
+}
+
+CompiledScanner::CompiledScanner(
+    List<State> transitions,
+    List<TokenType> accepting,
+    List<State> mode_start_states,
+    KeywordTable::Storage keywords,
+    StaticTable table)
+    : m_transitions(std::move(transitions))
+    , m_accepting(std::move(accepting))
+    , m_mode_start_states(std::move(mode_start_states))
+    , m_keywords(std::move(keywords))
+    , m_table(std::move(table))
+{
+}
+
+CompiledScanner::CompiledScanner(const StaticTable &table)
+    : m_table(table)
+{
+}
+
+CompiledScanner CompiledScanner::create(
+    const dfa::Automaton &dfa, CompileStatistics *statistics)
+{
+    if (statistics != nullptr)
+        statistics->table_microseconds = 0;
+    PhaseTimer timer(statistics ? &statistics->table_microseconds : nullptr);
+
+    // @TODO: Minimize dfa (mfa) to get smaller tables
+    State start_state = dfa.start_state()->id;
+    State error_state = dfa.error_state()->id;
+    const auto state_count = dfa.states().size();
+    constexpr auto char_count = std::numeric_limits<u8>::max() + 1;
+    const auto transition_count = state_count * char_count;
+
+    List<State> transitions(transition_count);
+    static_assert(std::is_same_v<State, u32>);
+
+    List<TokenType> accepting(state_count);
+    static_assert(std::is_same_v<TokenType, s32>);
+
+    for (Index i = 0; i < transition_count; ++i) transitions.add(error_state);
+    for (Index i = 0; i < state_count; ++i)
+        accepting.add(s32(SpecialTokenType::Error));
+
+    for (const auto arc : dfa.arcs()) {
+        // @FIXME: This loop is repeated several times
+        for (auto c = sigil::CharSet::first; c <= sigil::CharSet::last; ++c) {
+            if (not arc->char_set.contains(c))
+                continue;
+
+            const auto origin = State(arc->origin->id);
+            const auto target = State(arc->target->id);
+            transitions[table_index(origin, c)] = target;
+        }
+    }
+    for (const auto state : dfa.states()) {
+        if (state->is_accepting())
+            accepting[state->id] = state->token_type;
+    }
+
+    // Single-mode tables keep the original layout
+    List<State> mode_start_states(dfa.mode_count());
+    if (dfa.mode_count() > 1) {
+        for (Mode mode = 0; mode < dfa.mode_count(); ++mode)
+            mode_start_states.add(dfa.start_state(mode)->id);
+    }
+
+    // Grammar::compile built the keyword table
+    auto keywords = copy(dfa.keyword_table());
+
+    if (statistics != nullptr) {
+        statistics->table_transition_count = transitions.size();
+        statistics->table_live_transition_count = 0;
+        for (const auto target : transitions) {
+            if (target != error_state)
+                ++statistics->table_live_transition_count;
+        }
+
+        statistics->table_bytes = transitions.size() * sizeof(State) +
+                                  accepting.size() * sizeof(TokenType) +
+                                  mode_start_states.size() * sizeof(State) +
+                                  keywords.identifier_token_types.size() *
+                                      sizeof(TokenType) +
+                                  keywords.displacements.size() * sizeof(u32) +
+                                  keywords.entries.size() *
+                                      sizeof(KeywordTable::Entry) +
+                                  keywords.strings.size();
+    }
+
+    auto transitions_array = Array<State>::list_view(transitions.to_view());
+    auto accepting_array = Array<TokenType>::list_view(accepting.to_view());
+    auto mode_start_states_array =
+        Array<State>::list_view(mode_start_states.to_view());
+    StaticTable table(
+        start_state,
+        error_state,
+        transitions_array,
+        accepting_array,
+        mode_start_states_array,
+        KeywordTable(keywords));
+    return {
+        std::move(transitions),
+        std::move(accepting),
+        std::move(mode_start_states),
+        std::move(keywords),
+        table,
+    };
+}
+
+Either<StringView, CompiledScanner> CompiledScanner::create(
+    const Specification &specification, CompileStatistics *statistics)
+{
+    using Result = Either<StringView, CompiledScanner>;
+
+    auto either_grammar = Grammar::compile(specification, statistics);
+    if (not either_grammar.isRight())
+        return Result::left(either_grammar.left());
+    auto grammar = std::move(either_grammar.release_right());
+    return Result::right(create(grammar.dfa(), statistics));
+}
+
+}  // namespace sigil
@@ -0,0 +1,211 @@
+//
+// Copyright (c) 2023, Jan Sladek <keddelzz@web.de>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+//
+
+#include <sigil/Dawg.h>
+
+#include <sigil/Hash.h>
+
+namespace sigil {
+
+constexpr static Index Root { 0 };
+constexpr static Size InitialRegisterSize { 64 };
+
+Dawg::Dawg()
+{
+    m_nodes.add(Node());
+    for (Index i = 0; i < InitialRegisterSize; ++i) m_register.add(0);
+}
+
+void Dawg::add(StringView literal)
+{
+    assert(not m_finished);
+
+    // In ascending order the common prefix with the previous literal is the
+    // only part of the new literal already in the automaton, and it consists
+    // of the most recently added edges
+    Index node = Root;
+    Index i = 0;
+    for (; i < literal.size(); ++i) {
+        const auto &edges = m_nodes[node].edges;
+        if (edges.is_empty() or edges[edges.size() - 1].c != u8(literal[i]))
+            break;
+        node = edges[edges.size() - 1].target;
+    }
+
+    if (m_literal_count > 0) {
+        if (i == literal.size() and i == m_last_literal.size())
+            return;  // repeated literal
+        assert(i < literal.size() and "Literals have to be sorted");
+        assert(
+            (i == m_last_literal.size() or
+             u8(literal[i]) > m_last_literal[i]) and
+            "Literals have to be sorted");
+    }
+    ++m_literal_count;
+
+    if (m_nodes[node].edges.non_empty())
+        replace_or_register(node);
+
+    for (; i < literal.size(); ++i) {
+        const auto next = m_nodes.size();
+        m_nodes.add(Node());
+        m_nodes[node].edges.add({ u8(literal[i]), next });
+        node = next;
+    }
+    m_nodes[node].accepting = true;
+
+    m_last_literal.clear();
+    for (Index j = 0; j < literal.size(); ++j)
+        m_last_literal.add(u8(literal[j]));
+}
+
+void Dawg::finish()
+{
+    assert(not m_finished);
+    if (m_nodes[Root].edges.non_empty())
+        replace_or_register(Root);
+    m_finished = true;
+}
+
+u64 Dawg::node_hash(Index node) const
+{
+    Hasher hasher;
+    hasher.add_u64(m_nodes[node].accepting);
+    for (const auto &edge : m_nodes[node].edges) {
+        hasher.add_u64(edge.c);
+        hasher.add_u64(edge.target);
+    }
+    return hasher.digest();
+}
+
+bool Dawg::equivalent(Index a, Index b) const
+{
+    const auto &left = m_nodes[a];
+    const auto &right = m_nodes[b];
+    if (left.accepting != right.accepting or
+        left.edges.size() != right.edges.size())
+        return false;
+    for (Index i = 0; i < left.edges.size(); ++i) {
+        if (left.edges[i].c != right.edges[i].c or
+            left.edges[i].target != right.edges[i].target)
+            return false;
+    }
+    return true;
+}
+
+// Minimize the path below the most recently added edge of node, bottom up.
+// Replaced nodes are unreachable afterwards and simply left behind.
+void Dawg::replace_or_register(Index node)
+{
+    const auto child = m_nodes[node].edges[m_nodes[node].edges.size() - 1];
+    if (m_nodes[child.target].edges.non_empty())
+        replace_or_register(child.target);
+
+    const auto representative = find_or_register(child.target);
+    auto &edges = m_nodes[node].edges;
+    edges[edges.size() - 1].target = representative;
+}
+
+Index Dawg::find_or_register(Index node)
+{
+    const auto mask = m_register.size() - 1;
+    auto slot = Index(node_hash(node)) & mask;
+    while (m_register[slot] != 0) {
+        if (equivalent(m_register[slot], node))
+            return m_register[slot];
+        slot = (slot + 1) & mask;
+    }
+
+    m_register[slot] = node;
+    if (++m_register_count * 2 > m_register.size())
+        grow_register();
+    return node;
+}
+
+void Dawg::grow_register()
+{
+    List<Index> registered(m_register_count);
+    for (const auto node : m_register) {
+        if (node != 0)
+            registered.add(node);
+    }
+
+    const auto size = m_register.size() * 2;
+    m_register.clear();
+    for (Index i = 0; i < size; ++i) m_register.add(0);
+
+    const auto mask = size - 1;
+    for (const auto node : registered) {
+        auto slot = Index(node_hash(node)) & mask;
+        while (m_register[slot] != 0) slot = (slot + 1) & mask;
+        m_register[slot] = node;
+    }
+}
+
+template<typename Callback>
+void Dawg::foreach_reachable(Callback callback) const
+{
+    List<u8> visited(m_nodes.size());
+    for (Index i = 0; i < m_nodes.size(); ++i) visited.add(0);
+
+    List<Index> queue;
+    queue.add(Root);
+    visited[Root] = 1;
+    for (Index i = 0; i < queue.size(); ++i) {
+        const auto node = queue[i];
+        callback(node);
+
+        for (const auto &edge : m_nodes[node].edges) {
+            if (not visited[edge.target]) {
+                visited[edge.target] = 1;
+                queue.add(edge.target);
+            }
+        }
+    }
+}
+
+Size Dawg::state_count() const
+{
+    assert(m_finished);
+    Size count = 0;
+    foreach_reachable([&](Index) { ++count; });
+    return count;
+}
+
+void Dawg::create_nfa(nfa::Automaton &automaton) const
+{
+    assert(m_finished);
+
+    List<nfa::State *> states(m_nodes.size());
+    for (Index i = 0; i < m_nodes.size(); ++i) states.add(nullptr);
+    foreach_reachable([&](Index node) {
+        states[node] = automaton.create_state();
+        states[node]->accepting = m_nodes[node].accepting;
+    });
+    states[Root]->start = true;
+
+    // Edges into the same state share a single arc
+    foreach_reachable([&](Index node) {
+        const auto &edges = m_nodes[node].edges;
+        for (Index i = 0; i < edges.size(); ++i) {
+            bool seen = false;
+            for (Index j = 0; j < i and not seen; ++j)
+                seen = edges[j].target == edges[i].target;
+            if (seen)
+                continue;
+
+            CharSet char_set;
+            for (Index j = i; j < edges.size(); ++j) {
+                if (edges[j].target == edges[i].target)
+                    char_set.set(edges[j].c, true);
+            }
+            automaton.create_character_arc(
+                states[node], states[edges[i].target], char_set);
+        }
+    });
+}
+
+}  // namespace sigil
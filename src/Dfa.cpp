@@ -19,6 +19,8 @@ Automaton::~Automaton()
 {
     m_states.clear();
     m_arcs.clear();
+    m_start_states.clear();
+    m_keywords.clear();
 }
 
 State *Automaton::create_state()
@@ -36,16 +38,26 @@ Arc *Automaton::create_arc(State *origin, State *target, CharSet char_set)
     return arc;
 }
 
-const dfa::State *Automaton::start_state() const
+void Automaton::add_start_state(State *state)
 {
-    dfa::State *result = nullptr;
-    for (auto &state : states()) {
-        if (state->start) {
-            assert(result == nullptr and "Multiple start states");
-            result = state;
-        }
-    }
-    return result;
+    state->start = true;
+    m_start_states.add(state);
+}
+
+void Automaton::add_keyword(Keyword keyword)
+{
+    m_keywords.add(std::move(keyword));
+}
+
+void Automaton::set_keyword_table(KeywordTable::Storage keyword_table)
+{
+    m_keyword_table = std::move(keyword_table);
+}
+
+const dfa::State *Automaton::start_state(Mode mode) const
+{
+    assert(m_start_states.in_bounds(mode));
+    return m_start_states[mode];
 }
 
 const dfa::State *Automaton::error_state() const
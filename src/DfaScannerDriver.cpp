@@ -6,16 +6,29 @@
 
 #include <sigil/DfaScannerDriver.h>
 
+#include <algorithm>  // std::max
+
 namespace sigil {
 
+static Size token_type_count(const dfa::Automaton &dfa)
+{
+    auto max_token_type = KeywordTable(dfa.keyword_table()).max_token_type();
+    for (const auto state : dfa.states()) {
+        if (state->is_accepting())
+            max_token_type = std::max(max_token_type, state->token_type);
+    }
+    return Size(max_token_type + 1);
+}
+
 DfaScannerDriver::DfaScannerDriver(const dfa::Automaton &dfa)
-    : m_dfa(dfa)
+    : ScannerDriver(token_type_count(dfa))
+    , m_dfa(dfa)
 {
 }
 
-State DfaScannerDriver::start_state() const
+State DfaScannerDriver::start_state(Mode mode) const
 {
-    auto state = m_dfa.start_state();
+    auto state = m_dfa.start_state(mode);
     assert(state);
     return State(state->id);
 }
@@ -70,6 +83,12 @@ TokenType DfaScannerDriver::accepting_token(State state) const
     return state_by_id(state)->token_type;
 }
 
+TokenType DfaScannerDriver::classify_token(
+    TokenType token_type, StringView lexeme) const
+{
+    return KeywordTable(m_dfa.keyword_table()).classify(token_type, lexeme);
+}
+
 const dfa::State *DfaScannerDriver::state_by_id(State id) const
 {
     if (id < 0)
@@ -44,11 +44,12 @@ const dfa::State *transition(
     return next;
 }
 
-SimulationResult simulate(const sigil::Grammar &grammar, StringView source)
+SimulationResult simulate(
+    const sigil::Grammar &grammar, StringView source, Mode mode)
 {
     const auto &dfa = grammar.dfa();
 
-    auto state = dfa.start_state();
+    auto state = dfa.start_state(mode);
 
     for (Index i = 0; i < source.size(); ++i) {
         const auto c = source[i];
@@ -4,7 +4,9 @@
 // SPDX-License-Identifier: BSD-2-Clause
 //
 
-#include <algorithm>  // std::min
+#include <algorithm>   // std::lower_bound, std::min, std::sort
+#include <cstring>
+#include <functional>  // std::less
 
 #include <sigil/Grammar.h>
 
@@ -13,10 +15,14 @@
 #include <core/Map.h>
 #include <core/Set.h>
 
+#include <sigil/CompileMemo.h>
+#include <sigil/Dawg.h>
 #include <sigil/Dfa.h>
 #include <sigil/Nfa.h>
 #include <sigil/RegExp.h>
+#include <sigil/RegExpSimplifier.h>
 #include <sigil/RegexParser.h>
+#include <sigil/SpecialTokenType.h>
 
 namespace sigil {
 
@@ -32,6 +38,53 @@ static void drop_config(INfa &nfa)
     nfa.end->accepting = false;
 }
 
+// Lower a set of code points to byte arcs from start to end, matching their
+// UTF-8 encodings. States reading the trailing continuation bytes are shared
+// between sequences with equal suffixes, which keeps classes like \p{L} small.
+static void create_utf8_nfa(
+    nfa::Automaton &automaton,
+    nfa::State *start,
+    nfa::State *end,
+    const CodePointSet &code_points)
+{
+    struct Suffix
+    {
+        u8 first { 0 };
+        u8 last { 0 };
+        nfa::State *target { nullptr };
+        nfa::State *state { nullptr };
+    };
+
+    List<Suffix> suffixes;
+    for (const auto &sequence : code_points.utf8_sequences()) {
+        auto target = end;
+        for (auto i = sequence.length - 1; i > 0; --i) {
+            const auto first = sequence.first[i];
+            const auto last = sequence.last[i];
+
+            nfa::State *state = nullptr;
+            for (const auto &suffix : suffixes) {
+                if (suffix.first == first and suffix.last == last and
+                    suffix.target == target) {
+                    state = suffix.state;
+                    break;
+                }
+            }
+
+            if (state == nullptr) {
+                state = automaton.create_state();
+                automaton.create_character_arc(
+                    state, target, CharSet(first, last));
+                suffixes.add({ first, last, target, state });
+            }
+            target = state;
+        }
+
+        automaton.create_character_arc(
+            start, target, CharSet(sequence.first[0], sequence.last[0]));
+    }
+}
+
 static INfa create_regex_nfa(nfa::Automaton &automaton, const RegExp *regexp)
 {
     auto start = automaton.create_state();
@@ -47,6 +100,11 @@ static INfa create_regex_nfa(nfa::Automaton &automaton, const RegExp *regexp)
             automaton.create_character_arc(start, end, exp->char_set());
         } break;
 
+        case RegExp::Type::CodePoints: {
+            const auto exp = reinterpret_cast<const CodePoints *>(regexp);
+            create_utf8_nfa(automaton, start, end, exp->code_points());
+        } break;
+
         case RegExp::Type::Alternative: {
             const auto exp = reinterpret_cast<const Alternative *>(regexp);
 
@@ -99,6 +157,43 @@ static INfa create_regex_nfa(nfa::Automaton &automaton, const RegExp *regexp)
             automaton.create_epsilon_arc(end, start);
         } break;
 
+        case RegExp::Type::Repetition: {
+            const auto exp = reinterpret_cast<const Repetition *>(regexp);
+
+            // Mandatory copies are chained, optional copies may leave early
+            // through the shared end state instead of nesting optionals
+            const auto create_copy = [&]() {
+                auto copy = create_regex_nfa(automaton, exp->exp());
+                drop_config(copy);
+                return copy;
+            };
+
+            auto previous = start;
+            INfa last;
+            for (u32 i = 0; i < exp->min(); ++i) {
+                last = create_copy();
+                automaton.create_epsilon_arc(previous, last.start);
+                previous = last.end;
+            }
+
+            if (not exp->is_bounded()) {
+                if (exp->min() == 0) {
+                    last = create_copy();
+                    automaton.create_epsilon_arc(previous, last.start);
+                    previous = last.start;
+                }
+                automaton.create_epsilon_arc(last.end, last.start);
+            } else {
+                for (auto i = exp->min(); i < exp->max(); ++i) {
+                    auto copy = create_copy();
+                    automaton.create_epsilon_arc(previous, copy.start);
+                    automaton.create_epsilon_arc(previous, end);
+                    previous = copy.end;
+                }
+            }
+            automaton.create_epsilon_arc(previous, end);
+        } break;
+
         case RegExp::Type::Optional: {
             const auto exp = reinterpret_cast<const Optional *>(regexp);
 
@@ -114,8 +209,81 @@ static INfa create_regex_nfa(nfa::Automaton &automaton, const RegExp *regexp)
     return { start, end };
 }
 
+// Number of states create_regex_nfa creates, saturating above limit
+static Size count_regex_nfa_states(const RegExp *regexp, Size limit)
+{
+    assert(limit < std::numeric_limits<Size>::max());
+    const auto saturate = [&](Size count) {
+        return std::min(count, limit + 1);
+    };
+
+    switch (regexp->type()) {
+        case RegExp::Type::Invalid: assert(false and "Unreachable"); return 0;
+
+        case RegExp::Type::Atom: return 2;
+
+        case RegExp::Type::CodePoints: {
+            const auto exp = reinterpret_cast<const CodePoints *>(regexp);
+            Size count = 2;
+            for (const auto &sequence : exp->code_points().utf8_sequences())
+                count += sequence.length - 1;
+            return saturate(count);
+        }
+
+        case RegExp::Type::Alternative: {
+            const auto exp = reinterpret_cast<const Alternative *>(regexp);
+            return saturate(
+                2 + count_regex_nfa_states(exp->left(), limit) +
+                count_regex_nfa_states(exp->right(), limit));
+        }
+
+        case RegExp::Type::Concatenation: {
+            const auto exp = reinterpret_cast<const Concatenation *>(regexp);
+            return saturate(
+                2 + count_regex_nfa_states(exp->left(), limit) +
+                count_regex_nfa_states(exp->right(), limit));
+        }
+
+        case RegExp::Type::Kleene: {
+            const auto exp = reinterpret_cast<const Kleene *>(regexp);
+            return saturate(2 + count_regex_nfa_states(exp->exp(), limit));
+        }
+
+        case RegExp::Type::PositiveKleene: {
+            const auto exp = reinterpret_cast<const PositiveKleene *>(regexp);
+            return saturate(2 + count_regex_nfa_states(exp->exp(), limit));
+        }
+
+        case RegExp::Type::Optional: {
+            const auto exp = reinterpret_cast<const Optional *>(regexp);
+            return saturate(2 + count_regex_nfa_states(exp->exp(), limit));
+        }
+
+        case RegExp::Type::Repetition: {
+            const auto exp = reinterpret_cast<const Repetition *>(regexp);
+            const auto copy = count_regex_nfa_states(exp->exp(), limit);
+            const Size copies = exp->is_bounded()
+                                    ? exp->max()
+                                    : std::max<Size>(exp->min(), 1);
+            if (copies > 0 and copy > limit / copies)
+                return limit + 1;
+            return saturate(2 + copies * copy);
+        }
+    }
+
+    assert(false and "Unreachable");
+    return 0;
+}
+
+// Regex trees are only needed to build the automaton, they go to the scratch
+// arena of the compile
 static Either<StringView, nfa::Automaton> create_nfa(
-    core::Arena &arena, const Specification::TokenSpec &token)
+    core::Arena &arena,
+    core::Arena &scratch,
+    RegExpSimplifier &simplifier,
+    const Specification::TokenSpec &token,
+    Size repetition_limit,
+    CompileStatistics *statistics)
 {
     using Result = Either<StringView, nfa::Automaton>;
 
@@ -127,9 +295,11 @@ static Either<StringView, nfa::Automaton> create_nfa(
 
             // @TODO: Introduce StringView::begin and StringView::end
             for (Index i = 0; i < token.pattern.size(); ++i) {
-                const auto c = token.pattern[i];
+                auto char_set = CharSet(token.pattern[i]);
+                if (token.case_sensitivity == CaseSensitivity::Insensitive)
+                    char_set.fold_case();
                 auto next = automaton.create_state();
-                automaton.create_character_arc(curr, next, CharSet(c));
+                automaton.create_character_arc(curr, next, char_set);
                 curr = next;
             }
 
@@ -137,16 +307,54 @@ static Either<StringView, nfa::Automaton> create_nfa(
             return Result::right(std::move(automaton));
         }
 
-        case Specification::TokenSpec::Type::Regex: {
+        case Specification::TokenSpec::Type::Dictionary: {
+            List<StringView> literals(token.literals.size());
+            for (const auto &literal : token.literals) literals.add(literal);
+            if (literals.non_empty()) {
+                std::sort(
+                    &literals[0],
+                    &literals[0] + literals.size(),
+                    [](StringView a, StringView b) {
+                        const auto size = std::min(a.size(), b.size());
+                        const auto order = memcmp(a.data(), b.data(), size);
+                        return order < 0 or
+                               (order == 0 and a.size() < b.size());
+                    });
+            }
+
+            Dawg dawg;
+            for (const auto &literal : literals) dawg.add(literal);
+            dawg.finish();
+
             sigil::nfa::Automaton automaton(arena);
-            sigil::RegexParser parser(arena);
-            parser.initialize(token.pattern);
+            dawg.create_nfa(automaton);
+            return Result::right(std::move(automaton));
+        }
 
-            auto either_regex = parser.parse();
-            if (not either_regex.isRight())
-                return Result::left(std::move(either_regex.release_left()));
+        case Specification::TokenSpec::Type::Regex: {
+            RegExp *regex = nullptr;
+            {
+                PhaseTimer timer(
+                    statistics ? &statistics->parse_microseconds : nullptr);
+                sigil::RegexParser parser(scratch);
+                parser.initialize(token.pattern, token.case_sensitivity);
+
+                auto either_regex = parser.parse();
+                if (not either_regex.isRight())
+                    return Result::left(
+                        std::move(either_regex.release_left()));
+
+                // Shared subtrees still get their own NFA states
+                regex = simplifier.simplify(either_regex.right());
+                if (statistics != nullptr)
+                    statistics->scratch_bytes += parser.allocated_bytes();
+            }
 
-            auto regex = either_regex.right();
+            sigil::nfa::Automaton automaton(arena);
+            if (count_regex_nfa_states(regex, repetition_limit) >
+                repetition_limit)
+                return Result::left(
+                    "Regex expands beyond the repetition limit"sv);
             create_regex_nfa(automaton, regex);
             return Result::right(std::move(automaton));
         }
@@ -165,124 +373,141 @@ static Either<StringView, nfa::Automaton> create_nfa(
     }
 }
 
-struct NfaState
+// Distinct, as every token has an automaton of its own
+static List<NfaState> dfa_start_state(
+    const Specification &specification,
+    const List<nfa::Automaton *> &nfas,
+    Mode mode)
 {
-    nfa::Automaton *nfa { nullptr };
-    nfa::State *state { nullptr };
+    List<NfaState> nfa_start_states;
+    for (Index i = 0; i < nfas.size(); ++i) {
+        if (specification.tokens()[i].mode != mode)
+            continue;
 
-    bool operator==(const NfaState &other) const
-    {
-        return nfa == other.nfa and state == other.state;
+        auto nfa = nfas[i];
+        nfa_start_states.add({ nfa, nfa->start_state() });
     }
-};
+    return nfa_start_states;
+}
 
-struct DfaState
+static void create_dfa_state(
+    CompileMemo &memo,
+    dfa::Automaton &dfa,
+    CompileMemo::DeterminizedState *determinized)
 {
-    DfaState(Set<NfaState> nfa_states, dfa::State *dfa_state)
-        : nfa_states(std::move(nfa_states))
-        , dfa_state(dfa_state)
-    {
+    memo.use(determinized);
+    if (determinized->dfa_state == nullptr) {
+        auto state = dfa.create_state();
+        if (determinized->nfa_states.is_empty())
+            state->type = dfa::State::Type::Error;
+        determinized->dfa_state = state;
     }
-    Set<NfaState> nfa_states;
-    dfa::State *dfa_state { nullptr };
-};
+}
 
-template<typename Callback>
-static void foreach_reachable(
-    nfa::Automaton &automaton, nfa::State *state, Callback callback)
+static CompileMemo::DeterminizedState *create_or_get_dfa_state(
+    CompileMemo &memo, dfa::Automaton &dfa, const List<NfaState> &states)
 {
-    for (auto arc : automaton.arcs()) {
-        if (arc->origin == state)
-            callback(*arc);
-    }
+    auto determinized = memo.state(states);
+    create_dfa_state(memo, dfa, determinized);
+    return determinized;
 }
 
-static Set<NfaState> reachable_by_epsilon(const Set<NfaState> &states)
+// Buffers of the subset construction, cleared instead of allocated again for
+// every DFA state of a compile. Only closures the memo hasn't seen yet are
+// copied into a set of their own.
+struct SubsetScratch
 {
-    Set<NfaState> result;
-    for (auto state : states) result.add(state);
-
-    bool modified = true;
-
-    while (modified) {
-        Set<NfaState> reachable;
-
-        for (auto nfa_state : result) {
-            auto &nfa = *nfa_state.nfa;
+    struct FirstState
+    {
+        const nfa::Automaton *nfa { nullptr };
+        Index first { 0 };
+    };
 
-            foreach_reachable(nfa, nfa_state.state, [&](nfa::Arc &arc) {
-                if (arc.is_character())
-                    return;
+    explicit SubsetScratch(const List<nfa::Automaton *> &nfas)
+    {
+        constexpr auto char_count = std::numeric_limits<u8>::max() + 1;
+        for (Index i = 0; i < char_count; ++i) by_char.add(List<NfaState>());
 
-                NfaState nfa_state { &nfa, arc.target };
-                reachable.add(std::move(nfa_state));
-            });
+        // NFA states of all automata are numbered consecutively
+        for (const auto nfa : nfas) {
+            first_states.add({ nfa, visits.size() });
+            for (Index i = 0; i < nfa->states().size(); ++i) visits.add(0);
         }
-
-        modified = false;
-        for (auto elem : reachable) {
-            if (not result.contains(elem)) {
-                result.add(std::move(elem));
-                modified = true;
-            }
+        if (not first_states.is_empty()) {
+            std::sort(
+                &first_states[0],
+                &first_states[0] + first_states.size(),
+                [](const FirstState &a, const FirstState &b) {
+                    return std::less<>()(a.nfa, b.nfa);
+                });
         }
     }
 
-    return result;
-}
-
-static Set<NfaState> reachable_by_char(const Set<NfaState> &states, u8 c)
-{
-    Set<NfaState> reachable;
-
-    for (auto &state : states) {
-        auto &nfa = *state.nfa;
+    [[nodiscard]] Index number(NfaState state) const
+    {
+        const auto begin = &first_states[0];
+        const auto first = std::lower_bound(
+            begin,
+            begin + first_states.size(),
+            state.nfa,
+            [](const FirstState &first, const nfa::Automaton *nfa) {
+                return std::less<>()(first.nfa, nfa);
+            });
+        assert(first != begin + first_states.size() and
+               first->nfa == state.nfa);
+        return first->first + state.state->id;
+    }
 
-        foreach_reachable(nfa, state.state, [&](nfa::Arc &arc) {
-            if (arc.is_epsilon())
-                return;
-            if (not arc.char_set.contains(c))
+    /// The states and the states reachable from them by epsilon arcs, each
+    /// once, go into closure
+    void close(const List<NfaState> &states)
+    {
+        ++visit;
+        closure.clear();
+        const auto add = [this](NfaState state) {
+            auto &visited = visits[number(state)];
+            if (visited == visit)
                 return;
-
-            NfaState nfa_state { &nfa, arc.target };
-            reachable.add(std::move(nfa_state));
-        });
+            visited = visit;
+            closure.add(state);
+        };
+
+        for (const auto &state : states) add(state);
+        // Every state is visited once, states added are visited later on
+        for (Index i = 0; i < closure.size(); ++i) {
+            const auto state = closure[i];
+            for (const auto arc : state.nfa->outgoing_arcs(state.state)) {
+                if (arc->is_epsilon())
+                    add({ state.nfa, arc->target });
+            }
+        }
     }
 
-    return reachable;
-}
+    /// The NFA states reached by reading each byte, before their closure
+    List<List<NfaState>> by_char;
+    List<NfaState> closure;
+    List<const nfa::Automaton *> accepting;
 
-static Set<NfaState> dfa_start_state(
-    dfa::Automaton &dfa,
-    Map<Set<NfaState>, DfaState *> &mapping,
-    const List<nfa::Automaton> &nfas)
-{
-    Set<NfaState> nfa_start_states;
-    for (auto &nfa : nfas) {
-        NfaState nfa_state { &nfa, nfa.start_state() };
-        nfa_start_states.add(std::move(nfa_state));
-    }
-    return nfa_start_states;
-}
+    /// By address of the automaton
+    List<FirstState> first_states;
+    /// The closure a state was last added to, by number
+    List<u64> visits;
+    u64 visit { 0 };
+};
 
-static DfaState *create_or_get_dfa_state(
-    core::Arena &arena,
-    dfa::Automaton &dfa,
-    Map<Set<NfaState>, DfaState *> &mapping,
-    const Set<NfaState> &states)
+static bool is_same_targets(const List<NfaState> &a, const List<NfaState> &b)
 {
-    if (not mapping.contains(states)) {
-        auto state = dfa.create_state();
-        if (states.is_empty())
-            state->type = dfa::State::Type::Error;
-        auto new_state = arena.construct<DfaState>(states, state);
-        mapping.add(states, new_state);
+    if (a.size() != b.size())
+        return false;
+    for (Index i = 0; i < a.size(); ++i) {
+        if (not(a[i] == b[i]))
+            return false;
     }
-    return mapping.get(states);
+    return true;
 }
 
 static s64 smallest_index_within(
-    const List<nfa::Automaton> &nfas,
+    const List<nfa::Automaton *> &nfas,
     const List<const nfa::Automaton *> &accepting)
 {
     s64 smallest_index = std::numeric_limits<s64>::max();
@@ -290,7 +515,7 @@ static s64 smallest_index_within(
     for (auto nfa : accepting) {
         s64 current_index = -1;
         for (s64 i = 0; i < nfas.size(); ++i) {
-            if (&nfas[i] == nfa) {
+            if (nfas[i] == nfa) {
                 current_index = i;
                 break;
             }
@@ -304,45 +529,127 @@ static s64 smallest_index_within(
     return smallest_index;
 }
 
-static void create_dfa(
-    sigil::Grammar &grammar, const List<nfa::Automaton> &nfas)
+// Successors depend on the automata within the state only, so they are kept
+// by the memo across compiles. Arcs are visited once per state, and bytes
+// reaching the same NFA states as the previous byte share its closure, which
+// is most bytes of a range.
+static void expand(
+    CompileMemo &memo,
+    dfa::Automaton &dfa,
+    CompileMemo::DeterminizedState *determinized,
+    SubsetScratch &scratch,
+    CompileStatistics *statistics)
+{
+    for (auto &targets : scratch.by_char) targets.clear();
+    for (const auto &nfa_state : determinized->nfa_states) {
+        const auto &arcs = nfa_state.nfa->outgoing_arcs(nfa_state.state);
+        for (const auto arc : arcs) {
+            if (arc->is_epsilon())
+                continue;
+            for (auto c = CharSet::first; c <= CharSet::last; ++c) {
+                if (arc->char_set.contains(c))
+                    scratch.by_char[c].add({ nfa_state.nfa, arc->target });
+            }
+        }
+    }
+
+    CompileMemo::DeterminizedState *target = nullptr;
+    for (auto c = CharSet::first; c <= CharSet::last; ++c) {
+        if (c == CharSet::first or
+            not is_same_targets(scratch.by_char[c], scratch.by_char[c - 1])) {
+            scratch.close(scratch.by_char[c]);
+            target = create_or_get_dfa_state(memo, dfa, scratch.closure);
+            if (statistics != nullptr)
+                ++statistics->closure_count;
+        }
+
+        // Only arcs leaving the current state can be extended
+        CompileMemo::Successor *successor = nullptr;
+        for (auto &candidate : determinized->successors) {
+            if (candidate.target == target) {
+                successor = &candidate;
+                break;
+            }
+        }
+        if (successor == nullptr) {
+            determinized->successors.add({ target, CharSet(c) });
+            successor =
+                &determinized->successors[determinized->successors.size() - 1];
+        }
+        successor->char_set.set(c, true);
+    }
+    determinized->expanded = true;
+}
+
+// What a DFA state takes during compilation and in a transition table
+static Size estimated_bytes(const CompileMemo::DeterminizedState &state)
 {
-    auto &dfa = grammar.dfa();
-    Map<Set<NfaState>, DfaState *> mapping;
-    List<DfaState *> dfa_state_queue;
+    constexpr auto char_count = std::numeric_limits<u8>::max() + 1;
+    constexpr auto arc_bytes =
+        sizeof(dfa::Arc) + sizeof(CompileMemo::Successor);
+    // The set is stored in the state and as key of the memo
+    return sizeof(CompileMemo::DeterminizedState) + sizeof(dfa::State) +
+           2 * state.nfa_states.size() * sizeof(NfaState) +
+           state.successors.size() * arc_bytes + char_count * sizeof(State);
+}
 
-    auto *dfa_start = create_or_get_dfa_state(
-        grammar.arena(),
-        dfa,
-        mapping,
-        reachable_by_epsilon(dfa_start_state(dfa, mapping, nfas)));
-    dfa_start->dfa_state->start = true;
-    dfa_state_queue.add(dfa_start);
+static Either<CompileError, Size> create_dfa(
+    sigil::Grammar &grammar,
+    const Specification &specification,
+    const List<nfa::Automaton *> &nfas,
+    CompileMemo &memo,
+    CompileStatistics *statistics)
+{
+    using Result = Either<CompileError, Size>;
+    auto &dfa = grammar.dfa();
+    Size bytes = 0;
+    List<CompileMemo::DeterminizedState *> dfa_state_queue;
+    SubsetScratch scratch(nfas);
+
+    // All modes share one automaton, states reachable from several start
+    // states are only created once
+    for (Mode mode = 0; mode < specification.modes().size(); ++mode) {
+        scratch.close(dfa_start_state(specification, nfas, mode));
+        auto *dfa_start = create_or_get_dfa_state(memo, dfa, scratch.closure);
+        dfa.add_start_state(dfa_start->dfa_state);
+        if (not dfa_start->queued) {
+            dfa_start->queued = true;
+            dfa_state_queue.add(dfa_start);
+        }
+    }
 
     for (Index i = 0; i < dfa_state_queue.size(); ++i) {
         auto dfa_state = dfa_state_queue[i];
+        if (statistics != nullptr) {
+            statistics->largest_nfa_state_set = std::max(
+                statistics->largest_nfa_state_set,
+                dfa_state->nfa_states.size());
+        }
 
-        for (auto c = CharSet::first; c <= CharSet::last; ++c) {
-            auto reachable = reachable_by_epsilon(
-                reachable_by_char(dfa_state->nfa_states, c));
-            auto new_state = create_or_get_dfa_state(
-                grammar.arena(), dfa, mapping, reachable);
-            if (not dfa_state_queue.contains(new_state))
-                dfa_state_queue.add(new_state);
+        if (dfa_state->expanded) {
+            if (statistics != nullptr)
+                ++statistics->reused_dfa_state_count;
+        } else {
+            expand(memo, dfa, dfa_state, scratch, statistics);
+        }
 
-            dfa::Arc *arc_between = nullptr;
-            for (auto arc : dfa.arcs()) {
-                if (arc->origin == dfa_state->dfa_state and
-                    arc->target == new_state->dfa_state) {
-                    arc_between = arc;
-                    break;
-                }
-            }
-            if (arc_between == nullptr) {
-                arc_between = dfa.create_arc(
-                    dfa_state->dfa_state, new_state->dfa_state, CharSet(c));
+        bytes += estimated_bytes(*dfa_state);
+        if (dfa.states().size() > specification.dfa_state_budget() or
+            bytes > specification.dfa_byte_budget())
+            return Result::left(CompileError {
+                CompileError::Kind::DfaBudgetExceeded,
+                Grammar::dfa_budget_exceeded(),
+            });
+
+        for (auto &successor : dfa_state->successors) {
+            auto new_state = successor.target;
+            create_dfa_state(memo, dfa, new_state);
+            if (not new_state->queued) {
+                new_state->queued = true;
+                dfa_state_queue.add(new_state);
             }
-            arc_between->char_set.set(c, true);
+            dfa.create_arc(
+                dfa_state->dfa_state, new_state->dfa_state, successor.char_set);
         }
 
         // @TODO: Optimize Set and Map
@@ -350,7 +657,8 @@ static void create_dfa(
 
         using Type = dfa::State::Type;
         if (Type::Error != dfa_state->dfa_state->type) {
-            List<const nfa::Automaton *> accepting;
+            auto &accepting = scratch.accepting;
+            accepting.clear();
             for (const auto &nfa_state : dfa_state->nfa_states) {
                 if (nfa_state.state->accepting)
                     accepting.add(nfa_state.nfa);
@@ -363,38 +671,179 @@ static void create_dfa(
             }
         }
     }
+    return Result::right(dfa.states().size());
 }
 
-Either<StringView, Grammar> sigil::Grammar::compile(
-    const sigil::Specification &specification)
+static void collect_statistics(
+    CompileStatistics &statistics,
+    const Grammar &grammar,
+    const List<nfa::Automaton *> &nfas,
+    const RegExpSimplifier &simplifier)
 {
-    using Result = Either<StringView, Grammar>;
-    Grammar grammar;
+    // Parsing is measured within NFA construction
+    statistics.nfa_microseconds -=
+        std::min(statistics.nfa_microseconds, statistics.parse_microseconds);
 
-    List<nfa::Automaton> nfas(specification.tokens().size());
+    statistics.regex_node_count = simplifier.node_count();
+    statistics.scratch_bytes += simplifier.allocated_bytes();
+
+    for (const auto nfa : nfas) {
+        statistics.nfa_state_count += nfa->states().size();
+        statistics.nfa_arc_count += nfa->arcs().size();
+    }
+    statistics.estimated_arena_bytes +=
+        statistics.nfa_state_count * sizeof(nfa::State);
+    statistics.estimated_arena_bytes +=
+        statistics.nfa_arc_count * sizeof(nfa::Arc);
+
+    statistics.dfa_state_count = grammar.dfa().states().size();
+    statistics.dfa_arc_count = grammar.dfa().arcs().size();
+    statistics.estimated_arena_bytes +=
+        statistics.dfa_state_count *
+        (sizeof(dfa::State) + sizeof(CompileMemo::DeterminizedState));
+    statistics.estimated_arena_bytes +=
+        statistics.dfa_arc_count * sizeof(dfa::Arc);
+}
+
+static Either<StringView, Size> create_nfas(
+    List<nfa::Automaton *> &nfas,
+    const Specification &specification,
+    CompileMemo &memo,
+    core::Arena &scratch,
+    RegExpSimplifier &simplifier,
+    CompileStatistics *statistics)
+{
+    using Result = Either<StringView, Size>;
     for (const auto &token_spec : specification.tokens()) {
-        auto either_automaton = create_nfa(grammar.arena(), token_spec);
+        const auto repetition_limit = specification.repetition_limit();
+        if (auto automaton = memo.take_nfa(token_spec, repetition_limit)) {
+            nfas.add(automaton);
+            if (statistics != nullptr)
+                ++statistics->reused_nfa_count;
+            continue;
+        }
+
+        auto either_automaton = create_nfa(
+            memo.arena(),
+            scratch,
+            simplifier,
+            token_spec,
+            repetition_limit,
+            statistics);
         if (not either_automaton.isRight())
             return Result::left(std::move(either_automaton.release_left()));
 
-        auto automaton = std::move(either_automaton.release_right());
-        nfas.add(std::move(automaton));
-        grammar.token_names().add(token_spec.name);
+        nfas.add(memo.add_nfa(
+            token_spec,
+            repetition_limit,
+            std::move(either_automaton.release_right())));
     }
+    return Result::right(nfas.size());
+}
+
+Either<StringView, List<nfa::Automaton *>> sigil::Grammar::compile_nfas(
+    const Specification &specification, CompileMemo &memo)
+{
+    using Result = Either<StringView, List<nfa::Automaton *>>;
+    memo.begin_compile();
+
+    core::Arena scratch;
+    RegExpSimplifier simplifier(scratch);
+    List<nfa::Automaton *> nfas(specification.tokens().size());
+    auto either_error =
+        create_nfas(nfas, specification, memo, scratch, simplifier, nullptr);
+    if (not either_error.isRight())
+        return Result::left(std::move(either_error.release_left()));
+    return Result::right(std::move(nfas));
+}
 
-    create_dfa(grammar, nfas);
+Either<StringView, Grammar> sigil::Grammar::compile(
+    const sigil::Specification &specification, CompileStatistics *statistics)
+{
+    CompileMemo memo;
+    return compile(specification, memo, statistics);
+}
+
+Either<StringView, Grammar> sigil::Grammar::compile(
+    const sigil::Specification &specification,
+    CompileMemo &memo,
+    CompileStatistics *statistics)
+{
+    using Result = Either<StringView, Grammar>;
+    auto either_grammar = compile_checked(specification, memo, statistics);
+    if (not either_grammar.isRight())
+        return Result::left(either_grammar.left().message);
+    return Result::right(std::move(either_grammar.release_right()));
+}
+
+Either<CompileError, Grammar> sigil::Grammar::compile_checked(
+    const sigil::Specification &specification, CompileStatistics *statistics)
+{
+    CompileMemo memo;
+    return compile_checked(specification, memo, statistics);
+}
+
+Either<CompileError, Grammar> sigil::Grammar::compile_checked(
+    const sigil::Specification &specification,
+    CompileMemo &memo,
+    CompileStatistics *statistics)
+{
+    using Result = Either<CompileError, Grammar>;
+    const auto invalid = [](StringView message) {
+        return Result::left(
+            CompileError { CompileError::Kind::Invalid, message });
+    };
+    Grammar grammar;
+    if (statistics != nullptr)
+        *statistics = CompileStatistics();
+    memo.begin_compile();
+
+    // Released on return, only the automata and the DFA outlive the compile
+    core::Arena scratch;
+    // Shared, so that equal subexpressions of different tokens are one node
+    RegExpSimplifier simplifier(scratch);
+    List<nfa::Automaton *> nfas(specification.tokens().size());
+    {
+        PhaseTimer timer(statistics ? &statistics->nfa_microseconds : nullptr);
+        auto either_error = create_nfas(
+            nfas, specification, memo, scratch, simplifier, statistics);
+        if (not either_error.isRight())
+            return invalid(either_error.left());
+        for (const auto &token_spec : specification.tokens())
+            grammar.token_names().add(token_spec.name);
+    }
 
     {
+        PhaseTimer timer(statistics ? &statistics->dfa_microseconds : nullptr);
+        auto either_dfa =
+            create_dfa(grammar, specification, nfas, memo, statistics);
+        if (not either_dfa.isRight())
+            return Result::left(either_dfa.left());
         auto &dfa = grammar.dfa();
         for (auto state : dfa.states()) {
             if (state->is_accepting()) {
                 assert(state->token_index >= 0);
-                auto &token = specification.tokens()[state->token_index];
-                state->token_type = token.token_type;
+                state->token_type =
+                    specification.scanned_token_type(state->token_index);
             }
         }
+
+        for (const auto &keyword : specification.keywords()) {
+            dfa.add_keyword({
+                keyword.keyword,
+                keyword.identifier_token_type,
+                keyword.token_type,
+            });
+        }
+
+        auto either_keywords = KeywordTable::build(dfa.keywords());
+        if (not either_keywords.isRight())
+            return invalid(either_keywords.left());
+        dfa.set_keyword_table(std::move(either_keywords.release_right()));
     }
 
+    if (statistics != nullptr)
+        collect_statistics(*statistics, grammar, nfas, simplifier);
     return Result::right(std::move(grammar));
 }
 
@@ -0,0 +1,177 @@
+//
+// Copyright (c) 2023, Jan Sladek <keddelzz@web.de>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+//
+
+#include <algorithm>  // std::max
+
+#include <sigil/IncrementalScanner.h>
+
+namespace sigil {
+
+IncrementalScanner::IncrementalScanner(ScannerDriver &driver)
+    : m_driver(driver)
+{
+}
+
+void IncrementalScanner::scan(StringView file_path, StringView input, Mode mode)
+{
+    m_file_path = file_path;
+    m_input = input;
+    m_entries.clear();
+
+    m_driver.resume(file_path, input, 0, { 0, 0 }, mode);
+    List<Entry> entries;
+    scan_until_resync(entries, 0, 0, 0);
+    m_entries = std::move(entries);
+}
+
+IncrementalScanner::Change IncrementalScanner::update(
+    StringView input, TextEdit edit)
+{
+    assert(m_entries.non_empty());
+    assert(edit.offset + edit.removed_length <= m_input.size());
+    const auto delta = s64(edit.inserted_length) - s64(edit.removed_length);
+    assert(s64(m_input.size()) + delta == s64(input.size()));
+
+    // Tokens are affected when their scan read edited bytes, or stopped at
+    // the end of input where text is inserted. The scan of the last token
+    // always reaches the end of input.
+    const auto unaffected = [&](const Entry &entry) {
+        return entry.scan_end < edit.offset or
+               (entry.scan_end == edit.offset and
+                edit.offset < m_input.size());
+    };
+    Index first = 0;
+    while (unaffected(m_entries[first])) ++first;
+
+    m_input = input;
+    m_driver.resume(
+        m_file_path,
+        input,
+        scan_start(first),
+        scan_start_position(first),
+        m_entries[first].mode);
+
+    List<Entry> entries(m_entries.size());
+    for (Index i = 0; i < first; ++i) entries.add(m_entries[i]);
+    const auto resync = scan_until_resync(
+        entries, first, delta, edit.offset + edit.removed_length);
+    const Change change {
+        first,
+        resync - first,
+        entries.size() - first,
+    };
+
+    if (resync < m_entries.size()) {
+        const auto old_position = scan_start_position(resync);
+        const auto new_position = entries[entries.size() - 1].end;
+        const auto shift = [&](FilePosition position) {
+            if (position.line == old_position.line)
+                position.column += new_position.column - old_position.column;
+            position.line += new_position.line - old_position.line;
+            return position;
+        };
+
+        for (Index i = resync; i < m_entries.size(); ++i) {
+            auto entry = m_entries[i];
+            entry.offset = u64(s64(entry.offset) + delta);
+            entry.scan_end = u64(s64(entry.scan_end) + delta);
+            entry.first = shift(entry.first);
+            entry.end = shift(entry.end);
+            entries.add(entry);
+        }
+    }
+
+    m_entries = std::move(entries);
+    return change;
+}
+
+Token IncrementalScanner::token(Index index) const
+{
+    const auto &entry = m_entries[index];
+    StringView lexeme;
+    if (entry.type != s32(SpecialTokenType::Eof) and
+        entry.type != s32(SpecialTokenType::Error))
+        lexeme = StringView(m_input.data() + entry.offset, entry.length);
+    return {
+        entry.type,
+        lexeme,
+        { m_file_path, entry.first, entry.end },
+    };
+}
+
+u64 IncrementalScanner::scan_start(Index index) const
+{
+    if (index == 0)
+        return 0;
+    const auto &previous = m_entries[index - 1];
+    return previous.offset + previous.length;
+}
+
+FilePosition IncrementalScanner::scan_start_position(Index index) const
+{
+    if (index == 0)
+        return { 0, 0 };
+    return m_entries[index - 1].end;
+}
+
+// The old tokens are shifted by delta after the edit, a new token lines up
+// with the old token at resync when it ends where the old token's scan
+// started. Everything after that point is scanned exactly as before.
+Index IncrementalScanner::scan_until_resync(
+    List<Entry> &entries, Index resync, s64 delta, u64 after)
+{
+    // The tokens before the restart are the same in entries and m_entries
+    const auto start = scan_start(entries.size());
+    auto previous_end = start;
+    auto furthest = start;
+
+    for (;;) {
+        Entry entry;
+        entry.mode = m_driver.mode();
+        const auto has_token = m_driver.has_next();
+        assert(has_token and "The stream ends in an Eof or Error token");
+        entry.scan_end = m_driver.scan_end();
+        furthest = std::max(furthest, entry.scan_end);
+
+        const auto token = m_driver.next();
+        entry.type = token.type;
+        entry.first = token.range.first;
+        entry.end = token.range.end;
+
+        const auto is_eof = token.type == s32(SpecialTokenType::Eof);
+        const auto is_error = token.type == s32(SpecialTokenType::Error);
+        if (is_eof or is_error) {
+            entry.offset = previous_end;
+            // Nothing after an error is scanned, so any later edit may
+            // change the stream
+            if (is_error)
+                entry.scan_end = m_input.size();
+            entries.add(entry);
+            m_scanned_bytes = furthest - start;
+            return m_entries.size();
+        }
+
+        entry.offset = u64(token.lexeme.data() - m_input.data());
+        entry.length = token.lexeme.size();
+        entries.add(entry);
+        previous_end = entry.offset + entry.length;
+
+        const auto old_end = s64(entry.offset + entry.length) - delta;
+        if (old_end < s64(after))
+            continue;
+        while (resync < m_entries.size() and
+               s64(scan_start(resync)) < old_end)
+            ++resync;
+        if (resync < m_entries.size() and
+            s64(scan_start(resync)) == old_end and
+            m_entries[resync].mode == m_driver.mode()) {
+            m_scanned_bytes = furthest - start;
+            return resync;
+        }
+    }
+}
+
+}  // namespace sigil
@@ -0,0 +1,298 @@
+//
+// Copyright (c) 2023, Jan Sladek <keddelzz@web.de>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+//
+
+#include <sigil/KeywordTable.h>
+
+#include <sigil/Specification.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace sigil {
+
+// Displacements pack (d0, d1) into 16 bits each
+constexpr static Size MaxSlotCount { 1 << 16 };
+constexpr static u64 MaxSeedCount { 64 };
+// A bucket which doesn't fit after this many displacements asks for a seed
+constexpr static u64 MaxDisplacementCount { 1 << 14 };
+
+inline static Size next_power_of_two(Size value)
+{
+    Size result = 1;
+    while (result < value) result *= 2;
+    return result;
+}
+
+inline static Index bucket_of(u64 hash, Size bucket_count)
+{
+    return Index(hash >> 48) & (bucket_count - 1);
+}
+
+// There are at most 2^16 slots, so f1 depends on bits 0-15 of the hash, f2 on
+// bits 32-47 and the bucket on the bits from 48 on
+inline static Index slot_of(u64 hash, u32 displacement, Size slot_count)
+{
+    const auto f1 = u32(hash);
+    const auto f2 = u32(hash >> 32) | 1;
+    const auto d0 = displacement >> 16;
+    const auto d1 = displacement & 0xFFFF;
+    return Index(f1 + d0 * f2 + d1) & (slot_count - 1);
+}
+
+KeywordTable::KeywordTable(
+    u64 seed,
+    Array<TokenType> identifier_token_types,
+    Array<u32> displacements,
+    Array<Entry> entries,
+    Array<char> strings)
+    : m_seed(seed)
+    , m_identifier_token_types(identifier_token_types)
+    , m_displacements(displacements)
+    , m_entries(entries)
+    , m_strings(strings)
+{
+}
+
+KeywordTable::KeywordTable(const Storage &storage)
+    : KeywordTable(
+          storage.seed,
+          Array<TokenType>::list_view(
+              storage.identifier_token_types.to_view()),
+          Array<u32>::list_view(storage.displacements.to_view()),
+          Array<Entry>::list_view(storage.entries.to_view()),
+          Array<char>::list_view(storage.strings.to_view()))
+{
+}
+
+u64 KeywordTable::hash(
+    u64 seed, TokenType identifier_token_type, StringView lexeme)
+{
+    u64 hash = 0xCBF29CE484222325ull ^ seed;
+    hash = (hash ^ u32(identifier_token_type)) * 0x100000001B3ull;
+    for (Index i = 0; i < lexeme.size(); ++i)
+        hash = (hash ^ u8(lexeme[i])) * 0x100000001B3ull;
+
+    // FNV-1a leaves the high bits poorly mixed, finalize like MurmurHash3
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDull;
+    hash ^= hash >> 33;
+    hash *= 0xC4CEB9FE1A85EC53ull;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+// Place the largest buckets first, each with the first displacement that
+// maps all of its keywords to distinct free slots. Fails, if a bucket doesn't
+// fit within MaxDisplacementCount tries.
+static bool displace(
+    const List<u64> &hashes,
+    Size bucket_count,
+    Size slot_count,
+    List<u32> &displacements,
+    List<Index> &slots)
+{
+    // Group the keywords by bucket, members[bucket_begins[b]...] are in b
+    List<Index> bucket_begins(bucket_count + 1);
+    for (Index i = 0; i <= bucket_count; ++i) bucket_begins.add(0);
+    for (const auto hash : hashes)
+        ++bucket_begins[bucket_of(hash, bucket_count) + 1];
+    Size max_bucket_size = 0;
+    for (Index bucket = 0; bucket < bucket_count; ++bucket) {
+        max_bucket_size =
+            std::max(max_bucket_size, bucket_begins[bucket + 1]);
+        bucket_begins[bucket + 1] += bucket_begins[bucket];
+    }
+    List<Index> members(hashes.size());
+    for (Index i = 0; i < hashes.size(); ++i) members.add(0);
+    {
+        List<Index> ends(bucket_count);
+        for (Index i = 0; i < bucket_count; ++i) ends.add(bucket_begins[i]);
+        for (Index i = 0; i < hashes.size(); ++i)
+            members[ends[bucket_of(hashes[i], bucket_count)]++] = i;
+    }
+
+    List<u8> occupied(slot_count);
+    for (Index i = 0; i < slot_count; ++i) occupied.add(0);
+
+    const auto displacement_count =
+        std::min(u64(slot_count) * slot_count, MaxDisplacementCount);
+    for (auto size = max_bucket_size; size > 0; --size) {
+        for (Index bucket = 0; bucket < bucket_count; ++bucket) {
+            const auto begin = bucket_begins[bucket];
+            const auto end = bucket_begins[bucket + 1];
+            if (end - begin != size)
+                continue;
+
+            const auto fits = [&](u32 displacement) {
+                for (auto i = begin; i < end; ++i) {
+                    const auto slot =
+                        slot_of(hashes[members[i]], displacement, slot_count);
+                    if (occupied[slot])
+                        return false;
+                    for (auto j = begin; j < i; ++j) {
+                        if (slot == slots[members[j]])
+                            return false;
+                    }
+                    slots[members[i]] = slot;
+                }
+                return true;
+            };
+
+            bool placed = false;
+            for (u64 i = 0; i < displacement_count and not placed; ++i) {
+                const auto d0 = u32(i / slot_count);
+                const auto d1 = u32(i % slot_count);
+                const auto displacement = (d0 << 16) | d1;
+                if (fits(displacement)) {
+                    displacements[bucket] = displacement;
+                    placed = true;
+                }
+            }
+            if (not placed)
+                return false;
+
+            for (auto i = begin; i < end; ++i) occupied[slots[members[i]]] = 1;
+        }
+    }
+    return true;
+}
+
+Either<StringView, KeywordTable::Storage> KeywordTable::build(
+    const Specification &specification)
+{
+    List<Keyword> keywords(specification.keywords().size());
+    for (const auto &keyword : specification.keywords()) {
+        keywords.add({
+            keyword.keyword,
+            keyword.identifier_token_type,
+            keyword.token_type,
+        });
+    }
+    return build(keywords);
+}
+
+Either<StringView, KeywordTable::Storage> KeywordTable::build(
+    const List<Keyword> &keywords)
+{
+    using Result = Either<StringView, Storage>;
+
+    Storage storage;
+    if (keywords.is_empty())
+        return Result::right(std::move(storage));
+
+    for (const auto &keyword : keywords) {
+        if (keyword.keyword.size() == 0)
+            return Result::left("Keywords must not be empty"sv);
+        if (not storage.identifier_token_types.contains(
+                keyword.identifier_token_type))
+            storage.identifier_token_types.add(keyword.identifier_token_type);
+    }
+
+    // Duplicates hash alike, so only keywords with equal hashes are compared
+    {
+        List<u64> hashes(keywords.size());
+        List<Index> order(keywords.size());
+        for (Index i = 0; i < keywords.size(); ++i) {
+            const auto &keyword = keywords[i];
+            hashes.add(
+                hash(0, keyword.identifier_token_type, keyword.keyword));
+            order.add(i);
+        }
+        std::sort(&order[0], &order[0] + order.size(), [&](Index a, Index b) {
+            return hashes[a] < hashes[b];
+        });
+        for (Index i = 0; i < order.size(); ++i) {
+            const auto &keyword = keywords[order[i]];
+            for (auto j = i + 1;
+                 j < order.size() and hashes[order[j]] == hashes[order[i]];
+                 ++j) {
+                const auto &other = keywords[order[j]];
+                if (other.identifier_token_type ==
+                        keyword.identifier_token_type and
+                    other.keyword == keyword.keyword)
+                    return Result::left("Duplicate keyword"sv);
+            }
+        }
+    }
+
+    // Load factor of at most 0.8, four keywords per bucket on average
+    const auto count = keywords.size();
+    const auto slot_count = next_power_of_two(count + count / 4);
+    const auto bucket_count = next_power_of_two((count + 3) / 4);
+    if (slot_count > MaxSlotCount)
+        return Result::left("Too many keywords"sv);
+
+    List<u64> hashes(count);
+    List<Index> slots(count);
+    for (Index i = 0; i < count; ++i) slots.add(0);
+
+    for (u64 seed = 0; seed < MaxSeedCount; ++seed) {
+        hashes.clear();
+        for (const auto &keyword : keywords) {
+            hashes.add(
+                hash(seed, keyword.identifier_token_type, keyword.keyword));
+        }
+
+        storage.displacements.clear();
+        for (Index i = 0; i < bucket_count; ++i) storage.displacements.add(0);
+        if (not displace(
+                hashes, bucket_count, slot_count, storage.displacements, slots))
+            continue;
+
+        storage.seed = seed;
+        for (Index i = 0; i < slot_count; ++i) storage.entries.add(Entry());
+        for (Index i = 0; i < count; ++i) {
+            const auto &keyword = keywords[i];
+            auto &entry = storage.entries[slots[i]];
+            entry.offset = u32(storage.strings.size());
+            entry.length = u32(keyword.keyword.size());
+            entry.identifier_token_type = keyword.identifier_token_type;
+            entry.token_type = keyword.token_type;
+            for (Index j = 0; j < keyword.keyword.size(); ++j)
+                storage.strings.add(keyword.keyword[j]);
+        }
+        return Result::right(std::move(storage));
+    }
+
+    return Result::left("Could not find a perfect hash for the keywords"sv);
+}
+
+TokenType KeywordTable::max_token_type() const
+{
+    TokenType result = -1;
+    for (Index i = 0; i < m_entries.size(); ++i) {
+        if (m_entries[i].length > 0)
+            result = std::max(result, m_entries[i].token_type);
+    }
+    return result;
+}
+
+TokenType KeywordTable::classify(
+    TokenType identifier_token_type, StringView lexeme) const
+{
+    bool has_keywords = false;
+    for (Index i = 0; i < m_identifier_token_types.size(); ++i) {
+        if (m_identifier_token_types[i] == identifier_token_type) {
+            has_keywords = true;
+            break;
+        }
+    }
+    if (not has_keywords)
+        return identifier_token_type;
+
+    const auto h = hash(m_seed, identifier_token_type, lexeme);
+    const auto displacement =
+        m_displacements[bucket_of(h, m_displacements.size())];
+    const auto &entry = m_entries[slot_of(h, displacement, m_entries.size())];
+    if (entry.identifier_token_type != identifier_token_type or
+        entry.length != lexeme.size())
+        return identifier_token_type;
+    if (memcmp(&m_strings[entry.offset], lexeme.data(), entry.length) != 0)
+        return identifier_token_type;
+    return entry.token_type;
+}
+
+}  // namespace sigil
@@ -0,0 +1,152 @@
+//
+// Copyright (c) 2023, Jan Sladek <keddelzz@web.de>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+//
+
+#include <sigil/LazyDfaScannerDriver.h>
+
+#include <sigil/Grammar.h>
+#include <sigil/Nfa.h>
+
+namespace sigil {
+
+LazyDfaScannerDriver::LazyDfaScannerDriver(
+    CompileMemo memo,
+    List<nfa::Automaton *> nfas,
+    List<TokenType> token_types,
+    List<Set<NfaState>> mode_start_states,
+    KeywordTable::Storage keywords,
+    Size cache_capacity)
+    : ScannerDriver(ScannerCounters::token_type_count(
+          token_types, KeywordTable(keywords)))
+    , m_memo(std::move(memo))
+    , m_nfas(std::move(nfas))
+    , m_token_types(std::move(token_types))
+    , m_mode_start_states(std::move(mode_start_states))
+    , m_keyword_storage(std::move(keywords))
+    , m_keywords(m_keyword_storage)
+    , m_cache_capacity(cache_capacity)
+{
+    flush();
+    m_flush_count = 0;
+}
+
+Either<StringView, LazyDfaScannerDriver> LazyDfaScannerDriver::create(
+    const Specification &specification, Size cache_capacity)
+{
+    using Result = Either<StringView, LazyDfaScannerDriver>;
+    // Room for at least the error state and the start state
+    assert(cache_capacity >= 2);
+
+    CompileMemo memo;
+    auto either_nfas = Grammar::compile_nfas(specification, memo);
+    if (not either_nfas.isRight())
+        return Result::left(std::move(either_nfas.release_left()));
+    auto nfas = std::move(either_nfas.release_right());
+
+    List<TokenType> token_types(nfas.size());
+    for (Index i = 0; i < nfas.size(); ++i)
+        token_types.add(specification.scanned_token_type(i));
+
+    List<Set<NfaState>> mode_start_states(specification.modes().size());
+    for (Mode mode = 0; mode < specification.modes().size(); ++mode) {
+        Set<NfaState> start_states;
+        for (Index i = 0; i < nfas.size(); ++i) {
+            if (specification.tokens()[i].mode == mode)
+                start_states.add({ nfas[i], nfas[i]->start_state() });
+        }
+        mode_start_states.add(reachable_by_epsilon(start_states));
+    }
+
+    auto either_keywords = KeywordTable::build(specification);
+    if (not either_keywords.isRight())
+        return Result::left(either_keywords.left());
+
+    return Result::right(LazyDfaScannerDriver(
+        std::move(memo),
+        std::move(nfas),
+        std::move(token_types),
+        std::move(mode_start_states),
+        std::move(either_keywords.release_right()),
+        cache_capacity));
+}
+
+// Flushing in between tokens is safe, no state ids are held by the driver
+State LazyDfaScannerDriver::start_state(Mode mode) const
+{
+    if (m_flush_pending)
+        flush();
+    if (m_mode_start_ids[mode] == UnknownState) {
+        m_mode_start_ids[mode] =
+            create_or_get_state(m_mode_start_states[mode]);
+    }
+    return m_mode_start_ids[mode];
+}
+
+State LazyDfaScannerDriver::next_state(State state, u8 c) const
+{
+    const auto index = table_index(state, c);
+    if (m_transitions[index] != UnknownState)
+        return m_transitions[index];
+
+    const auto target = create_or_get_state(
+        reachable_by_epsilon(reachable_by_char(m_states[state], c)));
+    m_transitions[index] = target;
+    return target;
+}
+
+State LazyDfaScannerDriver::create_or_get_state(
+    const Set<NfaState> &nfa_states) const
+{
+    if (m_state_ids.contains(nfa_states))
+        return m_state_ids.get(nfa_states);
+
+    // Like Grammar::compile, the token added first wins
+    auto accepting_index = m_nfas.size();
+    for (const auto &nfa_state : nfa_states) {
+        if (not nfa_state.state->accepting)
+            continue;
+        for (Index i = 0; i < accepting_index; ++i) {
+            if (m_nfas[i] == nfa_state.nfa) {
+                accepting_index = i;
+                break;
+            }
+        }
+    }
+
+    const auto state = State(m_states.size());
+    m_states.add(nfa_states);
+    m_state_ids.add(nfa_states, state);
+    m_accepting.add(
+        accepting_index < m_nfas.size() ? m_token_types[accepting_index]
+                                        : s32(SpecialTokenType::Error));
+    constexpr auto char_count = std::numeric_limits<u8>::max() + 1;
+    // The error state is a sink
+    const auto unknown = state == ErrorState ? ErrorState : UnknownState;
+    for (Index i = 0; i < char_count; ++i) m_transitions.add(unknown);
+
+    if (m_states.size() > m_cache_capacity)
+        m_flush_pending = true;
+    return state;
+}
+
+void LazyDfaScannerDriver::flush() const
+{
+    m_state_ids = Map<Set<NfaState>, State>();
+    m_states.clear();
+    m_transitions.clear();
+    m_accepting.clear();
+    m_mode_start_ids.clear();
+    for (Index i = 0; i < m_mode_start_states.size(); ++i)
+        m_mode_start_ids.add(UnknownState);
+    m_flush_pending = false;
+    ++m_flush_count;
+
+    // The error state keeps its id
+    [[maybe_unused]] const auto error_state =
+        create_or_get_state(Set<NfaState>());
+    assert(error_state == ErrorState);
+}
+
+}  // namespace sigil
@@ -0,0 +1,409 @@
+//
+// Copyright (c) 2023, Jan Sladek <keddelzz@web.de>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+//
+
+#include <algorithm>  // std::max, std::min
+#include <cstring>    // memchr, memcmp
+
+#include <core/Arena.h>
+
+#include <sigil/LiteralPrefilter.h>
+
+#include <sigil/RegExp.h>
+#include <sigil/RegexParser.h>
+
+namespace sigil {
+
+constexpr static auto Unbounded = RequiredLiterals::Unbounded;
+
+// What a subexpression contributes to the literals of the whole expression
+struct LiteralInfo
+{
+    /// The expression matches exactly the strings
+    bool exact { false };
+    List<List<u8>> strings;
+    /// Only used if the strings are not exact
+    RequiredLiterals required;
+    u32 max_length { Unbounded };
+};
+
+static u32 add_lengths(u32 a, u32 b)
+{
+    if (a == Unbounded or b == Unbounded)
+        return Unbounded;
+    return u32(std::min(u64(a) + u64(b), u64(Unbounded)));
+}
+
+static Size shortest_size(const List<List<u8>> &strings)
+{
+    auto size = std::numeric_limits<Size>::max();
+    for (const auto &string : strings) size = std::min(size, string.size());
+    return size;
+}
+
+static Size longest_size(const List<List<u8>> &strings)
+{
+    Size size = 0;
+    for (const auto &string : strings) size = std::max(size, string.size());
+    return size;
+}
+
+static void add_unique(List<List<u8>> &strings, const List<u8> &string)
+{
+    if (not strings.contains(string))
+        strings.add(string);
+}
+
+static RequiredLiterals required_of(const LiteralInfo &info)
+{
+    if (not info.exact)
+        return info.required;
+
+    // The empty string would be found everywhere
+    RequiredLiterals required;
+    if (info.strings.is_empty() or shortest_size(info.strings) == 0)
+        return required;
+    required.literals = info.strings;
+    required.max_offset = 0;
+    return required;
+}
+
+// Literals at a bounded offset beat the others, then longer literals, which
+// occur less often
+static bool is_better(const RequiredLiterals &a, const RequiredLiterals &b)
+{
+    if (a.is_empty() or b.is_empty())
+        return b.is_empty() and not a.is_empty();
+    const auto a_bounded = a.max_offset != Unbounded;
+    const auto b_bounded = b.max_offset != Unbounded;
+    if (a_bounded != b_bounded)
+        return a_bounded;
+    return shortest_size(a.literals) > shortest_size(b.literals);
+}
+
+static LiteralInfo analyze(const RegExp *);
+
+static void collect_factors(const RegExp *regex, List<const RegExp *> &factors)
+{
+    if (regex->type() != RegExp::Type::Concatenation) {
+        factors.add(regex);
+        return;
+    }
+
+    const auto concatenation = static_cast<const Concatenation *>(regex);
+    collect_factors(concatenation->left(), factors);
+    collect_factors(concatenation->right(), factors);
+}
+
+static RequiredLiterals with_offset(RequiredLiterals required, u32 offset)
+{
+    required.max_offset = add_lengths(required.max_offset, offset);
+    return required;
+}
+
+// Runs of adjacent exact factors are multiplied out, e.g. `https?://` into
+// "http://" and "https://". The best run or the best required literals of
+// the other factors become the literals of the concatenation.
+static LiteralInfo analyze_concatenation(const RegExp *regex)
+{
+    List<const RegExp *> factors;
+    collect_factors(regex, factors);
+
+    RequiredLiterals best;
+    bool all_exact = true;
+    LiteralInfo run;
+    u32 run_offset = 0;
+    u32 offset = 0;  // The longest prefix before the current factor
+
+    const auto close_run = [&]() {
+        if (not run.exact)
+            return;
+        const auto candidate = with_offset(required_of(run), run_offset);
+        if (is_better(candidate, best))
+            best = candidate;
+        run = LiteralInfo();
+        all_exact = false;
+    };
+
+    for (const auto factor : factors) {
+        auto info = analyze(factor);
+        const auto max_length = info.max_length;
+        const auto fits_run =
+            run.exact and info.exact and
+            run.strings.size() * info.strings.size() <=
+                LiteralPrefilter::MaxLiterals and
+            longest_size(run.strings) + longest_size(info.strings) <=
+                LiteralPrefilter::MaxLiteralSize;
+        if (not info.exact) {
+            close_run();
+            all_exact = false;
+            const auto candidate = with_offset(info.required, offset);
+            if (is_better(candidate, best))
+                best = candidate;
+        } else if (fits_run) {
+            List<List<u8>> product;
+            for (const auto &prefix : run.strings) {
+                for (const auto &suffix : info.strings) {
+                    auto string = prefix;
+                    for (const auto c : suffix) string.add(c);
+                    add_unique(product, string);
+                }
+            }
+            run.strings = std::move(product);
+            run.max_length = add_lengths(run.max_length, info.max_length);
+        } else {
+            close_run();
+            run = std::move(info);
+            run_offset = offset;
+        }
+        offset = add_lengths(offset, max_length);
+    }
+
+    if (all_exact and run.exact)
+        return run;
+    close_run();
+    LiteralInfo result;
+    result.required = std::move(best);
+    result.max_length = offset;
+    return result;
+}
+
+static LiteralInfo analyze_alternative(const Alternative *alternative)
+{
+    const auto left = analyze(alternative->left());
+    const auto right = analyze(alternative->right());
+
+    LiteralInfo result;
+    result.max_length = std::max(left.max_length, right.max_length);
+    if (left.exact and right.exact and
+        left.strings.size() + right.strings.size() <=
+            LiteralPrefilter::MaxLiterals) {
+        result.exact = true;
+        result.strings = left.strings;
+        for (const auto &string : right.strings)
+            add_unique(result.strings, string);
+        return result;
+    }
+
+    // Either side may match, so both have to contribute literals
+    const auto left_required = required_of(left);
+    const auto right_required = required_of(right);
+    if (left_required.is_empty() or right_required.is_empty() or
+        left_required.literals.size() + right_required.literals.size() >
+            LiteralPrefilter::MaxLiterals)
+        return result;
+    result.required.literals = left_required.literals;
+    for (const auto &literal : right_required.literals)
+        add_unique(result.required.literals, literal);
+    result.required.max_offset =
+        std::max(left_required.max_offset, right_required.max_offset);
+    return result;
+}
+
+static LiteralInfo analyze(const RegExp *regex)
+{
+    LiteralInfo result;
+    switch (regex->type()) {
+        case RegExp::Type::Atom: {
+            const auto &char_set = static_cast<const Atom *>(regex)->char_set();
+            result.max_length = 1;
+            for (auto c = CharSet::first; c <= CharSet::last; ++c) {
+                if (not char_set.contains(c))
+                    continue;
+                if (result.strings.size() == LiteralPrefilter::MaxLiterals) {
+                    result.strings.clear();
+                    return result;
+                }
+                List<u8> string;
+                string.add(u8(c));
+                result.strings.add(std::move(string));
+            }
+            result.exact = true;
+            return result;
+        }
+
+        case RegExp::Type::CodePoints:
+            // UTF-8 sequences are at most four bytes long
+            result.max_length = 4;
+            return result;
+
+        case RegExp::Type::Alternative:
+            return analyze_alternative(static_cast<const Alternative *>(regex));
+
+        case RegExp::Type::Concatenation: return analyze_concatenation(regex);
+
+        case RegExp::Type::Kleene: return result;
+
+        case RegExp::Type::PositiveKleene: {
+            const auto exp = static_cast<const PositiveKleene *>(regex)->exp();
+            result.required = required_of(analyze(exp));
+            return result;
+        }
+
+        case RegExp::Type::Optional: {
+            const auto optional = static_cast<const Optional *>(regex);
+            const auto exp = analyze(optional->exp());
+            result.max_length = exp.max_length;
+            if (exp.exact and
+                exp.strings.size() < LiteralPrefilter::MaxLiterals) {
+                result.exact = true;
+                result.strings = exp.strings;
+                add_unique(result.strings, List<u8>());
+            }
+            return result;
+        }
+
+        case RegExp::Type::Repetition: {
+            const auto repetition = static_cast<const Repetition *>(regex);
+            const auto exp = analyze(repetition->exp());
+            if (repetition->min() > 0)
+                result.required = required_of(exp);
+            if (repetition->is_bounded() and exp.max_length != Unbounded) {
+                result.max_length = u32(std::min(
+                    u64(exp.max_length) * repetition->max(), u64(Unbounded)));
+            }
+            return result;
+        }
+
+        case RegExp::Type::Invalid:
+        default: assert(false and "Unreachable"); return result;
+    }
+}
+
+RequiredLiterals LiteralPrefilter::required_literals(const RegExp *regex)
+{
+    return required_of(analyze(regex));
+}
+
+static List<u8> to_literal(StringView string)
+{
+    List<u8> literal(string.size());
+    for (Index i = 0; i < string.size(); ++i) literal.add(u8(string[i]));
+    return literal;
+}
+
+static Either<StringView, RequiredLiterals> token_literals(
+    const Specification::TokenSpec &token, core::Arena &arena)
+{
+    using Result = Either<StringView, RequiredLiterals>;
+
+    LiteralInfo info;
+    if (token.case_sensitivity == CaseSensitivity::Insensitive)
+        return Result::right(required_of(info));
+
+    switch (token.type) {
+        case Specification::TokenSpec::Type::Literal:
+            info.exact = true;
+            info.strings.add(to_literal(token.pattern));
+            break;
+
+        case Specification::TokenSpec::Type::Dictionary:
+            if (token.literals.size() > LiteralPrefilter::MaxLiterals)
+                break;
+            info.exact = true;
+            for (const auto &literal : token.literals)
+                add_unique(info.strings, to_literal(literal));
+            break;
+
+        case Specification::TokenSpec::Type::Regex: {
+            RegexParser parser(arena);
+            parser.initialize(token.pattern);
+            auto either_regex = parser.parse();
+            if (not either_regex.isRight())
+                return Result::left(std::move(either_regex.release_left()));
+            info = analyze(either_regex.right());
+            break;
+        }
+
+        case Specification::TokenSpec::Type::Nfa:
+        case Specification::TokenSpec::Type::Invalid:
+        default: break;
+    }
+    return Result::right(required_of(info));
+}
+
+Either<StringView, LiteralPrefilter> LiteralPrefilter::create(
+    const Specification &specification)
+{
+    using Result = Either<StringView, LiteralPrefilter>;
+
+    core::Arena arena;
+    List<RequiredLiterals> token_required(specification.tokens().size());
+    for (const auto &token : specification.tokens()) {
+        auto either_required = token_literals(token, arena);
+        if (not either_required.isRight())
+            return Result::left(std::move(either_required.release_left()));
+        token_required.add(std::move(either_required.release_right()));
+    }
+
+    LiteralPrefilter prefilter;
+    for (Mode mode = 0; mode < specification.modes().size(); ++mode) {
+        ModeLiterals literals;
+        bool active = true;
+        for (Index i = 0; i < specification.tokens().size(); ++i) {
+            const auto &token = specification.tokens()[i];
+            if (token.mode != mode or
+                specification.is_skipped(token.token_type))
+                continue;
+
+            const auto &required = token_required[i];
+            if (required.is_empty() or required.max_offset == Unbounded) {
+                active = false;
+                break;
+            }
+            for (const auto &literal : required.literals)
+                add_unique(literals.literals, literal);
+            literals.max_offset =
+                std::max(literals.max_offset, required.max_offset);
+        }
+
+        if (not active)
+            literals.literals.clear();
+        for (const auto &literal : literals.literals) {
+            literals.first_bytes.set(literal[0], true);
+            if (literal[0] != literals.literals[0][0])
+                literals.has_single_first_byte = false;
+        }
+        prefilter.m_modes.add(std::move(literals));
+    }
+    return Result::right(std::move(prefilter));
+}
+
+static bool has_literal_at(
+    StringView text, Index offset, const List<List<u8>> &literals)
+{
+    for (const auto &literal : literals) {
+        if (literal.size() <= text.size() - offset and
+            memcmp(text.data() + offset, &literal[0], literal.size()) == 0)
+            return true;
+    }
+    return false;
+}
+
+Index LiteralPrefilter::skip(StringView text, Index from, Mode mode) const
+{
+    if (not is_active(mode))
+        return from;
+
+    const auto &literals = m_modes[mode];
+    const auto first_byte = literals.literals[0][0];
+    for (auto offset = from; offset < text.size(); ++offset) {
+        if (literals.has_single_first_byte) {
+            const auto found = static_cast<const char *>(memchr(
+                text.data() + offset, first_byte, text.size() - offset));
+            if (found == nullptr)
+                break;
+            offset = found - text.data();
+        } else if (not literals.first_bytes.contains(u8(text[offset]))) {
+            continue;
+        }
+
+        if (has_literal_at(text, offset, literals.literals))
+            return offset - std::min(offset - from, Index(literals.max_offset));
+    }
+    return text.size();
+}
+
+}  // namespace sigil
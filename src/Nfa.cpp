@@ -19,12 +19,14 @@ Automaton::~Automaton()
 {
     m_states.clear();
     m_arcs.clear();
+    m_outgoing_arcs.clear();
 }
 
 State *Automaton::create_state()
 {
     auto state = arena().construct<State>(m_states.size());
     m_states.add(state);
+    m_outgoing_arcs.add({});
     return state;
 }
 
@@ -32,6 +34,7 @@ Arc *Automaton::create_epsilon_arc(State *origin, State *target)
 {
     auto arc = arena().construct<Arc>(Arc::Type::Epsilon, origin, target);
     m_arcs.add(arc);
+    m_outgoing_arcs[origin->id].add(arc);
     return arc;
 }
 
@@ -41,6 +44,7 @@ Arc *Automaton::create_character_arc(
     auto arc = arena().construct<Arc>(Arc::Type::CharSet, origin, target);
     arc->char_set = std::move(char_set);
     m_arcs.add(arc);
+    m_outgoing_arcs[origin->id].add(arc);
     return arc;
 }
 
@@ -86,10 +90,7 @@ void Formatter<sigil::nfa::Automaton>::format(
         log_state(b, *state);
         Formatting::format_into(b, "\n");
 
-        for (const auto arc : automaton.arcs()) {
-            if (arc->origin != state)
-                continue;
-
+        for (const auto arc : automaton.outgoing_arcs(state)) {
             format_indentation(b, 2);
             Formatting::format_into(b, "--- ");
 
@@ -0,0 +1,158 @@
+//
+// Copyright (c) 2023, Jan Sladek <keddelzz@web.de>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+//
+
+#include <algorithm>  // std::min
+#include <utility>    // std::swap
+
+#include <sigil/NfaScannerDriver.h>
+
+#include <sigil/Grammar.h>
+#include <sigil/Nfa.h>
+
+namespace sigil {
+
+NfaScannerDriver::NfaScannerDriver(
+    CompileMemo memo,
+    List<TokenType> token_types,
+    KeywordTable::Storage keywords)
+    : ScannerDriver(ScannerCounters::token_type_count(
+          token_types, KeywordTable(keywords)))
+    , m_memo(std::move(memo))
+    , m_token_types(std::move(token_types))
+    , m_keyword_storage(std::move(keywords))
+    , m_keywords(m_keyword_storage)
+{
+}
+
+Either<StringView, NfaScannerDriver> NfaScannerDriver::create(
+    const Specification &specification)
+{
+    using Result = Either<StringView, NfaScannerDriver>;
+
+    CompileMemo memo;
+    auto either_nfas = Grammar::compile_nfas(specification, memo);
+    if (not either_nfas.isRight())
+        return Result::left(std::move(either_nfas.release_left()));
+    const auto nfas = std::move(either_nfas.release_right());
+
+    List<TokenType> token_types(nfas.size());
+    for (Index i = 0; i < nfas.size(); ++i)
+        token_types.add(specification.scanned_token_type(i));
+
+    auto either_keywords = KeywordTable::build(specification);
+    if (not either_keywords.isRight())
+        return Result::left(either_keywords.left());
+
+    NfaScannerDriver driver(
+        std::move(memo),
+        std::move(token_types),
+        std::move(either_keywords.release_right()));
+
+    List<u32> first_states(nfas.size());
+    for (Index i = 0; i < nfas.size(); ++i) {
+        first_states.add(u32(driver.m_accepted_tokens.size()));
+        for (const auto state : nfas[i]->states())
+            driver.m_accepted_tokens.add(state->accepting ? i : nfas.size());
+    }
+
+    for (Index i = 0; i < nfas.size(); ++i) {
+        for (const auto state : nfas[i]->states()) {
+            driver.m_char_arc_offsets.add(driver.m_char_arcs.size());
+            driver.m_epsilon_arc_offsets.add(driver.m_epsilon_arcs.size());
+            for (const auto arc : nfas[i]->outgoing_arcs(state)) {
+                const auto target = u32(first_states[i] + arc->target->id);
+                if (arc->is_epsilon())
+                    driver.m_epsilon_arcs.add(target);
+                else
+                    driver.m_char_arcs.add({ arc->char_set, target });
+            }
+        }
+    }
+    driver.m_char_arc_offsets.add(driver.m_char_arcs.size());
+    driver.m_epsilon_arc_offsets.add(driver.m_epsilon_arcs.size());
+
+    for (Mode mode = 0; mode < specification.modes().size(); ++mode) {
+        List<u32> start_states;
+        for (Index i = 0; i < nfas.size(); ++i) {
+            if (specification.tokens()[i].mode == mode) {
+                start_states.add(
+                    u32(first_states[i] + nfas[i]->start_state()->id));
+            }
+        }
+        driver.m_mode_start_states.add(std::move(start_states));
+    }
+
+    driver.m_current.resize(driver.m_accepted_tokens.size());
+    driver.m_next.resize(driver.m_accepted_tokens.size());
+    return Result::right(std::move(driver));
+}
+
+State NfaScannerDriver::start_state(Mode mode) const
+{
+    m_step_tokens.clear();
+    m_step_tokens.add(s32(SpecialTokenType::Error));
+
+    m_current.clear();
+    for (const auto state : m_mode_start_states[mode])
+        add_closure(m_current, state);
+    if (m_current.is_empty())
+        return ErrorState;
+    return add_step();
+}
+
+State NfaScannerDriver::next_state(State state, u8 c) const
+{
+    assert(state + 1 == m_step_tokens.size() and "Only the latest step");
+
+    m_next.clear();
+    for (const auto source : m_current.values()) {
+        const auto last = m_char_arc_offsets[source + 1];
+        for (auto i = m_char_arc_offsets[source]; i < last; ++i) {
+            const auto &arc = m_char_arcs[i];
+            if (arc.char_set.contains(c))
+                add_closure(m_next, arc.target);
+        }
+    }
+
+    std::swap(m_current, m_next);
+    if (m_current.is_empty())
+        return ErrorState;
+    return add_step();
+}
+
+void NfaScannerDriver::add_closure(SparseSet &set, u32 state) const
+{
+    if (set.contains(state))
+        return;
+
+    // States added to the set are visited in order, without another stack
+    auto i = set.values().size();
+    set.add(state);
+    for (; i < set.values().size(); ++i) {
+        const auto source = set.values()[i];
+        const auto last = m_epsilon_arc_offsets[source + 1];
+        for (auto j = m_epsilon_arc_offsets[source]; j < last; ++j) {
+            const auto target = m_epsilon_arcs[j];
+            if (not set.contains(target))
+                set.add(target);
+        }
+    }
+}
+
+State NfaScannerDriver::add_step() const
+{
+    // Like Grammar::compile, the token added first wins
+    auto accepting_index = m_token_types.size();
+    for (const auto state : m_current.values())
+        accepting_index = std::min(accepting_index, m_accepted_tokens[state]);
+
+    m_step_tokens.add(
+        accepting_index < m_token_types.size() ? m_token_types[accepting_index]
+                                               : s32(SpecialTokenType::Error));
+    return State(m_step_tokens.size() - 1);
+}
+
+}  // namespace sigil
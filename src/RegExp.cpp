@@ -23,6 +23,12 @@ Atom::Atom(CharSet char_set)
 {
 }
 
+CodePoints::CodePoints(CodePointSet code_points)
+    : RegExp(Type::CodePoints)
+    , m_code_points(std::move(code_points))
+{
+}
+
 Alternative::Alternative(RegExp *left, RegExp *right)
     : RegExp(Type::Alternative)
     , m_left(left)
@@ -55,6 +61,15 @@ Optional::Optional(RegExp *exp)
 {
 }
 
+Repetition::Repetition(RegExp *exp, u32 min, u32 max)
+    : RegExp(Type::Repetition)
+    , m_exp(exp)
+    , m_min(min)
+    , m_max(max)
+{
+    assert(min <= max);
+}
+
 }  // namespace sigil
 
 namespace core {
@@ -68,6 +83,12 @@ void Formatter<sigil::RegExp>::format(
             Formatting::format_into(b, "Atom(", exp.char_set(), ")");
         } break;
 
+        case sigil::RegExp::Type::CodePoints: {
+            const auto &exp =
+                reinterpret_cast<const sigil::CodePoints &>(value);
+            Formatting::format_into(b, "CodePoints(", exp.code_points(), ")");
+        } break;
+
         case sigil::RegExp::Type::Alternative: {
             const auto &exp =
                 reinterpret_cast<const sigil::Alternative &>(value);
@@ -98,6 +119,17 @@ void Formatter<sigil::RegExp>::format(
             Formatting::format_into(b, "Optional(", *exp.exp(), ")");
         } break;
 
+        case sigil::RegExp::Type::Repetition: {
+            const auto &exp =
+                reinterpret_cast<const sigil::Repetition &>(value);
+            Formatting::format_into(
+                b, "Repetition(", *exp.exp(), ", ", exp.min(), ", ");
+            if (exp.is_bounded())
+                Formatting::format_into(b, exp.max(), ")");
+            else
+                Formatting::format_into(b, "inf)");
+        } break;
+
         default: assert(false and "Unreachable");
     }
 }
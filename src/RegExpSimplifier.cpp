@@ -0,0 +1,350 @@
+//
+// Copyright (c) 2023, Jan Sladek <keddelzz@web.de>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+//
+
+#include <sigil/RegExpSimplifier.h>
+
+#include <sigil/Hash.h>
+
+#include <type_traits>
+
+namespace sigil {
+
+constexpr static Size InitialTableSize { 64 };
+
+RegExpSimplifier::RegExpSimplifier(core::Arena &arena)
+    : m_arena(arena)
+{
+    for (Index i = 0; i < InitialTableSize; ++i) m_nodes.add(nullptr);
+}
+
+// Children are interned already, so they are compared by identity
+static u64 node_hash(const RegExp *regexp)
+{
+    Hasher hasher;
+    hasher.add_u64(u64(regexp->type()));
+    switch (regexp->type()) {
+        case RegExp::Type::Invalid: assert(false and "Unreachable"); break;
+
+        case RegExp::Type::Atom: {
+            const auto exp = reinterpret_cast<const Atom *>(regexp);
+            for (auto c = CharSet::first; c <= CharSet::last; ++c) {
+                if (exp->char_set().contains(c))
+                    hasher.add_u64(c);
+            }
+        } break;
+
+        case RegExp::Type::CodePoints: {
+            const auto exp = reinterpret_cast<const CodePoints *>(regexp);
+            for (const auto &range : exp->code_points().ranges()) {
+                hasher.add_u64(range.first);
+                hasher.add_u64(range.last);
+            }
+        } break;
+
+        case RegExp::Type::Alternative: {
+            const auto exp = reinterpret_cast<const Alternative *>(regexp);
+            hasher.add_u64(u64(exp->left()));
+            hasher.add_u64(u64(exp->right()));
+        } break;
+
+        case RegExp::Type::Concatenation: {
+            const auto exp = reinterpret_cast<const Concatenation *>(regexp);
+            hasher.add_u64(u64(exp->left()));
+            hasher.add_u64(u64(exp->right()));
+        } break;
+
+        case RegExp::Type::Kleene: {
+            const auto exp = reinterpret_cast<const Kleene *>(regexp);
+            hasher.add_u64(u64(exp->exp()));
+        } break;
+
+        case RegExp::Type::PositiveKleene: {
+            const auto exp = reinterpret_cast<const PositiveKleene *>(regexp);
+            hasher.add_u64(u64(exp->exp()));
+        } break;
+
+        case RegExp::Type::Optional: {
+            const auto exp = reinterpret_cast<const Optional *>(regexp);
+            hasher.add_u64(u64(exp->exp()));
+        } break;
+
+        case RegExp::Type::Repetition: {
+            const auto exp = reinterpret_cast<const Repetition *>(regexp);
+            hasher.add_u64(u64(exp->exp()));
+            hasher.add_u64(exp->min());
+            hasher.add_u64(exp->max());
+        } break;
+    }
+    return hasher.digest();
+}
+
+static bool node_equal(const RegExp *a, const RegExp *b)
+{
+    if (a->type() != b->type())
+        return false;
+
+    switch (a->type()) {
+        case RegExp::Type::Invalid: assert(false and "Unreachable"); break;
+
+        case RegExp::Type::Atom:
+            return reinterpret_cast<const Atom *>(a)->char_set() ==
+                   reinterpret_cast<const Atom *>(b)->char_set();
+
+        case RegExp::Type::CodePoints:
+            return reinterpret_cast<const CodePoints *>(a)->code_points() ==
+                   reinterpret_cast<const CodePoints *>(b)->code_points();
+
+        case RegExp::Type::Alternative: {
+            const auto left = reinterpret_cast<const Alternative *>(a);
+            const auto right = reinterpret_cast<const Alternative *>(b);
+            return left->left() == right->left() and
+                   left->right() == right->right();
+        }
+
+        case RegExp::Type::Concatenation: {
+            const auto left = reinterpret_cast<const Concatenation *>(a);
+            const auto right = reinterpret_cast<const Concatenation *>(b);
+            return left->left() == right->left() and
+                   left->right() == right->right();
+        }
+
+        case RegExp::Type::Kleene:
+            return reinterpret_cast<const Kleene *>(a)->exp() ==
+                   reinterpret_cast<const Kleene *>(b)->exp();
+
+        case RegExp::Type::PositiveKleene:
+            return reinterpret_cast<const PositiveKleene *>(a)->exp() ==
+                   reinterpret_cast<const PositiveKleene *>(b)->exp();
+
+        case RegExp::Type::Optional:
+            return reinterpret_cast<const Optional *>(a)->exp() ==
+                   reinterpret_cast<const Optional *>(b)->exp();
+
+        case RegExp::Type::Repetition: {
+            const auto left = reinterpret_cast<const Repetition *>(a);
+            const auto right = reinterpret_cast<const Repetition *>(b);
+            return left->exp() == right->exp() and
+                   left->min() == right->min() and left->max() == right->max();
+        }
+    }
+    return false;
+}
+
+RegExp *RegExpSimplifier::intern(RegExp *candidate)
+{
+    auto mask = m_nodes.size() - 1;
+    auto slot = Index(node_hash(candidate)) & mask;
+    while (m_nodes[slot] != nullptr) {
+        // The candidate stays behind in the arena
+        if (node_equal(m_nodes[slot], candidate))
+            return m_nodes[slot];
+        slot = (slot + 1) & mask;
+    }
+    m_nodes[slot] = candidate;
+
+    if (++m_node_count * 2 > m_nodes.size()) {
+        List<RegExp *> nodes(m_node_count);
+        for (auto node : m_nodes) {
+            if (node != nullptr)
+                nodes.add(node);
+        }
+
+        const auto size = m_nodes.size() * 2;
+        m_nodes.clear();
+        for (Index i = 0; i < size; ++i) m_nodes.add(nullptr);
+
+        mask = size - 1;
+        for (auto node : nodes) {
+            slot = Index(node_hash(node)) & mask;
+            while (m_nodes[slot] != nullptr) slot = (slot + 1) & mask;
+            m_nodes[slot] = node;
+        }
+    }
+    return candidate;
+}
+
+RegExp *RegExpSimplifier::simplify(const RegExp *regexp)
+{
+    switch (regexp->type()) {
+        case RegExp::Type::Invalid: assert(false and "Unreachable"); break;
+
+        case RegExp::Type::Atom: {
+            const auto exp = reinterpret_cast<const Atom *>(regexp);
+            return create<Atom>(exp->char_set());
+        }
+
+        case RegExp::Type::CodePoints: {
+            const auto exp = reinterpret_cast<const CodePoints *>(regexp);
+            return create<CodePoints>(exp->code_points());
+        }
+
+        case RegExp::Type::Alternative: return create_alternative(regexp);
+
+        case RegExp::Type::Concatenation: return create_concatenation(regexp);
+
+        case RegExp::Type::Kleene: {
+            const auto exp = reinterpret_cast<const Kleene *>(regexp);
+            return create_kleene(simplify(exp->exp()));
+        }
+
+        case RegExp::Type::PositiveKleene: {
+            const auto exp = reinterpret_cast<const PositiveKleene *>(regexp);
+            return create_positive_kleene(simplify(exp->exp()));
+        }
+
+        case RegExp::Type::Optional: {
+            const auto exp = reinterpret_cast<const Optional *>(regexp);
+            return create_optional(simplify(exp->exp()));
+        }
+
+        case RegExp::Type::Repetition: {
+            const auto exp = reinterpret_cast<const Repetition *>(regexp);
+            return create_repetition(
+                simplify(exp->exp()), exp->min(), exp->max());
+        }
+    }
+    return nullptr;
+}
+
+// Operands of a tree of Alternatives or Concatenations, from left to right
+template<typename T, typename Callback>
+static void foreach_operand(const RegExp *regexp, Callback callback)
+{
+    constexpr auto type = std::is_same_v<T, Alternative>
+                              ? RegExp::Type::Alternative
+                              : RegExp::Type::Concatenation;
+    if (regexp->type() != type) {
+        callback(regexp);
+        return;
+    }
+    const auto exp = reinterpret_cast<const T *>(regexp);
+    foreach_operand<T>(exp->left(), callback);
+    foreach_operand<T>(exp->right(), callback);
+}
+
+RegExp *RegExpSimplifier::create_alternative(const RegExp *regexp)
+{
+    CharSet char_set;
+    bool has_char_set = false;
+    CodePointSet code_points;
+    bool has_code_points = false;
+    List<RegExp *> others;
+
+    const auto add = [&](RegExp *exp) {
+        if (exp->type() == RegExp::Type::Atom) {
+            char_set |= reinterpret_cast<const Atom *>(exp)->char_set();
+            has_char_set = true;
+        } else if (exp->type() == RegExp::Type::CodePoints) {
+            code_points |=
+                reinterpret_cast<const CodePoints *>(exp)->code_points();
+            has_code_points = true;
+        } else if (not others.contains(exp)) {
+            others.add(exp);
+        }
+    };
+
+    foreach_operand<Alternative>(regexp, [&](const RegExp *operand) {
+        auto exp = simplify(operand);
+        if (exp->type() == RegExp::Type::Alternative) {
+            // e.g. (a|b){1} simplifies to an alternative itself
+            foreach_operand<Alternative>(exp, [&](const RegExp *nested) {
+                add(const_cast<RegExp *>(nested));
+            });
+        } else {
+            add(exp);
+        }
+    });
+
+    List<RegExp *> alternatives;
+    if (has_char_set)
+        alternatives.add(create<Atom>(std::move(char_set)));
+    if (has_code_points)
+        alternatives.add(create<CodePoints>(std::move(code_points)));
+    for (auto exp : others) alternatives.add(exp);
+
+    auto result = alternatives[alternatives.size() - 1];
+    for (auto i = s64(alternatives.size()) - 2; i >= 0; --i)
+        result = create<Alternative>(alternatives[i], result);
+    return result;
+}
+
+RegExp *RegExpSimplifier::create_concatenation(const RegExp *regexp)
+{
+    List<RegExp *> factors;
+    foreach_operand<Concatenation>(regexp, [&](const RegExp *operand) {
+        auto exp = simplify(operand);
+        foreach_operand<Concatenation>(exp, [&](const RegExp *nested) {
+            factors.add(const_cast<RegExp *>(nested));
+        });
+    });
+
+    auto result = factors[factors.size() - 1];
+    for (auto i = s64(factors.size()) - 2; i >= 0; --i)
+        result = create<Concatenation>(factors[i], result);
+    return result;
+}
+
+static RegExp *operand(const RegExp *regexp)
+{
+    switch (regexp->type()) {
+        case RegExp::Type::Kleene:
+            return const_cast<RegExp *>(
+                reinterpret_cast<const Kleene *>(regexp)->exp());
+        case RegExp::Type::PositiveKleene:
+            return const_cast<RegExp *>(
+                reinterpret_cast<const PositiveKleene *>(regexp)->exp());
+        case RegExp::Type::Optional:
+            return const_cast<RegExp *>(
+                reinterpret_cast<const Optional *>(regexp)->exp());
+        default: assert(false and "Unreachable"); return nullptr;
+    }
+}
+
+RegExp *RegExpSimplifier::create_kleene(RegExp *exp)
+{
+    switch (exp->type()) {
+        case RegExp::Type::Kleene: return exp;
+        case RegExp::Type::PositiveKleene:
+        case RegExp::Type::Optional: return create<Kleene>(operand(exp));
+        default: return create<Kleene>(exp);
+    }
+}
+
+RegExp *RegExpSimplifier::create_positive_kleene(RegExp *exp)
+{
+    switch (exp->type()) {
+        case RegExp::Type::Kleene:
+        case RegExp::Type::PositiveKleene: return exp;
+        case RegExp::Type::Optional: return create<Kleene>(operand(exp));
+        default: return create<PositiveKleene>(exp);
+    }
+}
+
+RegExp *RegExpSimplifier::create_optional(RegExp *exp)
+{
+    switch (exp->type()) {
+        case RegExp::Type::Kleene:
+        case RegExp::Type::Optional: return exp;
+        case RegExp::Type::PositiveKleene: return create<Kleene>(operand(exp));
+        default: return create<Optional>(exp);
+    }
+}
+
+RegExp *RegExpSimplifier::create_repetition(RegExp *exp, u32 min, u32 max)
+{
+    constexpr auto Unbounded = Repetition::Unbounded;
+    if (min == 1 and max == 1)
+        return exp;
+    if (min == 0 and max == 1)
+        return create_optional(exp);
+    if (min == 0 and max == Unbounded)
+        return create_kleene(exp);
+    if (min == 1 and max == Unbounded)
+        return create_positive_kleene(exp);
+    return create<Repetition>(exp, min, max);
+}
+
+}  // namespace sigil
@@ -19,10 +19,12 @@ RegexParser::RegexParser(core::Arena &arena)
 {
 }
 
-void sigil::RegexParser::initialize(StringView input)
+void sigil::RegexParser::initialize(
+    StringView input, CaseSensitivity case_sensitivity)
 {
     m_input = input;
     m_offset = 0;
+    m_fold_case = case_sensitivity == CaseSensitivity::Insensitive;
 }
 
 //
@@ -32,13 +34,21 @@ void sigil::RegexParser::initialize(StringView input)
 //          | <regexp> *
 //          | <regexp> +
 //          | <regexp> ?
+//          | <regexp> { NUMBER }
+//          | <regexp> { NUMBER , }
+//          | <regexp> { NUMBER , NUMBER }
 //          | ( <regexp> )
 //          ;
 //
 // atom ::= CHAR
 //        | CHAR-CLASS
+//        | CODE-POINTS
 //        ;
 //
+// CODE-POINTS ::= \u{hex} | \p{Property} | \P{Property}, which may also
+// appear in character classes. Classes containing code points are matched
+// against UTF-8 encoded input.
+//
 
 Either<StringView, RegExp *> sigil::RegexParser::parse()
 {
@@ -119,7 +129,9 @@ RegExp *RegexParser::parse_postfix()
     if (not result)
         return nullptr;
 
-    const auto is_postfix_operator = [](char c) {
+    const auto is_postfix_operator = [this](char c) {
+        if (c == '{')
+            return can_peek_repetition();
         return '*' == c or '+' == c or '?' == c;
     };
 
@@ -128,13 +140,54 @@ RegExp *RegexParser::parse_postfix()
             case '*': result = create_reg_exp<Kleene>(result); break;
             case '+': result = create_reg_exp<PositiveKleene>(result); break;
             case '?': result = create_reg_exp<Optional>(result); break;
+            case '{': result = parse_repetition(result); break;
             default: assert(false and "Unreachable");
         }
+        if (result == nullptr)
+            return nullptr;
     }
 
     return result;
 }
 
+RegExp *RegexParser::parse_repetition(RegExp *exp)
+{
+    // Counts beyond this are rejected by the expansion limit anyway
+    constexpr u32 MaxCount { 1000000 };
+
+    const auto parse_count = [this](u32 &count) {
+        if (not can_peek() or not between('0', peek(), '9'))
+            return false;
+        count = 0;
+        while (can_peek() and between('0', peek(), '9')) {
+            count = count * 10 + (advance() - '0');
+            if (count > MaxCount)
+                return false;
+        }
+        return true;
+    };
+
+    u32 min = 0;
+    if (not parse_count(min))
+        return nullptr;
+
+    auto max = min;
+    if (can_peek() and peek() == ',') {
+        advance();  // ','
+        max = Repetition::Unbounded;
+        if (can_peek() and peek() != '}' and not parse_count(max))
+            return nullptr;
+    }
+
+    if (not can_peek() or peek() != '}')
+        return nullptr;
+    advance();  // '}'
+
+    if (min > max)
+        return nullptr;
+    return create_reg_exp<Repetition>(exp, min, max);
+}
+
 inline static bool can_be_atom(u8 c)
 {
     if (c == '(' or c == '[')
@@ -175,7 +228,16 @@ RegExp *RegexParser::parse_class_atom()
         advance();
 
     CharSet char_set;
+    CodePointSet code_points;
+    bool has_code_points = false;
     while (peek() != ']') {
+        if (can_peek_code_point_escape()) {
+            if (not parse_class_code_points(code_points))
+                return nullptr;
+            has_code_points = true;
+            continue;
+        }
+
         auto curr = parse_class_chars();
         if (curr.is_empty())
             return nullptr;
@@ -183,19 +245,40 @@ RegExp *RegexParser::parse_class_atom()
     }
     advance();  // ']'
 
+    if (has_code_points) {
+        for (auto c = CharSet::first; c <= CharSet::last; ++c) {
+            if (not char_set.contains(c))
+                continue;
+            // @NOTE: Raw bytes cannot be mixed with code points
+            if (c > 0x7F)
+                return nullptr;
+            code_points.add(c, c);
+        }
+        if (negate)
+            code_points = negated(std::move(code_points));
+        return create_code_points(std::move(code_points));
+    }
+
     if (negate)
-        char_set.negate();
+        char_set = negated(std::move(char_set));
 
-    return create_reg_exp<Atom>(std::move(char_set));
+    return create_atom(std::move(char_set));
 }
 
 RegExp *RegexParser::parse_top_level_atom()
 {
     assert(can_be_top_level_atom(peek()));
+    if (can_peek_code_point_escape()) {
+        CodePointSet code_points;
+        if (not parse_code_point_escape(code_points))
+            return nullptr;
+        return create_code_points(std::move(code_points));
+    }
+
     auto char_set = parse_top_level_chars();
     if (char_set.is_empty())
         return nullptr;
-    return create_reg_exp<Atom>(std::move(char_set));
+    return create_atom(std::move(char_set));
 }
 
 inline static bool can_be_top_level_atom(u8 c)
@@ -221,6 +304,8 @@ inline static bool can_be_top_level_atom(u8 c)
         case '&':
         case '!':
         case '#':
+        case '{':
+        case '}':
         case '\'':
         case '\n':
         case '\r':
@@ -255,6 +340,14 @@ CharSet RegexParser::parse_top_level_chars()
         advance();  // '&'
         return CharSet('&');
     }
+    if (peek() == '{') {
+        advance();  // '{'
+        return CharSet('{');
+    }
+    if (peek() == '}') {
+        advance();  // '}'
+        return CharSet('}');
+    }
     if (peek() == '!') {
         advance();  // '!'
         return CharSet('!');
@@ -307,11 +400,11 @@ CharSet RegexParser::parse_top_level_chars()
             case '#': return CharSet('#');
             case '\'': return CharSet('\'');
             case 'd': return Digit;
-            case 'D': return ~Digit;
+            case 'D': return negated(Digit);
             case 'w': return Word;
-            case 'W': return ~Word;
+            case 'W': return negated(Word);
             case 's': return WhiteSpace;
-            case 'S': return ~WhiteSpace;
+            case 'S': return negated(WhiteSpace);
             case 'u': {
                 if (not can_peek())
                     return {};
@@ -511,6 +604,163 @@ CharSet RegexParser::parse_class_chars()
     return {};
 }
 
+bool RegexParser::can_peek_repetition() const
+{
+    const auto size = s64(m_input.size());
+    if (m_offset < 0 or m_offset >= size or m_input[m_offset] != '{')
+        return false;
+
+    auto offset = m_offset + 1;
+    const auto skip_digits = [&] {
+        const auto first = offset;
+        while (offset < size and between('0', u8(m_input[offset]), '9'))
+            ++offset;
+        return offset > first;
+    };
+
+    if (not skip_digits())
+        return false;
+    if (offset < size and m_input[offset] == ',') {
+        ++offset;
+        skip_digits();
+    }
+    return offset < size and m_input[offset] == '}';
+}
+
+bool RegexParser::can_peek_code_point_escape() const
+{
+    if (m_offset < 0 or m_offset + 2 >= s64(m_input.size()))
+        return false;
+    if (m_input[m_offset] != '\\' or m_input[m_offset + 2] != '{')
+        return false;
+    const auto kind = m_input[m_offset + 1];
+    return kind == 'u' or kind == 'p' or kind == 'P';
+}
+
+bool RegexParser::parse_code_point_escape(CodePointSet &result)
+{
+    assert(can_peek_code_point_escape());
+    advance();  // '\\'
+    const auto kind = advance();
+    advance();  // '{'
+
+    const auto first = m_offset;
+    while (can_peek() and peek() != '}') advance();
+    if (not can_peek())
+        return false;
+    const StringView name { m_input.data() + first, Size(m_offset - first) };
+    advance();  // '}'
+
+    if (kind == 'u') {
+        if (name.size() == 0 or name.size() > 6)
+            return false;
+
+        u32 code_point = 0;
+        for (Index i = 0; i < name.size(); ++i) {
+            u8 digit;
+            if (not unhex(digit, name[i]))
+                return false;
+            code_point = code_point * 16 + digit;
+        }
+        if (code_point > CodePointSet::Last)
+            return false;
+        if (CodePointSet::FirstSurrogate <= code_point and
+            code_point <= CodePointSet::LastSurrogate)
+            return false;
+
+        result.add(code_point, code_point);
+        return true;
+    }
+
+    auto either_property = CodePointSet::unicode_property(name);
+    if (not either_property.isRight())
+        return false;
+
+    auto property = std::move(either_property.release_right());
+    if (kind == 'P')
+        property = negated(std::move(property));
+    result |= property;
+    return true;
+}
+
+bool RegexParser::parse_class_code_points(CodePointSet &result)
+{
+    const auto is_single_code_point =
+        m_input[m_offset + 1] == 'u' and m_input[m_offset + 2] == '{';
+
+    CodePointSet first;
+    if (not parse_code_point_escape(first))
+        return false;
+
+    if (not is_single_code_point or not can_peek() or peek() != '-') {
+        result |= first;
+        return true;
+    }
+
+    advance();  // '-'
+    if (can_peek() and peek() == ']') {
+        result |= first;
+        result.add('-', '-');
+        return true;
+    }
+
+    // @NOTE: Both ends of a code point range have to be \u{hex}
+    if (not can_peek_code_point_escape() or m_input[m_offset + 1] != 'u')
+        return false;
+
+    CodePointSet last;
+    if (not parse_code_point_escape(last))
+        return false;
+
+    const auto a = first.ranges()[0].first;
+    const auto b = last.ranges()[0].first;
+    if (a > b)
+        return false;
+
+    result.add(a, b);
+    return true;
+}
+
+RegExp *RegexParser::create_atom(CharSet char_set)
+{
+    if (m_fold_case)
+        char_set.fold_case();
+    return create_reg_exp<Atom>(std::move(char_set));
+}
+
+RegExp *RegexParser::create_code_points(CodePointSet code_points)
+{
+    if (m_fold_case)
+        code_points.fold_case();
+
+    // Stay with plain atoms for ascii, they need neither lowering nor UTF-8
+    // input
+    const auto &ranges = code_points.ranges();
+    if (ranges.non_empty() and ranges[ranges.size() - 1].last <= 0x7F) {
+        CharSet char_set;
+        for (const auto &range : ranges)
+            char_set.set(u8(range.first), u8(range.last), true);
+        return create_reg_exp<Atom>(std::move(char_set));
+    }
+    return create_reg_exp<CodePoints>(std::move(code_points));
+}
+
+CharSet RegexParser::negated(CharSet char_set) const
+{
+    if (m_fold_case)
+        char_set.fold_case();
+    char_set.negate();
+    return char_set;
+}
+
+CodePointSet RegexParser::negated(CodePointSet code_points) const
+{
+    if (m_fold_case)
+        code_points.fold_case();
+    code_points.negate();
+    return code_points;
+}
+
 bool RegexParser::can_peek() const
 {
     if (m_offset < 0)
@@ -0,0 +1,93 @@
+//
+// Copyright (c) 2023, Jan Sladek <keddelzz@web.de>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+//
+
+#include <sigil/ScanCursor.h>
+
+namespace sigil {
+
+ScanCursor::ScanCursor(
+    const CompiledScanner &scanner, StringView file_path, StringView input)
+    : m_table(&scanner.table())
+    , m_file_path(file_path)
+    , m_input(input)
+{
+}
+
+// The same longest match as ScannerDriver::get_next_token, reading the table
+// directly
+Token ScanCursor::next()
+{
+    constexpr auto char_count = std::numeric_limits<u8>::max() + 1;
+    constexpr auto Error = s32(SpecialTokenType::Error);
+    constexpr auto Skip = s32(SpecialTokenType::Skip);
+
+    const auto error_state = m_table->error_state();
+    const auto transitions = m_table->transitions();
+    const auto accepting = m_table->accepting();
+
+    Position first = m_current;
+    if (m_failed)
+        return { Error, {}, range(first, first) };
+
+    for (;;) {
+        first = m_current;
+        auto current = m_current;
+        auto last = m_current;
+        auto state = m_table->start_state(mode());
+        TokenType last_type = accepting[state];
+
+        while (state != error_state and current.offset < m_input.size()) {
+            const auto c = u8(m_input[current.offset++]);
+            if (c == '\n') {
+                ++current.line;
+                current.column = 0;
+            } else {
+                ++current.column;
+            }
+
+            state = transitions[c + state * char_count];
+            if (accepting[state] != Error) {
+                last = current;
+                last_type = accepting[state];
+            }
+        }
+
+        // An empty skipped token does not make progress, so it's ignored
+        if (last_type == Skip and last.offset == first.offset)
+            last_type = Error;
+        if (last_type == Error) {
+            if (state != error_state)
+                return { s32(SpecialTokenType::Eof), {}, range(first, first) };
+            m_failed = true;
+            return { Error, {}, range(first, first) };
+        }
+
+        m_current = last;
+        if (last_type == Skip)
+            continue;
+
+        StringView lexeme {
+            m_input.data() + first.offset,
+            last.offset - first.offset,
+        };
+        return {
+            m_table->keywords().classify(last_type, lexeme),
+            lexeme,
+            range(first, last),
+        };
+    }
+}
+
+FileRange ScanCursor::range(const Position &first, const Position &last) const
+{
+    return {
+        m_file_path,
+        { s64(first.line), s64(first.column) },
+        { s64(last.line), s64(last.column) },
+    };
+}
+
+}  // namespace sigil
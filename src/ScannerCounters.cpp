@@ -0,0 +1,46 @@
+//
+// Copyright (c) 2023, Jan Sladek <keddelzz@web.de>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+//
+
+#include <sigil/ScannerCounters.h>
+
+#include <algorithm>  // std::max
+
+#include <sigil/KeywordTable.h>
+
+namespace sigil {
+
+ScannerCounters::ScannerCounters(Size token_type_count)
+    : m_token_counts(token_type_count)
+{
+    for (Index i = 0; i < token_type_count; ++i) m_token_counts.add(0);
+}
+
+Size ScannerCounters::token_type_count(
+    const List<TokenType> &token_types, const KeywordTable &keywords)
+{
+    auto max_token_type = keywords.max_token_type();
+    for (const auto token_type : token_types)
+        max_token_type = std::max(max_token_type, token_type);
+    return Size(max_token_type + 1);
+}
+
+void ScannerCounters::reset()
+{
+    m_bytes_scanned = 0;
+    m_bytes_rescanned = 0;
+    m_error_count = 0;
+    for (auto &count : m_token_counts) count = 0;
+    m_state_visits.clear();
+}
+
+u64 ScannerCounters::token_count(TokenType token_type) const
+{
+    if (token_type < 0 or Size(token_type) >= m_token_counts.size())
+        return 0;
+    return m_token_counts[token_type];
+}
+
+}  // namespace sigil
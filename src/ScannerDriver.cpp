@@ -4,10 +4,38 @@
 // SPDX-License-Identifier: BSD-2-Clause
 //
 
+#include <algorithm>  // std::max
+
 #include <sigil/ScannerDriver.h>
 
+#include <sigil/DfaTableScannerDriver.h>
+#include <sigil/Grammar.h>
+#include <sigil/NfaScannerDriver.h>
+
 namespace sigil {
 
+Either<StringView, std::unique_ptr<ScannerDriver>> ScannerDriver::create(
+    const Specification &specification, CompileStatistics *statistics)
+{
+    using Result = Either<StringView, std::unique_ptr<ScannerDriver>>;
+
+    auto either_grammar = Grammar::compile_checked(specification, statistics);
+    if (either_grammar.isRight()) {
+        auto grammar = std::move(either_grammar.release_right());
+        return Result::right(std::make_unique<DfaTableScannerDriver>(
+            DfaTableScannerDriver::create(grammar.dfa(), statistics)));
+    }
+    const auto &error = either_grammar.left();
+    if (error.kind != CompileError::Kind::DfaBudgetExceeded)
+        return Result::left(error.message);
+
+    auto either_driver = NfaScannerDriver::create(specification);
+    if (not either_driver.isRight())
+        return Result::left(either_driver.left());
+    return Result::right(std::make_unique<NfaScannerDriver>(
+        std::move(either_driver.release_right())));
+}
+
 void ScannerDriver::initialize(StringView file_path, StringView input)
 {
     this->m_file_path = file_path;
@@ -20,9 +48,49 @@ void ScannerDriver::initialize(StringView file_path, StringView input)
     m_has_next_token = false;
     m_scan_error = false;
     m_eof_token_returned = false;
+    m_scan_end = 0;
     m_next_token = Token();
 
     while (not m_lookahead.empty()) m_lookahead.consume();
+
+    m_mode_stack[0] = 0;
+    m_mode_depth = 1;
+}
+
+void ScannerDriver::resume(
+    StringView file_path,
+    StringView input,
+    u64 offset,
+    FilePosition position,
+    Mode mode)
+{
+    assert(offset <= input.size());
+    initialize(file_path, input);
+    current.offset = offset;
+    current.line = position.line;
+    current.column = position.column;
+    m_scan_end = offset;
+    m_mode_stack[0] = mode;
+}
+
+void ScannerDriver::set_mode(Mode mode)
+{
+    assert(not m_has_next_token and m_lookahead.empty());
+    m_mode_stack[m_mode_depth - 1] = mode;
+}
+
+void ScannerDriver::push_mode(Mode mode)
+{
+    assert(not m_has_next_token and m_lookahead.empty());
+    assert(m_mode_depth < ModeStackDepth);
+    m_mode_stack[m_mode_depth++] = mode;
+}
+
+void ScannerDriver::pop_mode()
+{
+    assert(not m_has_next_token and m_lookahead.empty());
+    assert(m_mode_depth > 1);
+    --m_mode_depth;
 }
 
 bool ScannerDriver::has_next()
@@ -72,23 +140,49 @@ u8 ScannerDriver::get_char()
 
 void ScannerDriver::get_next_token()
 {
-    State state = start_state();
-    current.state = error_state();
-    last_accepting = current;
-    first_accepting = current;
-
-    if (is_accepting_state(state)) {
-        current.state = state;
-        first_accepting = current;
+    m_scan_end = current.offset;
+    State state;
+    for (;;) {
+        state = start_state(mode());
+        current.state = error_state();
         last_accepting = current;
-    }
-    while (not is_error_state(state) and current.offset < m_input.size()) {
-        auto c = get_char();
-        state = next_state(state, c);
+        first_accepting = current;
+
         if (is_accepting_state(state)) {
             current.state = state;
+            first_accepting = current;
             last_accepting = current;
         }
+        m_counters.visit_state(state);
+        while (not is_error_state(state) and current.offset < m_input.size()) {
+            auto c = get_char();
+            state = next_state(state, c);
+            m_counters.visit_state(state);
+            if (is_accepting_state(state)) {
+                current.state = state;
+                last_accepting = current;
+            }
+        }
+        m_scan_end = std::max(m_scan_end, current.offset);
+
+        if (is_error_state(last_accepting.state)) {
+            m_counters.count_scan(current.offset - first_accepting.offset, 0);
+            break;
+        }
+        m_counters.count_scan(
+            current.offset - first_accepting.offset,
+            current.offset - last_accepting.offset);
+        if (accepting_token(last_accepting.state) !=
+            s32(SpecialTokenType::Skip))
+            break;
+
+        // Skipped tokens are dropped right here, without materializing them.
+        // An empty skipped token does not make progress, so it's ignored.
+        if (last_accepting.offset == first_accepting.offset) {
+            last_accepting.state = error_state();
+            break;
+        }
+        current = last_accepting;
     }
 
     if (not is_error_state(last_accepting.state)) {
@@ -98,7 +192,7 @@ void ScannerDriver::get_next_token()
         };
 
         Token token {
-            accepting_token(last_accepting.state),
+            classify_token(accepting_token(last_accepting.state), lexeme),
             lexeme,
             accepting_range(),
         };
@@ -106,6 +200,7 @@ void ScannerDriver::get_next_token()
         current = last_accepting;
         m_has_next_token = true;
         m_next_token = token;
+        m_counters.count_token(token.type);
     } else {
         if (is_error_state(state)) {
             Token error_token {
@@ -117,6 +212,7 @@ void ScannerDriver::get_next_token()
             m_has_next_token = true;
             m_scan_error = true;
             m_next_token = error_token;
+            m_counters.count_error();
         }
     }
 }
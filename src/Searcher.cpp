@@ -0,0 +1,161 @@
+//
+// Copyright (c) 2023, Jan Sladek <keddelzz@web.de>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+//
+
+#include <utility>  // std::move, std::swap
+
+#include <sigil/Searcher.h>
+
+namespace sigil {
+
+Searcher::Searcher(const StaticTable &table)
+    : Searcher(table, LiteralPrefilter())
+{
+}
+
+Searcher::Searcher(const StaticTable &table, LiteralPrefilter prefilter)
+    : m_table(table)
+    , m_prefilter(std::move(prefilter))
+{
+    const auto state_count = m_table.accepting().size();
+    for (Index i = 0; i < state_count; ++i) {
+        m_state_steps.add(0);
+        m_state_threads.add(NoThread);
+    }
+}
+
+List<SearchMatch> Searcher::find_all(StringView text, Mode mode)
+{
+    const auto start_state = m_table.start_state(mode);
+    const auto error_state = m_table.error_state();
+    const auto transitions = m_table.transitions();
+    const auto accepting = m_table.accepting();
+
+    List<SearchMatch> matches;
+    m_running.clear();
+    m_cut = 0;
+    Index position = 0;
+    for (;;) {
+        if (m_running.is_empty()) {
+            // All threads are reported, nothing refers to them anymore
+            m_threads.clear();
+            m_first = 0;
+            position = m_prefilter.skip(text, position, mode);
+        }
+        if (position == text.size())
+            break;
+
+        start_thread(position, start_state);
+
+        ++m_step;
+        const auto c = u8(text[position]);
+        m_next_running.clear();
+        for (const auto index : m_running) {
+            auto &thread = m_threads[index];
+            const auto state = transitions[table_index(thread.state, c)];
+            if (state == error_state) {
+                thread.state = error_state;
+                continue;
+            }
+            if (m_state_steps[state] == m_step) {
+                thread.state = error_state;
+                thread.merged_into = m_state_threads[state];
+                thread.merged_at = position;
+                continue;
+            }
+
+            m_state_steps[state] = m_step;
+            m_state_threads[state] = index;
+            thread.state = state;
+            const auto type = accepting[state];
+            if (type != s32(SpecialTokenType::Error) and
+                type != s32(SpecialTokenType::Skip)) {
+                thread.end = position + 1;
+                thread.type = type;
+            }
+            m_next_running.add(index);
+        }
+        std::swap(m_running, m_next_running);
+        ++position;
+        report(text, matches);
+    }
+
+    // The end of the text finishes all threads
+    for (const auto index : m_running) m_threads[index].state = error_state;
+    m_running.clear();
+    report(text, matches);
+    ++m_step;
+    return matches;
+}
+
+void Searcher::start_thread(Index position, State start_state)
+{
+    // The `.*` loop: a match may start at every byte
+    const Index index = m_threads.size();
+    m_threads.add({
+        position,
+        position,
+        s32(SpecialTokenType::Error),
+        start_state,
+    });
+
+    // An earlier thread may already be in the start state
+    if (m_state_steps[start_state] == m_step) {
+        auto &thread = m_threads[index];
+        thread.state = m_table.error_state();
+        thread.merged_into = m_state_threads[start_state];
+        thread.merged_at = position;
+        return;
+    }
+    m_state_steps[start_state] = m_step;
+    m_state_threads[start_state] = index;
+    m_running.add(index);
+}
+
+bool Searcher::resolve(Index index, Index &end, TokenType &type) const
+{
+    const auto *thread = &m_threads[index];
+    end = thread->end;
+    type = thread->type;
+    // Each thread of the chain only passes on what it recorded after the
+    // previous one was merged into it
+    while (thread->merged_into != NoThread) {
+        const auto merged_at = thread->merged_at;
+        thread = &m_threads[thread->merged_into];
+        if (thread->has_match() and thread->end > merged_at) {
+            end = thread->end;
+            type = thread->type;
+        }
+    }
+    return thread->state == m_table.error_state();
+}
+
+void Searcher::report(StringView text, List<SearchMatch> &matches)
+{
+    // Threads are ordered by their start, the first thread which might still
+    // match blocks all later matches
+    for (; m_first < m_threads.size(); ++m_first) {
+        const auto &thread = m_threads[m_first];
+        if (thread.start < m_cut)
+            continue;
+
+        Index end = 0;
+        TokenType type = s32(SpecialTokenType::Error);
+        if (not resolve(m_first, end, type))
+            return;
+        if (type == s32(SpecialTokenType::Error))
+            continue;
+
+        StringView lexeme { text.data() + thread.start, end - thread.start };
+        matches.add({
+            m_table.keywords().classify(type, lexeme),
+            thread.start,
+            lexeme,
+        });
+        m_cut = end;
+    }
+}
+
+}  // namespace sigil
@@ -0,0 +1,213 @@
+//
+// Copyright (c) 2023, Jan Sladek <keddelzz@web.de>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+//
+
+#include <algorithm>  // std::min
+#include <cstring>    // memcmp
+
+#ifdef __SSSE3__
+#include <tmmintrin.h>  // _mm_shuffle_epi8
+#endif
+
+#include <sigil/ShuffleScanner.h>
+
+namespace sigil {
+
+using StateMap = ShuffleScanner::StateMap;
+constexpr static auto char_count = std::numeric_limits<u8>::max() + 1;
+
+#ifdef __SSSE3__
+using Vector = __m128i;
+
+static Vector load(const StateMap &map)
+{
+    return _mm_loadu_si128(reinterpret_cast<const __m128i *>(map.next));
+}
+
+static void store(StateMap &map, Vector vector)
+{
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(map.next), vector);
+}
+
+// Every state goes where `first` takes it, then where `then` does
+static Vector compose(Vector first, Vector then)
+{
+    return _mm_shuffle_epi8(then, first);
+}
+#else
+using Vector = StateMap;
+
+static Vector load(const StateMap &map) { return map; }
+
+static void store(StateMap &map, Vector vector) { map = vector; }
+
+static Vector compose(Vector first, Vector then)
+{
+    Vector result;
+    for (Index i = 0; i < ShuffleScanner::MaxStateCount; ++i)
+        result.next[i] = then.next[first.next[i]];
+    return result;
+}
+#endif
+
+static StateMap identity_map()
+{
+    StateMap map;
+    for (Index i = 0; i < ShuffleScanner::MaxStateCount; ++i)
+        map.next[i] = u8(i);
+    return map;
+}
+
+// The token DFA restarts after a token instead of failing, which is only the
+// longest match if a token can't be extended exactly where the table DFA
+// fails. That rules out states which fail without accepting, besides the
+// start state, unless a token leads back into the start state.
+static bool ends_tokens_on_failure(const StaticTable &table, Mode mode)
+{
+    const auto start_state = table.start_state(mode);
+    const auto error_state = table.error_state();
+    const auto transitions = table.transitions();
+    const auto accepting = table.accepting();
+    const auto state_count = accepting.size();
+
+    if (accepting[start_state] != s32(SpecialTokenType::Error))
+        return false;
+
+    bool is_start_reentered = false;
+    for (Index i = 0; i < transitions.size(); ++i)
+        is_start_reentered = is_start_reentered or
+                             transitions[i] == start_state;
+
+    for (State state = 0; state < state_count; ++state) {
+        if (state == error_state or
+            accepting[state] != s32(SpecialTokenType::Error))
+            continue;
+        if (state == start_state and not is_start_reentered)
+            continue;
+        for (Index c = 0; c < char_count; ++c) {
+            if (transitions[c + state * char_count] == error_state)
+                return false;
+        }
+    }
+    return true;
+}
+
+Either<StringView, ShuffleScanner> ShuffleScanner::create(
+    const CompiledScanner &scanner, Mode mode)
+{
+    using Result = Either<StringView, ShuffleScanner>;
+
+    const auto &table = scanner.table();
+    if (table.accepting().size() > MaxStateCount)
+        return Result::left("Too many states for a shuffle scanner"sv);
+    if (not ends_tokens_on_failure(table, mode))
+        return Result::left("Tokens do not end where the DFA fails"sv);
+    return Result::right(ShuffleScanner(scanner, mode));
+}
+
+ShuffleScanner::ShuffleScanner(const CompiledScanner &scanner, Mode mode)
+    : m_scanner(&scanner)
+    , m_mode(mode)
+    , m_start_state(scanner.table().start_state(mode))
+{
+    const auto &table = scanner.table();
+    const auto error_state = table.error_state();
+    const auto transitions = table.transitions();
+    const auto state_count = table.accepting().size();
+
+    for (Index c = 0; c < char_count; ++c) {
+        // States the table doesn't have stay where they are
+        auto map = identity_map();
+        for (State state = 0; state < state_count; ++state) {
+            auto next = transitions[c + state * char_count];
+            if (next == error_state and state != error_state)
+                next = transitions[c + m_start_state * char_count];
+            map.next[state] = u8(next);
+        }
+
+        Index byte_class = 0;
+        while (byte_class < m_class_maps.size() and
+               memcmp(&m_class_maps[byte_class], &map, sizeof(map)) != 0)
+            ++byte_class;
+        if (byte_class == m_class_maps.size())
+            m_class_maps.add(map);
+        m_byte_classes[c] = u8(byte_class);
+    }
+}
+
+StateMap ShuffleScanner::map(StringView text) const
+{
+    const auto advance = [&](Vector map, char c) {
+        return compose(map, load(m_class_maps[m_byte_classes[u8(c)]]));
+    };
+
+    auto map = load(identity_map());
+    for (Index i = 0; i < text.size(); ++i) map = advance(map, text[i]);
+
+    StateMap result;
+    store(result, map);
+    return result;
+}
+
+List<State> ShuffleScanner::chunk_states(
+    StringView input, Size chunk_count) const
+{
+    // Chunks in flight at once, each of them a chain of dependent shuffles
+    constexpr Size Interleave { 4 };
+    const auto advance = [&](Vector map, char c) {
+        return compose(map, load(m_class_maps[m_byte_classes[u8(c)]]));
+    };
+
+    assert(chunk_count > 0);
+    // Nothing depends on the map of the last chunk
+    const auto map_count = chunk_count - 1;
+    List<StateMap> chunk_maps(map_count);
+    for (Index chunk = 0; chunk < map_count; ++chunk)
+        chunk_maps.add(identity_map());
+
+    for (Index first = 0; first < map_count; first += Interleave) {
+        const auto count = std::min(Interleave, map_count - first);
+        const char *data[Interleave];
+        Size sizes[Interleave];
+        Vector maps[Interleave];
+        auto common_size = std::numeric_limits<Size>::max();
+        for (Index i = 0; i < count; ++i) {
+            const auto chunk = first + i;
+            const auto begin = chunk_begin(input.size(), chunk_count, chunk);
+            const auto end = chunk_begin(input.size(), chunk_count, chunk + 1);
+            data[i] = input.data() + begin;
+            sizes[i] = end - begin;
+            maps[i] = load(identity_map());
+            common_size = std::min(common_size, sizes[i]);
+        }
+
+        if (count == Interleave) {
+            for (Index offset = 0; offset < common_size; ++offset) {
+                for (Index i = 0; i < Interleave; ++i)
+                    maps[i] = advance(maps[i], data[i][offset]);
+            }
+        } else {
+            common_size = 0;
+        }
+
+        for (Index i = 0; i < count; ++i) {
+            for (auto offset = common_size; offset < sizes[i]; ++offset)
+                maps[i] = advance(maps[i], data[i][offset]);
+            store(chunk_maps[first + i], maps[i]);
+        }
+    }
+
+    // The prefix over the chunk maps, which are few
+    List<State> states(chunk_count);
+    State state = m_start_state;
+    states.add(state);
+    for (const auto &map : chunk_maps) {
+        state = map.next[state];
+        states.add(state);
+    }
+    return states;
+}
+
+}  // namespace sigil
@@ -8,20 +8,67 @@
 
 #include <core/Formatting.h>
 
+#include <sigil/Hash.h>
+#include <sigil/SpecialTokenType.h>
+
 namespace sigil {
 
-void Specification::add_literal_token(
-    s32 token_type, StringView token_name, StringView exact_string)
+Specification::Specification() { m_modes.add("Default"sv); }
+
+Mode Specification::add_mode(StringView name)
+{
+    m_modes.add(name);
+    return Mode(m_modes.size() - 1);
+}
+
+void Specification::set_mode(Mode mode)
+{
+    assert(m_modes.in_bounds(mode));
+    m_current_mode = mode;
+}
+
+void Specification::skip_token_type(s32 token_type)
+{
+    assert(token_type >= 0);
+    if (not is_skipped(token_type))
+        m_skipped_token_types.add(token_type);
+}
+
+void Specification::add_token(TokenSpec token)
 {
-    auto token = TokenSpec::literal(token_type, token_name, exact_string);
+    token.mode = m_current_mode;
     m_tokens.add(std::move(token));
 }
 
+void Specification::add_literal_token(
+    s32 token_type,
+    StringView token_name,
+    StringView exact_string,
+    CaseSensitivity case_sensitivity)
+{
+    auto token = TokenSpec::literal(
+        token_type, token_name, exact_string, case_sensitivity);
+    add_token(std::move(token));
+}
+
+void Specification::add_literal_tokens(
+    s32 token_type,
+    StringView token_name,
+    core::ListView<StringView> literals)
+{
+    auto token = TokenSpec::dictionary(token_type, token_name, literals);
+    add_token(std::move(token));
+}
+
 void Specification::add_regex_token(
-    s32 token_type, StringView token_name, StringView regex)
+    s32 token_type,
+    StringView token_name,
+    StringView regex,
+    CaseSensitivity case_sensitivity)
 {
-    auto token = TokenSpec::regex(token_type, token_name, regex);
-    m_tokens.add(std::move(token));
+    auto token =
+        TokenSpec::regex(token_type, token_name, regex, case_sensitivity);
+    add_token(std::move(token));
 }
 
 void Specification::add_nfa_token(
@@ -29,28 +76,121 @@ void Specification::add_nfa_token(
     StringView token_name,
     std::function<void(sigil::nfa::Automaton &)> build)
 {
-    auto token = TokenSpec::nfa(token_type, token_name, std::move(build));
-    m_tokens.add(std::move(token));
+    add_nfa_token(token_type, token_name, {}, std::move(build));
+}
+
+void Specification::add_nfa_token(
+    s32 token_type,
+    StringView token_name,
+    StringView cache_key,
+    std::function<void(sigil::nfa::Automaton &)> build)
+{
+    auto token =
+        TokenSpec::nfa(token_type, token_name, cache_key, std::move(build));
+    add_token(std::move(token));
+}
+
+void Specification::add_keyword_token(
+    s32 token_type,
+    StringView token_name,
+    StringView keyword,
+    s32 identifier_token_type)
+{
+    assert(token_type >= 0 and identifier_token_type >= 0);
+    m_keywords.add({ token_type, token_name, keyword, identifier_token_type });
+}
+
+s32 Specification::scanned_token_type(Index token) const
+{
+    const auto token_type = m_tokens[token].token_type;
+    return is_skipped(token_type) ? s32(SpecialTokenType::Skip) : token_type;
+}
+
+bool Specification::is_hashable() const
+{
+    for (const auto &token : m_tokens) {
+        if (TokenSpec::Type::Nfa == token.type and token.cache_key.size() == 0)
+            return false;
+    }
+    return true;
+}
+
+u64 Specification::hash() const
+{
+    assert(is_hashable());
+
+    Hasher hasher;
+    hasher.add_u64(m_modes.size());
+    hasher.add_u64(m_tokens.size());
+    for (const auto &token : m_tokens) {
+        hasher.add_u64(u64(token.type));
+        hasher.add_u64(token.mode);
+        hasher.add_u64(u64(s64(token.token_type)));
+        hasher.add_u64(is_skipped(token.token_type));
+        hasher.add_u64(u64(token.case_sensitivity));
+        hasher.add_string(token.name);
+        if (TokenSpec::Type::Nfa == token.type)
+            hasher.add_string(token.cache_key);
+        else
+            hasher.add_string(token.pattern);
+        hasher.add_u64(token.literals.size());
+        for (const auto &literal : token.literals) hasher.add_string(literal);
+    }
+    hasher.add_u64(m_keywords.size());
+    for (const auto &keyword : m_keywords) {
+        hasher.add_u64(u64(s64(keyword.token_type)));
+        hasher.add_u64(u64(s64(keyword.identifier_token_type)));
+        hasher.add_string(keyword.name);
+        hasher.add_string(keyword.keyword);
+    }
+    // The limits decide whether the specification compiles at all
+    hasher.add_u64(m_repetition_limit);
+    hasher.add_u64(m_dfa_state_budget);
+    hasher.add_u64(m_dfa_byte_budget);
+    return hasher.digest();
 }
 
 Specification::TokenSpec Specification::TokenSpec::literal(
-    s32 token_type, StringView token_name, StringView literal)
+    s32 token_type,
+    StringView token_name,
+    StringView literal,
+    CaseSensitivity case_sensitivity)
 {
-    return { Type::Literal, token_type, token_name, literal, {} };
+    TokenSpec token { Type::Literal, token_type, token_name, literal, {} };
+    token.case_sensitivity = case_sensitivity;
+    return token;
+}
+
+Specification::TokenSpec Specification::TokenSpec::dictionary(
+    s32 token_type,
+    StringView token_name,
+    core::ListView<StringView> literals)
+{
+    TokenSpec token { Type::Dictionary, token_type, token_name, {}, {} };
+    for (const auto &literal : literals) token.literals.add(literal);
+    return token;
 }
 
 Specification::TokenSpec Specification::TokenSpec::regex(
-    s32 token_type, StringView token_name, StringView regex)
+    s32 token_type,
+    StringView token_name,
+    StringView regex,
+    CaseSensitivity case_sensitivity)
 {
-    return { Type::Regex, token_type, token_name, regex, {} };
+    TokenSpec token { Type::Regex, token_type, token_name, regex, {} };
+    token.case_sensitivity = case_sensitivity;
+    return token;
 }
 
 Specification::TokenSpec Specification::TokenSpec::nfa(
     s32 token_type,
     StringView token_name,
+    StringView cache_key,
     std::function<void(sigil::nfa::Automaton &)> build)
 {
-    return { Type::Nfa, token_type, token_name, {}, std::move(build) };
+    return {
+        Type::Nfa, token_type, token_name, {}, std::move(build), cache_key,
+    };
 }
 
 }  // namespace sigil
@@ -64,6 +204,9 @@ void Formatter<sigil::Specification::TokenSpec::Type>::format(
         case sigil::Specification::TokenSpec::Type::Literal:
             Formatting::format_into(b, "Literal");
             break;
+        case sigil::Specification::TokenSpec::Type::Dictionary:
+            Formatting::format_into(b, "Dictionary");
+            break;
         case sigil::Specification::TokenSpec::Type::Regex:
             Formatting::format_into(b, "Regex");
             break;
@@ -86,6 +229,10 @@ void Formatter<sigil::Specification::TokenSpec>::format(
         case sigil::Specification::TokenSpec::Type::Regex:
             Formatting::format_into(b, "`"sv, token_spec.pattern, "`"sv);
             break;
+        case sigil::Specification::TokenSpec::Type::Dictionary:
+            Formatting::format_into(
+                b, "<"sv, token_spec.literals.size(), " literals>"sv);
+            break;
         case sigil::Specification::TokenSpec::Type::Nfa:
             Formatting::format_into(b, "<function>"sv, "`"sv);
             break;
@@ -6,6 +6,8 @@
 
 #include <sigil/StaticTable.h>
 
+#include <algorithm>  // std::max
+
 #include <core/Formatting.h>
 
 namespace sigil {
@@ -22,6 +24,40 @@ StaticTable::StaticTable(
 {
 }
 
+StaticTable::StaticTable(
+    State start_state,
+    State error_state,
+    Array<State> transitions,
+    Array<TokenType> accepting,
+    Array<State> mode_start_states)
+    : StaticTable(start_state, error_state, transitions, accepting)
+{
+    assert(mode_start_states.is_empty() or
+           mode_start_states[0] == start_state);
+    m_mode_start_states = mode_start_states;
+}
+
+StaticTable::StaticTable(
+    State start_state,
+    State error_state,
+    Array<State> transitions,
+    Array<TokenType> accepting,
+    Array<State> mode_start_states,
+    KeywordTable keywords)
+    : StaticTable(
+          start_state, error_state, transitions, accepting, mode_start_states)
+{
+    m_keywords = keywords;
+}
+
+Size StaticTable::token_type_count() const
+{
+    auto max_token_type = m_keywords.max_token_type();
+    for (Index i = 0; i < m_accepting.size(); ++i)
+        max_token_type = std::max(max_token_type, m_accepting[i]);
+    return Size(max_token_type + 1);
+}
+
 }  // namespace sigil
 
 namespace core {
@@ -56,13 +92,42 @@ void Formatter<sigil::StaticTable>::format(
     format_sigil_array(b, "sigil::TokenType"sv, table.accepting());
     Formatting::format_into(b, ";"sv);
 
+    const auto &keywords = table.keywords();
+    const auto has_keywords = keywords.non_empty();
+    // Keywords are passed after the (possibly empty) mode start states
+    const auto has_modes =
+        has_keywords or table.mode_start_states().non_empty();
+    if (has_modes) {
+        Formatting::format_into(b, "const auto mode_start_states = "sv);
+        format_sigil_array(b, "sigil::State"sv, table.mode_start_states());
+        Formatting::format_into(b, ";"sv);
+    }
+
+    if (has_keywords) {
+        Formatting::format_into(
+            b, "const auto keywords = sigil::KeywordTable("sv);
+        Formatting::format_into(b, keywords.seed(), "ull,"sv);
+        format_sigil_array(
+            b, "sigil::TokenType"sv, keywords.identifier_token_types());
+        Formatting::format_into(b, ","sv);
+        format_sigil_array(b, "u32"sv, keywords.displacements());
+        Formatting::format_into(b, ","sv);
+        format_sigil_array(
+            b, "sigil::KeywordTable::Entry"sv, keywords.entries());
+        Formatting::format_into(b, ","sv);
+        format_sigil_array(b, "char"sv, keywords.strings());
+        Formatting::format_into(b, ");"sv);
+    }
+
     Formatting::format_into(
         b,
         "sigil::StaticTable("sv,
         table.start_state(),
         ","sv,
         table.error_state(),
-        ",transitions,accepting);"sv);
+        ",transitions,accepting"sv,
+        has_modes ? ",mode_start_states"sv : ""sv,
+        has_keywords ? ",keywords);"sv : ");"sv);
     Formatting::format_into(b, "})"sv);
 }
 
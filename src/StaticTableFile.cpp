@@ -0,0 +1,620 @@
+//
+// Copyright (c) 2023, Jan Sladek <keddelzz@web.de>
+//
+// SPDX-License-Identifier: BSD-2-Clause
+//
+
+#include <sigil/StaticTableFile.h>
+
+#include <algorithm>  // std::lower_bound, std::sort, std::stable_sort
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <sigil/Hash.h>
+
+namespace sigil {
+
+constexpr static char Magic[8] = { 'S', 'I', 'G', 'I', 'L', 'T', 'B', 'L' };
+constexpr static u32 ByteOrderMark { 0x01020304 };
+constexpr static u16 CharCount { std::numeric_limits<u8>::max() + 1 };
+constexpr static u64 Alignment { 16 };
+
+struct TableFileHeader
+{
+    char magic[8];
+    u32 version;
+    u32 byte_order;
+    u8 state_width;
+    u8 token_type_width;
+    u16 char_count;
+    State start_state;
+    State error_state;
+    u32 state_count;
+    u32 mode_count;  // 0 for single-mode tables
+    u32 keyword_identifier_count;
+    u32 keyword_bucket_count;
+    u32 keyword_slot_count;  // 0 for tables without keywords
+    u32 keyword_strings_size;
+    u32 token_count;
+    u32 token_names_size;
+    u8 reserved[12];  // zero, keeps the header free of implicit padding
+    u64 keyword_seed;
+    u64 specification_hash;
+    u64 transitions_offset;
+    u64 accepting_offset;
+    u64 mode_start_states_offset;
+    u64 keyword_identifiers_offset;
+    u64 keyword_displacements_offset;
+    u64 keyword_entries_offset;
+    u64 keyword_strings_offset;
+    u64 token_entries_offset;
+    u64 token_names_offset;
+    u64 file_size;
+    u64 checksum;  // FNV-1a of the whole file, with this field set to 0
+};
+static_assert(sizeof(TableFileHeader) % Alignment == 0);
+
+inline static u64 align(u64 offset)
+{
+    return (offset + Alignment - 1) / Alignment * Alignment;
+}
+
+static u64 checksum(const u8 *data, Size size)
+{
+    constexpr auto header_size = sizeof(TableFileHeader);
+    TableFileHeader header;
+    memcpy(&header, data, header_size);
+    header.checksum = 0;
+    Hasher hasher;
+    hasher.add_bytes(&header, header_size);
+    hasher.add_bytes(data + header_size, size - header_size);
+    return hasher.digest();
+}
+
+static void add_token_type(List<TokenType> &token_types, TokenType type)
+{
+    if (type >= 0)
+        token_types.add(type);
+}
+
+// Every token type the table can report, named or not, sorted
+static List<TokenType> reported_token_types(
+    const StaticTable &table, core::ListView<TokenName> token_names)
+{
+    List<TokenType> token_types;
+    for (const auto &token_name : token_names)
+        add_token_type(token_types, token_name.token_type);
+    for (Index i = 0; i < table.accepting().size(); ++i)
+        add_token_type(token_types, table.accepting()[i]);
+
+    const auto &keywords = table.keywords();
+    for (Index i = 0; i < keywords.identifier_token_types().size(); ++i)
+        add_token_type(token_types, keywords.identifier_token_types()[i]);
+    for (Index i = 0; i < keywords.entries().size(); ++i) {
+        const auto &entry = keywords.entries()[i];
+        if (entry.length == 0)
+            continue;
+        add_token_type(token_types, entry.identifier_token_type);
+        add_token_type(token_types, entry.token_type);
+    }
+    if (token_types.is_empty())
+        return token_types;
+
+    std::sort(&token_types[0], &token_types[0] + token_types.size());
+    List<TokenType> result(token_types.size());
+    for (const auto type : token_types) {
+        if (result.is_empty() or result[result.size() - 1] != type)
+            result.add(type);
+    }
+    return result;
+}
+
+// Shared types keep the name which comes first
+static List<TokenName> sorted_by_type(core::ListView<TokenName> token_names)
+{
+    List<TokenName> result(token_names.size());
+    for (const auto &token_name : token_names) result.add(token_name);
+    if (result.non_empty()) {
+        std::stable_sort(
+            &result[0],
+            &result[0] + result.size(),
+            [](const TokenName &a, const TokenName &b) {
+                return a.token_type < b.token_type;
+            });
+    }
+    return result;
+}
+
+static List<char> c_string(StringView string)
+{
+    List<char> result(string.size() + 1);
+    for (Index i = 0; i < string.size(); ++i) result.add(string[i]);
+    result.add('\0');
+    return result;
+}
+
+StaticTableFile::StaticTableFile(
+    void *mapping, Size mapping_size, StaticTable table)
+    : m_mapping(mapping)
+    , m_mapping_size(mapping_size)
+    , m_table(table)
+{
+}
+
+StaticTableFile::StaticTableFile(StaticTableFile &&other)
+    : m_mapping(other.m_mapping)
+    , m_mapping_size(other.m_mapping_size)
+    , m_bytes(std::move(other.m_bytes))
+    , m_table(other.m_table)
+    , m_token_entries(other.m_token_entries)
+    , m_token_names(other.m_token_names)
+    , m_specification_hash(other.m_specification_hash)
+{
+    other.m_mapping = nullptr;
+    other.m_mapping_size = 0;
+}
+
+StaticTableFile &StaticTableFile::operator=(StaticTableFile &&other)
+{
+    if (this != &other) {
+        unmap();
+        m_mapping = other.m_mapping;
+        m_mapping_size = other.m_mapping_size;
+        m_bytes = std::move(other.m_bytes);
+        m_table = other.m_table;
+        m_token_entries = other.m_token_entries;
+        m_token_names = other.m_token_names;
+        m_specification_hash = other.m_specification_hash;
+        other.m_mapping = nullptr;
+        other.m_mapping_size = 0;
+    }
+    return *this;
+}
+
+StaticTableFile::~StaticTableFile() { unmap(); }
+
+void StaticTableFile::unmap()
+{
+    if (m_mapping)
+        munmap(m_mapping, m_mapping_size);
+    m_mapping = nullptr;
+    m_mapping_size = 0;
+}
+
+// The entry of the token type in entries sorted by type, or nullptr
+template<typename TokenEntry>
+static const TokenEntry *find_token_entry(
+    const TokenEntry *entries, Size count, TokenType token_type)
+{
+    const auto end = entries + count;
+    const auto entry = std::lower_bound(
+        entries, end, token_type, [](const TokenEntry &entry, TokenType type) {
+            return entry.token_type < type;
+        });
+    if (entry == end or entry->token_type != token_type)
+        return nullptr;
+    return entry;
+}
+
+StringView StaticTableFile::token_name(TokenType token_type) const
+{
+    const auto entry = find_token_entry(
+        static_cast<const TokenEntry *>(m_token_entries.data()),
+        m_token_entries.size(),
+        token_type);
+    if (not entry)
+        return {};
+    const auto names = static_cast<const char *>(m_token_names.data());
+    return { names + entry->offset, entry->length };
+}
+
+List<TokenName> StaticTableFile::token_names(
+    const Specification &specification)
+{
+    List<TokenName> token_names(specification.tokens().size());
+    for (const auto &token : specification.tokens())
+        token_names.add({ token.token_type, token.name });
+    const auto sorted = sorted_by_type(token_names.to_view());
+
+    List<TokenName> result(sorted.size());
+    for (const auto &token_name : sorted) {
+        if (result.is_empty() or
+            result[result.size() - 1].token_type != token_name.token_type)
+            result.add(token_name);
+    }
+    return result;
+}
+
+List<u8> StaticTableFile::serialize(const StaticTable &table)
+{
+    return serialize(table, core::ListView<TokenName>(nullptr, 0));
+}
+
+List<u8> StaticTableFile::serialize(
+    const StaticTable &table,
+    core::ListView<TokenName> token_names,
+    u64 specification_hash)
+{
+    const auto state_count = table.accepting().size();
+    assert(table.transitions().size() == state_count * CharCount);
+
+    const auto transitions_bytes = table.transitions().size() * sizeof(State);
+    const auto accepting_bytes = table.accepting().size() * sizeof(TokenType);
+    const auto mode_count = table.mode_start_states().size();
+    const auto mode_start_states_bytes = mode_count * sizeof(State);
+    const auto &keywords = table.keywords();
+    const auto keyword_identifiers_bytes =
+        keywords.identifier_token_types().size() * sizeof(TokenType);
+    const auto keyword_displacements_bytes =
+        keywords.displacements().size() * sizeof(u32);
+    const auto keyword_entries_bytes =
+        keywords.entries().size() * sizeof(KeywordTable::Entry);
+    const auto keyword_strings_bytes = keywords.strings().size();
+
+    // Both are sorted by type, the names are walked along
+    const auto sorted_names = sorted_by_type(token_names);
+    Index next_name = 0;
+    List<TokenEntry> token_entries;
+    List<char> token_strings;
+    for (const auto token_type : reported_token_types(table, token_names)) {
+        while (next_name < sorted_names.size() and
+               sorted_names[next_name].token_type < token_type)
+            ++next_name;
+        StringView name;
+        if (next_name < sorted_names.size() and
+            sorted_names[next_name].token_type == token_type)
+            name = sorted_names[next_name].name;
+        token_entries.add({
+            token_type,
+            u32(token_strings.size()),
+            u32(name.size()),
+        });
+        for (Index i = 0; i < name.size(); ++i) token_strings.add(name[i]);
+    }
+    const auto token_entries_bytes = token_entries.size() * sizeof(TokenEntry);
+    const auto token_names_bytes = token_strings.size();
+
+    TableFileHeader header {};
+    memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = Version;
+    header.byte_order = ByteOrderMark;
+    header.state_width = sizeof(State);
+    header.token_type_width = sizeof(TokenType);
+    header.char_count = CharCount;
+    header.start_state = table.start_state();
+    header.error_state = table.error_state();
+    header.state_count = u32(state_count);
+    header.mode_count = u32(mode_count);
+    header.keyword_identifier_count =
+        u32(keywords.identifier_token_types().size());
+    header.keyword_bucket_count = u32(keywords.displacements().size());
+    header.keyword_slot_count = u32(keywords.entries().size());
+    header.keyword_strings_size = u32(keywords.strings().size());
+    header.token_count = u32(token_entries.size());
+    header.token_names_size = u32(token_strings.size());
+    header.keyword_seed = keywords.seed();
+    header.specification_hash = specification_hash;
+    header.transitions_offset = sizeof(TableFileHeader);
+    header.accepting_offset =
+        align(header.transitions_offset + transitions_bytes);
+    header.mode_start_states_offset =
+        align(header.accepting_offset + accepting_bytes);
+    header.keyword_identifiers_offset =
+        align(header.mode_start_states_offset + mode_start_states_bytes);
+    header.keyword_displacements_offset =
+        align(header.keyword_identifiers_offset + keyword_identifiers_bytes);
+    header.keyword_entries_offset = align(
+        header.keyword_displacements_offset + keyword_displacements_bytes);
+    header.keyword_strings_offset =
+        align(header.keyword_entries_offset + keyword_entries_bytes);
+    header.token_entries_offset =
+        align(header.keyword_strings_offset + keyword_strings_bytes);
+    header.token_names_offset =
+        align(header.token_entries_offset + token_entries_bytes);
+    header.file_size = align(header.token_names_offset + token_names_bytes);
+
+    List<u8> result(header.file_size);
+    for (Index i = 0; i < header.file_size; ++i) result.add(0);
+
+    const auto copy_into = [&](u64 offset, const void *data, Size size) {
+        if (size > 0)
+            memcpy(&result[offset], data, size);
+    };
+    copy_into(
+        header.transitions_offset,
+        table.transitions().data(),
+        transitions_bytes);
+    copy_into(
+        header.accepting_offset, table.accepting().data(), accepting_bytes);
+    copy_into(
+        header.mode_start_states_offset,
+        table.mode_start_states().data(),
+        mode_start_states_bytes);
+    copy_into(
+        header.keyword_identifiers_offset,
+        keywords.identifier_token_types().data(),
+        keyword_identifiers_bytes);
+    copy_into(
+        header.keyword_displacements_offset,
+        keywords.displacements().data(),
+        keyword_displacements_bytes);
+    copy_into(
+        header.keyword_entries_offset,
+        keywords.entries().data(),
+        keyword_entries_bytes);
+    copy_into(
+        header.keyword_strings_offset,
+        keywords.strings().data(),
+        keyword_strings_bytes);
+    if (token_entries.non_empty()) {
+        copy_into(
+            header.token_entries_offset,
+            &token_entries[0],
+            token_entries_bytes);
+    }
+    if (token_strings.non_empty()) {
+        copy_into(
+            header.token_names_offset, &token_strings[0], token_names_bytes);
+    }
+    copy_into(0, &header, sizeof(TableFileHeader));
+
+    header.checksum = checksum(&result[0], result.size());
+    copy_into(0, &header, sizeof(TableFileHeader));
+    return result;
+}
+
+Either<StringView, Size> StaticTableFile::write(
+    StringView file_path, const StaticTable &table)
+{
+    return write(file_path, table, core::ListView<TokenName>(nullptr, 0));
+}
+
+Either<StringView, Size> StaticTableFile::write(
+    StringView file_path,
+    const StaticTable &table,
+    core::ListView<TokenName> token_names,
+    u64 specification_hash)
+{
+    using Result = Either<StringView, Size>;
+
+    const auto bytes = serialize(table, token_names, specification_hash);
+    const auto path = c_string(file_path);
+    auto file = fopen(&path[0], "wb");
+    if (not file)
+        return Result::left("Could not open table file for writing"sv);
+
+    const auto written = fwrite(&bytes[0], 1, bytes.size(), file);
+    const auto closed = fclose(file) == 0;
+    if (written != bytes.size() or not closed)
+        return Result::left("Could not write table file"sv);
+
+    return Result::right(bytes.size());
+}
+
+Either<StringView, StaticTableFile> StaticTableFile::view(
+    const void *data, Size size, Verification verification)
+{
+    using Result = Either<StringView, StaticTableFile>;
+
+    const auto *bytes = reinterpret_cast<const u8 *>(data);
+    if (size < sizeof(TableFileHeader))
+        return Result::left("Table file is truncated"sv);
+    if (reinterpret_cast<uintptr_t>(data) % alignof(State) != 0)
+        return Result::left("Table image is misaligned"sv);
+
+    TableFileHeader header;
+    memcpy(&header, bytes, sizeof(TableFileHeader));
+    if (memcmp(header.magic, Magic, sizeof(Magic)) != 0)
+        return Result::left("Not a sigil table file"sv);
+    if (header.version != Version)
+        return Result::left("Unsupported table file version"sv);
+    if (header.byte_order != ByteOrderMark)
+        return Result::left("Table file has foreign byte order"sv);
+    if (header.state_width != sizeof(State) or
+        header.token_type_width != sizeof(TokenType) or
+        header.char_count != CharCount)
+        return Result::left("Table file has incompatible widths"sv);
+    if (header.file_size != size)
+        return Result::left("Table file is truncated"sv);
+
+    const u64 state_count = header.state_count;
+    const auto transitions_bytes = state_count * CharCount * sizeof(State);
+    const auto accepting_bytes = state_count * sizeof(TokenType);
+    const auto mode_start_states_bytes = header.mode_count * sizeof(State);
+    const auto keyword_identifiers_bytes =
+        u64(header.keyword_identifier_count) * sizeof(TokenType);
+    const auto keyword_displacements_bytes =
+        u64(header.keyword_bucket_count) * sizeof(u32);
+    const auto keyword_entries_bytes =
+        u64(header.keyword_slot_count) * sizeof(KeywordTable::Entry);
+    const auto keyword_strings_bytes = u64(header.keyword_strings_size);
+    const auto token_entries_bytes =
+        u64(header.token_count) * sizeof(TokenEntry);
+    const auto token_names_bytes = u64(header.token_names_size);
+    const auto is_section = [&](u64 offset, u64 bytes) {
+        return offset % Alignment == 0 and offset <= size and
+               bytes <= size - offset;
+    };
+    if (not is_section(header.transitions_offset, transitions_bytes) or
+        not is_section(header.accepting_offset, accepting_bytes) or
+        not is_section(
+            header.mode_start_states_offset, mode_start_states_bytes) or
+        not is_section(
+            header.keyword_identifiers_offset, keyword_identifiers_bytes) or
+        not is_section(
+            header.keyword_displacements_offset,
+            keyword_displacements_bytes) or
+        not is_section(header.keyword_entries_offset, keyword_entries_bytes) or
+        not is_section(header.keyword_strings_offset, keyword_strings_bytes) or
+        not is_section(header.token_entries_offset, token_entries_bytes) or
+        not is_section(header.token_names_offset, token_names_bytes))
+        return Result::left("Table file is corrupt"sv);
+    if (header.start_state >= state_count or header.error_state >= state_count)
+        return Result::left("Table file is corrupt"sv);
+    if (verification == Verification::Checksum and
+        header.checksum != checksum(bytes, size))
+        return Result::left("Table file checksum mismatch"sv);
+
+    const auto mode_start_states = Array<State>::string_literal(
+        reinterpret_cast<const char *>(
+            bytes + header.mode_start_states_offset),
+        header.mode_count);
+    for (Index i = 0; i < header.mode_count; ++i) {
+        if (mode_start_states[i] >= state_count)
+            return Result::left("Table file is corrupt"sv);
+    }
+    if (header.mode_count > 0 and mode_start_states[0] != header.start_state)
+        return Result::left("Table file is corrupt"sv);
+
+    // A matching checksum only rules out accidents, the scanner drivers index
+    // with every transition and report every accepted token type
+    const auto token_entries = Array<TokenEntry>::string_literal(
+        reinterpret_cast<const char *>(bytes + header.token_entries_offset),
+        header.token_count);
+    for (Index i = 0; i < header.token_count; ++i) {
+        const auto &entry = token_entries[i];
+        if (entry.token_type < 0 or
+            u64(entry.offset) + entry.length > header.token_names_size)
+            return Result::left("Table file is corrupt"sv);
+        if (i > 0 and entry.token_type <= token_entries[i - 1].token_type)
+            return Result::left("Table file is corrupt"sv);
+    }
+    const auto is_token_type = [&](TokenType token_type) {
+        return find_token_entry(
+                   static_cast<const TokenEntry *>(token_entries.data()),
+                   header.token_count,
+                   token_type) != nullptr;
+    };
+
+    const auto transitions = Array<State>::string_literal(
+        reinterpret_cast<const char *>(bytes + header.transitions_offset),
+        state_count * CharCount);
+    for (Index i = 0; i < transitions.size(); ++i) {
+        if (transitions[i] >= state_count)
+            return Result::left("Table file is corrupt"sv);
+    }
+    const auto accepting = Array<TokenType>::string_literal(
+        reinterpret_cast<const char *>(bytes + header.accepting_offset),
+        state_count);
+    for (Index i = 0; i < accepting.size(); ++i) {
+        const auto type = accepting[i];
+        if (type != s32(SpecialTokenType::Error) and
+            type != s32(SpecialTokenType::Skip) and not is_token_type(type))
+            return Result::left("Table file is corrupt"sv);
+    }
+
+    const auto is_power_of_two = [](u32 value) {
+        return value != 0 and (value & (value - 1)) == 0;
+    };
+    if (header.keyword_slot_count > 0 and
+        (not is_power_of_two(header.keyword_slot_count) or
+         not is_power_of_two(header.keyword_bucket_count) or
+         header.keyword_identifier_count == 0))
+        return Result::left("Table file is corrupt"sv);
+
+    const auto keyword_entries = Array<KeywordTable::Entry>::string_literal(
+        reinterpret_cast<const char *>(bytes + header.keyword_entries_offset),
+        header.keyword_slot_count);
+    for (Index i = 0; i < header.keyword_slot_count; ++i) {
+        const auto &entry = keyword_entries[i];
+        if (u64(entry.offset) + entry.length > header.keyword_strings_size)
+            return Result::left("Table file is corrupt"sv);
+        if (entry.length > 0 and
+            (not is_token_type(entry.identifier_token_type) or
+             not is_token_type(entry.token_type)))
+            return Result::left("Table file is corrupt"sv);
+    }
+    const auto keyword_identifiers = Array<TokenType>::string_literal(
+        reinterpret_cast<const char *>(
+            bytes + header.keyword_identifiers_offset),
+        header.keyword_identifier_count);
+    for (Index i = 0; i < keyword_identifiers.size(); ++i) {
+        if (not is_token_type(keyword_identifiers[i]))
+            return Result::left("Table file is corrupt"sv);
+    }
+    const KeywordTable keywords(
+        header.keyword_seed,
+        keyword_identifiers,
+        Array<u32>::string_literal(
+            reinterpret_cast<const char *>(
+                bytes + header.keyword_displacements_offset),
+            header.keyword_bucket_count),
+        keyword_entries,
+        Array<char>::string_literal(
+            reinterpret_cast<const char *>(
+                bytes + header.keyword_strings_offset),
+            header.keyword_strings_size));
+
+    StaticTable table(
+        header.start_state,
+        header.error_state,
+        transitions,
+        accepting,
+        mode_start_states,
+        keywords);
+    StaticTableFile file(nullptr, 0, table);
+    file.m_token_entries = token_entries;
+    file.m_token_names = Array<char>::string_literal(
+        reinterpret_cast<const char *>(bytes + header.token_names_offset),
+        header.token_names_size);
+    file.m_specification_hash = header.specification_hash;
+    return Result::right(std::move(file));
+}
+
+Either<StringView, StaticTableFile> StaticTableFile::adopt(
+    List<u8> bytes, Verification verification)
+{
+    using Result = Either<StringView, StaticTableFile>;
+
+    if (bytes.is_empty())
+        return Result::left("Table file is truncated"sv);
+
+    auto either_file = view(&bytes[0], bytes.size(), verification);
+    if (not either_file.isRight())
+        return Result::left(either_file.left());
+
+    auto file = std::move(either_file.release_right());
+    file.m_bytes = std::move(bytes);
+    return Result::right(std::move(file));
+}
+
+Either<StringView, StaticTableFile> StaticTableFile::map(
+    StringView file_path, Verification verification)
+{
+    using Result = Either<StringView, StaticTableFile>;
+
+    const auto path = c_string(file_path);
+    const auto fd = open(&path[0], O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return Result::left("Could not open table file"sv);
+
+    struct stat status {};
+    if (fstat(fd, &status) != 0 or status.st_size <= 0) {
+        close(fd);
+        return Result::left("Could not stat table file"sv);
+    }
+
+    const auto size = Size(status.st_size);
+    auto mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+        return Result::left("Could not map table file"sv);
+
+    auto either_file = view(mapping, size, verification);
+    if (not either_file.isRight()) {
+        munmap(mapping, size);
+        return Result::left(either_file.left());
+    }
+
+    auto file = std::move(either_file.release_right());
+    file.m_mapping = mapping;
+    file.m_mapping_size = size;
+    return Result::right(std::move(file));
+}
+
+}  // namespace sigil
@@ -9,16 +9,26 @@
 namespace sigil {
 
 StaticTableScannerDriver::StaticTableScannerDriver(const StaticTable &table)
-    : m_start_state(table.start_state())
+    : ScannerDriver(table.token_type_count())
+    , m_start_state(table.start_state())
     , m_error_state(table.error_state())
     , m_transitions(table.transitions())
     , m_accepting(table.accepting())
+    , m_mode_start_states(table.mode_start_states())
+    , m_keywords(table.keywords())
 {
 }
 
 StaticTable StaticTableScannerDriver::static_table() const
 {
-    return { m_start_state, m_error_state, m_transitions, m_accepting };
+    return {
+        m_start_state,
+        m_error_state,
+        m_transitions,
+        m_accepting,
+        m_mode_start_states,
+        m_keywords,
+    };
 }
 
 }  // namespace sigil
@@ -4,14 +4,32 @@
 // SPDX-License-Identifier: BSD-2-Clause
 //
 
+#include <filesystem>
+
 #include <core/Formatting.h>
 #include <core/Test.h>
 
+#include <sigil/BatchScanner.h>
+#include <sigil/BitParallelScannerDriver.h>
 #include <sigil/CharSet.h>
+#include <sigil/CodePointSet.h>
+#include <sigil/CompileCache.h>
+#include <sigil/CompileMemo.h>
+#include <sigil/CompiledScanner.h>
+#include <sigil/DfaScannerDriver.h>
 #include <sigil/DfaSimulation.h>
 #include <sigil/DfaTableScannerDriver.h>
+#include <sigil/IncrementalScanner.h>
+#include <sigil/LazyDfaScannerDriver.h>
+#include <sigil/LiteralPrefilter.h>
+#include <sigil/NfaScannerDriver.h>
 #include <sigil/RegExp.h>
+#include <sigil/RegExpSimplifier.h>
 #include <sigil/RegexParser.h>
+#include <sigil/ScanCursor.h>
+#include <sigil/Searcher.h>
+#include <sigil/ShuffleScanner.h>
+#include <sigil/StaticTableFile.h>
 
 static void char_set_tests()
 {
@@ -343,6 +361,1540 @@ static void user_controlled_token_values()
     expect_eq(scanner.next().type, (s32)sigil::SpecialTokenType::Eof);
 }
 
+static void static_table_file_roundtrip()
+{
+    sigil::Specification specification;
+    specification.add_literal_token(1, "A", "a");
+    specification.add_regex_token(2, "Number", "[0-9]+");
+
+    auto either_grammar = sigil::Grammar::compile(specification);
+    auto grammar = std::move(either_grammar.release_right());
+    auto compiled = sigil::DfaTableScannerDriver::create(grammar.dfa());
+
+    const auto scan = [](sigil::ScannerDriver &scanner) {
+        scanner.initialize("<string>", "a42a");
+        expect_eq(scanner.next().type, 1);
+        expect_eq(scanner.next().type, 2);
+        expect_eq(scanner.next().type, 1);
+        expect_eq(scanner.next().type, (s32)sigil::SpecialTokenType::Eof);
+    };
+
+    auto bytes = sigil::StaticTableFile::serialize(compiled.static_table());
+    {
+        auto either_file =
+            sigil::StaticTableFile::view(&bytes[0], bytes.size());
+        expect_eq(either_file.isRight(), true);
+        auto file = std::move(either_file.release_right());
+        auto scanner = file.scanner_driver();
+        scan(scanner);
+    }
+
+    {
+        auto corrupt = bytes;
+        corrupt[corrupt.size() - 1] ^= 0xFF;
+        // Only the checksum covers the padding
+        expect_eq(
+            sigil::StaticTableFile::view(&corrupt[0], corrupt.size())
+                .isRight(),
+            true);
+        auto either_file = sigil::StaticTableFile::view(
+            &corrupt[0],
+            corrupt.size(),
+            sigil::StaticTableFile::Verification::Checksum);
+        expect_eq(either_file.isRight(), false);
+    }
+
+    {
+        // The checksum matches, but a transition leaves the table
+        const auto &table = compiled.static_table();
+        List<sigil::State> transitions;
+        for (Index i = 0; i < table.transitions().size(); ++i)
+            transitions.add(table.transitions()[i]);
+        transitions[0] = sigil::State(table.accepting().size());
+        const sigil::StaticTable broken(
+            table.start_state(),
+            table.error_state(),
+            sigil::Array<sigil::State>::string_literal(
+                reinterpret_cast<const char *>(&transitions[0]),
+                transitions.size()),
+            table.accepting());
+        auto corrupt = sigil::StaticTableFile::serialize(broken);
+        auto either_file =
+            sigil::StaticTableFile::view(&corrupt[0], corrupt.size());
+        expect_eq(either_file.isRight(), false);
+    }
+
+    {
+        const auto path = "sigil-test-table.bin"sv;
+        const auto token_names =
+            sigil::StaticTableFile::token_names(specification);
+        auto written = sigil::StaticTableFile::write(
+            path, compiled.static_table(), token_names.to_view());
+        expect_eq(written.isRight(), true);
+        auto either_file = sigil::StaticTableFile::map(path);
+        expect_eq(either_file.isRight(), true);
+        auto file = std::move(either_file.release_right());
+        auto scanner = file.scanner_driver();
+        scan(scanner);
+        expect_eq(file.token_count(), 2u);
+        expect_eq(file.token_name(1), "A"sv);
+        expect_eq(file.token_name(2), "Number"sv);
+        expect_eq(file.token_name(3), ""sv);
+        remove("sigil-test-table.bin");
+    }
+
+    {
+        // Names are looked up by type, the first one wins
+        sigil::TokenName token_names[] = {
+            { 2, "Number"sv },
+            { 1, "A"sv },
+            { 1, "Other"sv },
+        };
+        auto named = sigil::StaticTableFile::serialize(
+            compiled.static_table(),
+            core::ListView<sigil::TokenName>(token_names, 3));
+        auto either_file = sigil::StaticTableFile::view(
+            &named[0],
+            named.size(),
+            sigil::StaticTableFile::Verification::Checksum);
+        expect_eq(either_file.isRight(), true);
+        const auto file = std::move(either_file.release_right());
+        expect_eq(file.token_count(), 2u);
+        expect_eq(file.token_name(1), "A"sv);
+        expect_eq(file.token_name(2), "Number"sv);
+        expect_eq(file.token_name(0), ""sv);
+    }
+}
+
+static void compile_cache()
+{
+    const auto specification = [](StringView number) {
+        sigil::Specification result;
+        result.add_literal_token(1, "A", "a");
+        result.add_regex_token(2, "Number", number);
+        return result;
+    };
+    expect_eq(
+        specification("[0-9]+").hash(), specification("[0-9]+").hash());
+    expect_eq(
+        specification("[0-9]+").hash() != specification("[0-9]*").hash(),
+        true);
+    {
+        // The limits decide whether a specification compiles
+        auto limited = specification("[0-9]+");
+        limited.set_repetition_limit(10);
+        expect_eq(limited.hash() != specification("[0-9]+").hash(), true);
+        auto budgeted = specification("[0-9]+");
+        budgeted.set_dfa_budget(100, 1 << 20);
+        expect_eq(budgeted.hash() != specification("[0-9]+").hash(), true);
+    }
+
+    {
+        const auto build = [](sigil::nfa::Automaton &) {};
+        sigil::Specification without_key;
+        without_key.add_nfa_token(1, "Nfa", build);
+        expect_eq(without_key.is_hashable(), false);
+        sigil::Specification with_key;
+        with_key.add_nfa_token(1, "Nfa", "v1", build);
+        expect_eq(with_key.is_hashable(), true);
+    }
+
+    char directory[] = "/tmp/sigil-cache-XXXXXX";
+    expect_eq(mkdtemp(directory) != nullptr, true);
+
+    sigil::CompileCache cache(directory);
+    for (auto i = 0; i < 2; ++i) {
+        auto either_file = cache.load_or_compile(specification("[0-9]+"));
+        expect_eq(either_file.isRight(), true);
+        auto file = std::move(either_file.release_right());
+        auto scanner = file.scanner_driver();
+        scanner.initialize("<string>", "a42");
+        expect_eq(scanner.next().type, 1);
+        expect_eq(scanner.next().type, 2);
+        expect_eq(scanner.next().type, (s32)sigil::SpecialTokenType::Eof);
+        // Only the first call compiles, the second maps its entry
+        expect_eq(cache.compile_count(), Size(1));
+        expect_eq(cache.hit_count(), Size(i));
+        expect_eq(
+            file.specification_hash(), specification("[0-9]+").hash());
+    }
+
+    {
+        // An entry written for another specification is not trusted
+        std::filesystem::path entry;
+        for (const auto &file : std::filesystem::directory_iterator(directory))
+            entry = file.path();
+        const auto other_specification = specification("[0-9]");
+        auto compiled = sigil::CompiledScanner::create(other_specification);
+        const auto entry_path = entry.string();
+        expect_eq(
+            sigil::StaticTableFile::write(
+                StringView(entry_path.data(), entry_path.size()),
+                compiled.right().table(),
+                core::ListView<sigil::TokenName>(nullptr, 0),
+                other_specification.hash())
+                .isRight(),
+            true);
+        sigil::CompileCache stale(directory);
+        expect_eq(
+            stale.load_or_compile(specification("[0-9]+")).isRight(), true);
+        expect_eq(stale.compile_count(), Size(1));
+        expect_eq(stale.hit_count(), Size(0));
+    }
+
+    // Another cache on the same directory finds the entry as well
+    sigil::CompileCache other(directory);
+    expect_eq(other.load_or_compile(specification("[0-9]+")).isRight(), true);
+    expect_eq(other.hit_count(), Size(1));
+    expect_eq(other.compile_count(), Size(0));
+    expect_eq(other.load_or_compile(specification("[0-9]*")).isRight(), true);
+    expect_eq(other.compile_count(), Size(1));
+
+    std::filesystem::remove_all(directory);
+}
+
+static void scanner_modes()
+{
+    enum class Type : s32
+    {
+        Word,
+        Quote,
+        StringChars,
+    };
+
+    sigil::Specification specification;
+    specification.add_regex_token((s32)Type::Word, "Word", "[a-z]+");
+    specification.add_literal_token((s32)Type::Quote, "Quote", "\"");
+    const auto string_mode = specification.add_mode("String");
+    specification.set_mode(string_mode);
+    specification.add_regex_token(
+        (s32)Type::StringChars, "StringChars", "[a-z ]+");
+    specification.add_literal_token((s32)Type::Quote, "Quote", "\"");
+
+    auto either_grammar = sigil::Grammar::compile(specification);
+    auto grammar = std::move(either_grammar.release_right());
+
+    using namespace sigil::dfa;
+    expect_eq(simulate(grammar, "a b"), SimulationResult::error());
+    expect_eq(
+        simulate(grammar, "a b", string_mode),
+        SimulationResult::accept("StringChars"));
+
+    const auto scan = [&](sigil::ScannerDriver &scanner) {
+        scanner.initialize("<string>", "ab\"c d\"e");
+        expect_eq(scanner.next().type, (s32)Type::Word);
+        expect_eq(scanner.next().type, (s32)Type::Quote);
+        scanner.push_mode(string_mode);
+        expect_eq(scanner.next().lexeme, "c d"sv);
+        expect_eq(scanner.next().type, (s32)Type::Quote);
+        scanner.pop_mode();
+        expect_eq(scanner.next().type, (s32)Type::Word);
+        expect_eq(scanner.next().type, (s32)sigil::SpecialTokenType::Eof);
+    };
+
+    auto scanner = sigil::DfaTableScannerDriver::create(grammar.dfa());
+    scan(scanner);
+
+    auto bytes = sigil::StaticTableFile::serialize(scanner.static_table());
+    auto either_file = sigil::StaticTableFile::view(&bytes[0], bytes.size());
+    auto file = std::move(either_file.release_right());
+    expect_eq(file.static_table().mode_count(), 2u);
+    auto mapped_scanner = file.scanner_driver();
+    scan(mapped_scanner);
+}
+
+static void skipped_token_types()
+{
+    enum class Type : s32
+    {
+        Number,
+        Plus,
+        Whitespace,
+        Comment,
+    };
+
+    sigil::Specification specification;
+    specification.add_regex_token((s32)Type::Number, "Number", "[0-9]+");
+    specification.add_literal_token((s32)Type::Plus, "Plus", "+");
+    specification.add_regex_token(
+        (s32)Type::Whitespace, "Whitespace", "[ \\n]+");
+    specification.add_regex_token((s32)Type::Comment, "Comment", "#[a-z ]*");
+    specification.skip_token_type((s32)Type::Whitespace);
+    specification.skip_token_type((s32)Type::Comment);
+
+    auto either_grammar = sigil::Grammar::compile(specification);
+    auto grammar = std::move(either_grammar.release_right());
+    auto scanner = sigil::DfaTableScannerDriver::create(grammar.dfa());
+    scanner.initialize("<string>", " 1 + # one\n 22 ");
+    expect_eq(scanner.next().type, (s32)Type::Number);
+    expect_eq(scanner.next().type, (s32)Type::Plus);
+    const auto number = scanner.next();
+    expect_eq(number.lexeme, "22"sv);
+    expect_eq(number.range.first.line, 1);
+    expect_eq(number.range.first.column, 1);
+    expect_eq(scanner.next().type, (s32)sigil::SpecialTokenType::Eof);
+}
+
+static void unicode_code_points()
+{
+    expect_eq(parse_regex("\\u{41}"), "Atom('A')");
+    expect_eq(parse_regex("\\u{400}"), "CodePoints(U+0400)");
+    expect_eq(
+        parse_regex("[a\\u{400}-\\u{4FF}]"),
+        "CodePoints(U+0061, U+0400 - U+04FF)");
+    expect_eq(parse_regex("\\u{D800}"), "Parse error: Parse error");
+    expect_eq(parse_regex("\\u{110000}"), "Parse error: Parse error");
+    expect_eq(parse_regex("\\p{Unknown}"), "Parse error: Parse error");
+    expect_eq(parse_regex("[\\u{400}\\uFF]"), "Parse error: Parse error");
+
+    const auto letters = sigil::CodePointSet::unicode_property("L");
+    expect_eq(letters.right().contains('a'), true);
+    expect_eq(letters.right().contains(0x416), true);  // Cyrillic Zhe
+    expect_eq(letters.right().contains('1'), false);
+    expect_eq((~letters.right()).contains(0xD800), false);
+
+    const auto sequences = sigil::CodePointSet(0x7F, 0x800).utf8_sequences();
+    expect_eq(sequences.size(), 3u);
+
+    enum class Type : s32
+    {
+        Word,
+        Space,
+    };
+
+    sigil::Specification specification;
+    specification.add_regex_token((s32)Type::Word, "Word", "\\p{L}+");
+    specification.add_regex_token((s32)Type::Space, "Space", " ");
+
+    auto either_grammar = sigil::Grammar::compile(specification);
+    auto grammar = std::move(either_grammar.release_right());
+    auto scanner = sigil::DfaTableScannerDriver::create(grammar.dfa());
+    // "grüß ж日"
+    scanner.initialize(
+        "<string>", "gr\xC3\xBC\xC3\x9F \xD0\xB6\xE6\x97\xA5");
+    expect_eq(scanner.next().lexeme, "gr\xC3\xBC\xC3\x9F"sv);
+    expect_eq(scanner.next().type, (s32)Type::Space);
+    expect_eq(scanner.next().lexeme, "\xD0\xB6\xE6\x97\xA5"sv);
+    expect_eq(scanner.next().type, (s32)sigil::SpecialTokenType::Eof);
+}
+
+static void case_insensitive_tokens()
+{
+    enum class Type : s32
+    {
+        Select,
+        From,
+        Identifier,
+        Space,
+    };
+
+    using sigil::CaseSensitivity;
+    sigil::Specification specification;
+    specification.add_literal_token(
+        (s32)Type::Select, "Select", "select", CaseSensitivity::Insensitive);
+    specification.add_regex_token(
+        (s32)Type::From, "From", "from|f", CaseSensitivity::Insensitive);
+    specification.add_regex_token(
+        (s32)Type::Identifier, "Identifier", "[a-z]+");
+    specification.add_regex_token((s32)Type::Space, "Space", " ");
+
+    auto either_grammar = sigil::Grammar::compile(specification);
+    auto grammar = std::move(either_grammar.release_right());
+
+    using namespace sigil::dfa;
+    expect_eq(simulate(grammar, "SeLeCt"), SimulationResult::accept("Select"));
+    expect_eq(simulate(grammar, "FROM"), SimulationResult::accept("From"));
+    expect_eq(simulate(grammar, "F"), SimulationResult::accept("From"));
+    expect_eq(
+        simulate(grammar, "selects"), SimulationResult::accept("Identifier"));
+    expect_eq(simulate(grammar, "Selects"), SimulationResult::error());
+
+    // Classes are folded before they are negated, so neither case of an
+    // excluded letter matches
+    const auto matches = [](StringView pattern, StringView input) {
+        sigil::Specification negated;
+        negated.add_regex_token(
+            0, "Negated", pattern, CaseSensitivity::Insensitive);
+        auto either_negated = sigil::Grammar::compile(negated);
+        const auto negated_grammar = std::move(either_negated.release_right());
+        return simulate(negated_grammar, input) ==
+               SimulationResult::accept("Negated");
+    };
+    expect_eq(matches("[^a-z]", "1"), true);
+    expect_eq(matches("[^a-z]", "q"), false);
+    expect_eq(matches("[^a-z]", "Q"), false);
+    expect_eq(matches("[^a]", "b"), true);
+    expect_eq(matches("[^a]", "a"), false);
+    expect_eq(matches("[^a]", "A"), false);
+    expect_eq(matches("[^A]", "a"), false);
+    expect_eq(matches("\\W", "-"), true);
+    expect_eq(matches("\\W", "w"), false);
+    expect_eq(matches("\\W", "W"), false);
+    expect_eq(matches("\\D", "d"), true);
+    expect_eq(matches("\\D", "7"), false);
+    expect_eq(matches("\\P{Lu}", "1"), true);
+    expect_eq(matches("\\P{Lu}", "x"), false);
+    expect_eq(matches("\\P{Lu}", "X"), false);
+    expect_eq(matches("\\P{L}", "x"), false);
+    expect_eq(matches("\\P{L}", "X"), false);
+    expect_eq(matches("[^\\u{e9}b]", "B"), false);
+    expect_eq(matches("[^\\u{e9}b]", "c"), true);
+
+    sigil::Specification sensitive;
+    sensitive.add_literal_token((s32)Type::Select, "Select", "select");
+    sigil::Specification insensitive;
+    insensitive.add_literal_token(
+        (s32)Type::Select, "Select", "select", CaseSensitivity::Insensitive);
+    expect_eq(sensitive.hash() != insensitive.hash(), true);
+}
+
+static void keyword_tokens()
+{
+    enum class Type : s32
+    {
+        Identifier,
+        Space,
+        Select,
+        From,
+        Where,
+    };
+
+    sigil::Specification specification;
+    specification.add_regex_token(
+        (s32)Type::Identifier, "Identifier", "[a-z_]+");
+    specification.add_regex_token((s32)Type::Space, "Space", " ");
+    specification.add_keyword_token(
+        (s32)Type::Select, "Select", "select", (s32)Type::Identifier);
+    specification.add_keyword_token(
+        (s32)Type::From, "From", "from", (s32)Type::Identifier);
+    specification.add_keyword_token(
+        (s32)Type::Where, "Where", "where", (s32)Type::Identifier);
+
+    auto either_grammar = sigil::Grammar::compile(specification);
+    auto grammar = std::move(either_grammar.release_right());
+
+    const auto scan = [&](sigil::ScannerDriver &scanner) {
+        scanner.initialize("<string>", "select froms from where");
+        expect_eq(scanner.next().type, (s32)Type::Select);
+        expect_eq(scanner.next().type, (s32)Type::Space);
+        expect_eq(scanner.next().type, (s32)Type::Identifier);
+        expect_eq(scanner.next().type, (s32)Type::Space);
+        expect_eq(scanner.next().type, (s32)Type::From);
+        expect_eq(scanner.next().type, (s32)Type::Space);
+        const auto where = scanner.next();
+        expect_eq(where.type, (s32)Type::Where);
+        expect_eq(where.lexeme, "where"sv);
+        expect_eq(scanner.next().type, (s32)sigil::SpecialTokenType::Eof);
+    };
+
+    sigil::DfaScannerDriver dfa_scanner(grammar.dfa());
+    scan(dfa_scanner);
+    auto scanner = sigil::DfaTableScannerDriver::create(grammar.dfa());
+    scan(scanner);
+
+    auto bytes = sigil::StaticTableFile::serialize(scanner.static_table());
+    auto either_file = sigil::StaticTableFile::view(&bytes[0], bytes.size());
+    auto file = std::move(either_file.release_right());
+    auto mapped_scanner = file.scanner_driver();
+    scan(mapped_scanner);
+
+    // Every keyword of a larger set is found in its own slot
+    static char buffers[600][16];
+    List<StringView> names;
+    for (auto i = 0; i < 600; ++i) {
+        const auto count = snprintf(buffers[i], 16, "keyword_%d", i);
+        names.add(StringView(buffers[i], count));
+    }
+    sigil::Specification large;
+    large.add_regex_token((s32)Type::Identifier, "Identifier", "[a-z_0-9]+");
+    for (auto i = 0; i < 600; ++i) {
+        large.add_keyword_token(
+            3 + i, "Keyword", names[i], (s32)Type::Identifier);
+    }
+    auto large_grammar =
+        std::move(sigil::Grammar::compile(large).release_right());
+    auto large_scanner =
+        sigil::DfaTableScannerDriver::create(large_grammar.dfa());
+    const auto &keywords = large_scanner.static_table().keywords();
+    for (auto i = 0; i < 600; ++i) {
+        expect_eq(
+            keywords.classify((s32)Type::Identifier, names[i]), 3 + i);
+    }
+    expect_eq(
+        keywords.classify((s32)Type::Identifier, "keyword_600"sv),
+        (s32)Type::Identifier);
+
+    // The displacement search is bounded per bucket, so a table near the
+    // slot limit builds quickly
+    static char many_buffers[40000][16];
+    List<sigil::Keyword> many;
+    for (auto i = 0; i < 40000; ++i) {
+        const auto count = snprintf(many_buffers[i], 16, "k%d", i);
+        many.add({ StringView(many_buffers[i], count), 0, 1 + i });
+    }
+    auto either_many = sigil::KeywordTable::build(many);
+    expect_eq(either_many.isRight(), true);
+    const auto many_storage = std::move(either_many.release_right());
+    const sigil::KeywordTable many_keywords(many_storage);
+    for (auto i = 0; i < 40000; ++i)
+        expect_eq(many_keywords.classify(0, many[i].keyword), 1 + i);
+
+    sigil::Specification duplicate;
+    duplicate.add_regex_token((s32)Type::Identifier, "Identifier", "[a-z]+");
+    duplicate.add_keyword_token(
+        (s32)Type::From, "From", "from", (s32)Type::Identifier);
+    duplicate.add_keyword_token(
+        (s32)Type::Where, "Where", "from", (s32)Type::Identifier);
+    expect_eq(sigil::Grammar::compile(duplicate).left(), "Duplicate keyword"sv);
+}
+
+static void literal_dictionary()
+{
+    enum class Type : s32
+    {
+        Word,
+        Code,
+    };
+
+    const StringView words[] = {
+        "tops"sv, "tap"sv, "top"sv, "taps"sv, "tap"sv,
+    };
+    sigil::Specification specification;
+    specification.add_literal_tokens(
+        (s32)Type::Word, "Word", core::ListView<StringView>(words, 5));
+
+    auto either_grammar = sigil::Grammar::compile(specification);
+    auto grammar = std::move(either_grammar.release_right());
+
+    using namespace sigil::dfa;
+    expect_eq(simulate(grammar, "tap"), SimulationResult::accept("Word"));
+    expect_eq(simulate(grammar, "tops"), SimulationResult::accept("Word"));
+    expect_eq(simulate(grammar, "to"), SimulationResult::any());
+    expect_eq(simulate(grammar, "tapss"), SimulationResult::error());
+    // t -> {a, o} -> p -> (s) -> s, plus the error state
+    expect_eq(grammar.dfa().states().size(), 6u);
+
+    static char buffers[5000][8];
+    List<StringView> codes;
+    for (auto i = 0; i < 5000; ++i) {
+        const auto count = snprintf(buffers[i], 8, "P%04d", i * 7 % 10000);
+        codes.add(StringView(buffers[i], count));
+    }
+    sigil::Specification dictionary;
+    dictionary.add_literal_tokens((s32)Type::Code, "Code", codes.to_view());
+    dictionary.add_regex_token((s32)Type::Word, "Word", "[A-Z][0-9]+");
+    auto dictionary_grammar =
+        std::move(sigil::Grammar::compile(dictionary).release_right());
+    expect_eq(
+        simulate(dictionary_grammar, "P0007"),
+        SimulationResult::accept("Code"));
+    expect_eq(
+        simulate(dictionary_grammar, "P0008"),
+        SimulationResult::accept("Word"));
+}
+
+static void bounded_repetition()
+{
+    expect_eq(parse_regex("a{3}"), "Repetition(Atom('a'), 3, 3)");
+    expect_eq(parse_regex("a{2,}"), "Repetition(Atom('a'), 2, inf)");
+    expect_eq(
+        parse_regex("(ab){0,2}?"),
+        "Optional(Repetition(Concatenation(Atom('a'), Atom('b')), 0, 2))");
+    expect_eq(parse_regex("a{3,2}"), "Parse error: Parse error");
+    // Braces which start no repetition are literals
+    expect_eq(
+        parse_regex("a{2"),
+        "Concatenation(Concatenation(Atom('a'), Atom('{')), Atom('2'))");
+    expect_eq(parse_regex("a{"), "Concatenation(Atom('a'), Atom('{'))");
+    expect_eq(
+        parse_regex("x{f}"),
+        "Concatenation(Concatenation(Concatenation(Atom('x'), Atom('{')), "
+        "Atom('f')), Atom('}'))");
+    expect_eq(parse_regex("}"), "Atom('}')");
+
+    enum class Type : s32
+    {
+        Octet,
+        Time,
+        Digits,
+    };
+
+    sigil::Specification specification;
+    specification.add_regex_token(
+        (s32)Type::Octet, "Octet", "([0-9]{1,3}\\.){3}[0-9]{1,3}");
+    specification.add_regex_token(
+        (s32)Type::Time, "Time", "[0-9]{2}:[0-9]{2}(:[0-9]{2})?");
+    specification.add_regex_token((s32)Type::Digits, "Digits", "x{0,}y{2,}");
+
+    auto either_grammar = sigil::Grammar::compile(specification);
+    auto grammar = std::move(either_grammar.release_right());
+
+    using namespace sigil::dfa;
+    expect_eq(
+        simulate(grammar, "192.168.0.1"), SimulationResult::accept("Octet"));
+    expect_eq(simulate(grammar, "1.2.3"), SimulationResult::any());
+    expect_eq(simulate(grammar, "1.2.3.4567"), SimulationResult::error());
+    expect_eq(simulate(grammar, "12:30"), SimulationResult::accept("Time"));
+    expect_eq(simulate(grammar, "12:30:4"), SimulationResult::any());
+    expect_eq(simulate(grammar, "12:30:45"), SimulationResult::accept("Time"));
+    expect_eq(simulate(grammar, "yy"), SimulationResult::accept("Digits"));
+    expect_eq(simulate(grammar, "xxyyy"), SimulationResult::accept("Digits"));
+    expect_eq(simulate(grammar, "xxy"), SimulationResult::any());
+
+    sigil::Specification limited;
+    limited.set_repetition_limit(1000);
+    limited.add_regex_token((s32)Type::Digits, "Digits", "([0-9]{100}){100}");
+    expect_eq(
+        sigil::Grammar::compile(limited).left(),
+        "Regex expands beyond the repetition limit"sv);
+}
+
+static String simplify_regex(const StringView &regex_pattern)
+{
+    core::Arena arena;
+    sigil::RegexParser parser(arena);
+    parser.initialize(regex_pattern);
+    auto either_exp = parser.parse();
+    if (not either_exp.isRight())
+        return core::Formatting::format("Parse error: ", either_exp.left());
+
+    sigil::RegExpSimplifier simplifier(arena);
+    return core::Formatting::format(
+        *simplifier.simplify(either_exp.release_right()));
+}
+
+static void regexp_simplification()
+{
+    expect_eq(simplify_regex("a|b|c|d"), parse_regex("[a-d]"));
+    expect_eq(simplify_regex("a|b|a"), parse_regex("[ab]"));
+    expect_eq(simplify_regex("(a*)*"), "Kleene(Atom('a'))");
+    expect_eq(simplify_regex("a?*"), "Kleene(Atom('a'))");
+    expect_eq(simplify_regex("(a+)?"), "Kleene(Atom('a'))");
+    expect_eq(simplify_regex("(a+)+"), "PositiveKleene(Atom('a'))");
+    expect_eq(simplify_regex("ab|ab"), "Concatenation(Atom('a'), Atom('b'))");
+    expect_eq(simplify_regex("a{0,}"), "Kleene(Atom('a'))");
+    expect_eq(simplify_regex("a{1}"), "Atom('a')");
+    expect_eq(simplify_regex("a{2,3}"), "Repetition(Atom('a'), 2, 3)");
+
+    {
+        core::Arena arena;
+        sigil::RegexParser parser(arena);
+        sigil::RegExpSimplifier simplifier(arena);
+        parser.initialize("(ab)*c");
+        const auto first = simplifier.simplify(parser.parse().release_right());
+        const auto node_count = simplifier.node_count();
+        parser.initialize("(ab)*c");
+        const auto second = simplifier.simplify(parser.parse().release_right());
+        assert(first == second);
+        assert(simplifier.node_count() == node_count);
+    }
+
+    enum class Type : s32
+    {
+        Keyword,
+        Identifier,
+    };
+
+    sigil::Specification specification;
+    specification.add_regex_token(
+        (s32)Type::Keyword, "Keyword", "if|else|if|(w*)*hile");
+    specification.add_regex_token(
+        (s32)Type::Identifier, "Identifier", "([a-z]|[A-Z]|_)([a-z]|_)*");
+
+    auto either_grammar = sigil::Grammar::compile(specification);
+    auto grammar = std::move(either_grammar.release_right());
+
+    using namespace sigil::dfa;
+    expect_eq(simulate(grammar, "if"), SimulationResult::accept("Keyword"));
+    expect_eq(simulate(grammar, "hile"), SimulationResult::accept("Keyword"));
+    expect_eq(
+        simulate(grammar, "wwhile"), SimulationResult::accept("Keyword"));
+    expect_eq(
+        simulate(grammar, "Ifx"), SimulationResult::accept("Identifier"));
+}
+
+static void compile_statistics()
+{
+    enum class Type : s32
+    {
+        Keyword,
+        Identifier,
+    };
+
+    sigil::Specification specification;
+    specification.add_literal_token((s32)Type::Keyword, "Keyword", "if");
+    specification.add_regex_token(
+        (s32)Type::Identifier, "Identifier", "[a-z]+");
+
+    sigil::CompileStatistics statistics;
+    auto either_grammar = sigil::Grammar::compile(specification, &statistics);
+    auto grammar = std::move(either_grammar.release_right());
+    expect_eq(statistics.dfa_state_count, grammar.dfa().states().size());
+    expect_eq(statistics.dfa_arc_count, grammar.dfa().arcs().size());
+    // Atom and PositiveKleene, literals are not parsed
+    expect_eq(statistics.regex_node_count, Size(2));
+    assert(statistics.nfa_state_count > 3);
+    assert(statistics.nfa_arc_count > 2);
+    // At least the start state, with the NFA start states of both tokens
+    assert(statistics.largest_nfa_state_set >= 2);
+    assert(statistics.estimated_arena_bytes > 0);
+    assert(statistics.scratch_bytes > 0);
+    // Bytes of a range share their closure, otherwise every state would
+    // compute one per byte
+    assert(statistics.closure_count > 0);
+    assert(statistics.closure_count < statistics.dfa_state_count * 256);
+
+    auto driver = sigil::DfaTableScannerDriver::create(
+        grammar.dfa(), &statistics);
+    expect_eq(
+        statistics.table_transition_count,
+        grammar.dfa().states().size() * 256);
+    assert(statistics.table_live_transition_count > 0);
+    assert(
+        statistics.table_live_transition_count <
+        statistics.table_transition_count);
+    assert(statistics.table_bytes > statistics.table_transition_count);
+    assert(statistics.table_density() > 0.0);
+    assert(statistics.table_density() < 1.0);
+    // Compile statistics are kept
+    expect_eq(statistics.dfa_state_count, grammar.dfa().states().size());
+
+    const auto formatted = core::Formatting::format(statistics);
+    assert(formatted.size() > 0);
+}
+
+static void scanner_counters()
+{
+#ifdef SIGIL_SCANNER_COUNTERS
+    enum class Type : s32
+    {
+        Integer,
+        Float,
+        Whitespace,
+    };
+
+    sigil::Specification specification;
+    specification.add_regex_token((s32)Type::Integer, "Integer", "[0-9]+");
+    specification.add_regex_token(
+        (s32)Type::Float, "Float", "[0-9]+\\.[0-9]+");
+    specification.add_regex_token((s32)Type::Whitespace, "Whitespace", " +");
+    specification.skip_token_type((s32)Type::Whitespace);
+
+    auto either_grammar = sigil::Grammar::compile(specification);
+    auto grammar = std::move(either_grammar.release_right());
+    auto scanner = sigil::DfaTableScannerDriver::create(grammar.dfa());
+    scanner.initialize("<string>", "12 3.x");
+    expect_eq(scanner.next().type, (s32)Type::Integer);
+    expect_eq(scanner.next().type, (s32)Type::Integer);
+    expect_eq(scanner.next().type, (s32)sigil::SpecialTokenType::Error);
+
+    // "12 " + " 3" + "3.x" + "."
+    const auto &counters = scanner.counters();
+    expect_eq(counters.bytes_scanned(), u64(9));
+    expect_eq(counters.bytes_rescanned(), u64(4));
+    expect_eq(counters.error_count(), u64(1));
+    expect_eq(counters.token_count((s32)Type::Integer), u64(2));
+    expect_eq(counters.token_count((s32)Type::Float), u64(0));
+    expect_eq(counters.token_count((s32)Type::Whitespace), u64(0));
+
+#ifdef SIGIL_SCANNER_STATE_HISTOGRAM
+    // Every byte scanned, and the start state once per scanned token
+    u64 visits = 0;
+    for (const auto count : counters.state_visits()) visits += count;
+    expect_eq(visits, u64(9 + 4));
+    expect_eq(
+        counters.state_visits()[grammar.dfa().start_state()->id], u64(4));
+#endif
+
+    scanner.counters().reset();
+    expect_eq(scanner.counters().bytes_scanned(), u64(0));
+#endif
+}
+
+static void expect_same_tokens(
+    const sigil::IncrementalScanner &actual,
+    const sigil::IncrementalScanner &expected)
+{
+    expect_eq(actual.token_count(), expected.token_count());
+    for (Index i = 0; i < expected.token_count(); ++i) {
+        const auto &a = actual.entries()[i];
+        const auto &e = expected.entries()[i];
+        expect_eq(a.type, e.type);
+        expect_eq(a.offset, e.offset);
+        expect_eq(a.length, e.length);
+        expect_eq(a.first.line, e.first.line);
+        expect_eq(a.first.column, e.first.column);
+        expect_eq(a.end.line, e.end.line);
+        expect_eq(a.end.column, e.end.column);
+        expect_eq(a.scan_end, e.scan_end);
+        expect_eq(actual.token(i).lexeme, expected.token(i).lexeme);
+    }
+}
+
+static void incremental_compilation()
+{
+    using sigil::dfa::SimulationResult;
+
+    enum class Type : s32
+    {
+        If,
+        Else,
+        Identifier,
+        Integer,
+        While,
+    };
+
+    sigil::Specification specification;
+    specification.add_literal_token((s32)Type::If, "If", "if");
+    specification.add_literal_token((s32)Type::Else, "Else", "else");
+    specification.add_regex_token(
+        (s32)Type::Identifier, "Identifier", "[a-z]+");
+    specification.add_regex_token((s32)Type::Integer, "Integer", "[0-9]+");
+
+    sigil::CompileMemo memo;
+    sigil::CompileStatistics statistics;
+    auto either_grammar =
+        sigil::Grammar::compile(specification, memo, &statistics);
+    assert(either_grammar.isRight());
+    expect_eq(statistics.reused_nfa_count, Size(0));
+    expect_eq(statistics.reused_dfa_state_count, Size(0));
+
+    // A keyword is added in front of the identifiers
+    sigil::Specification added;
+    added.add_literal_token((s32)Type::If, "If", "if");
+    added.add_literal_token((s32)Type::Else, "Else", "else");
+    added.add_literal_token((s32)Type::While, "While", "while");
+    added.add_regex_token((s32)Type::Identifier, "Identifier", "[a-z]+");
+    added.add_regex_token((s32)Type::Integer, "Integer", "[0-9]+");
+
+    either_grammar = sigil::Grammar::compile(added, memo, &statistics);
+    assert(either_grammar.isRight());
+    auto grammar = std::move(either_grammar.release_right());
+    expect_eq(statistics.reused_nfa_count, Size(4));
+    // Among others the states after a digit, and after "el"
+    assert(statistics.reused_dfa_state_count > 0);
+    assert(statistics.reused_dfa_state_count < statistics.dfa_state_count);
+
+    auto either_expected = sigil::Grammar::compile(added);
+    auto expected = std::move(either_expected.release_right());
+    expect_eq(grammar.dfa().states().size(), expected.dfa().states().size());
+    expect_eq(grammar.dfa().arcs().size(), expected.dfa().arcs().size());
+    for (const auto input : { "if"sv,
+                              "else"sv,
+                              "while"sv,
+                              "whi"sv,
+                              "whiles"sv,
+                              "i"sv,
+                              "42"sv,
+                              "4a"sv }) {
+        expect_eq(
+            sigil::dfa::simulate(grammar, input),
+            sigil::dfa::simulate(expected, input));
+    }
+    expect_eq(
+        sigil::dfa::simulate(grammar, "while"),
+        SimulationResult::accept("While"));
+
+    // Removing the keyword again reuses every state
+    either_grammar = sigil::Grammar::compile(specification, memo, &statistics);
+    assert(either_grammar.isRight());
+    grammar = std::move(either_grammar.release_right());
+    expect_eq(statistics.reused_nfa_count, Size(4));
+    expect_eq(statistics.reused_dfa_state_count, statistics.dfa_state_count);
+    expect_eq(
+        sigil::dfa::simulate(grammar, "while"),
+        SimulationResult::accept("Identifier"));
+
+    // Equal tokens of different modes keep apart
+    sigil::Specification modes;
+    modes.add_regex_token((s32)Type::Identifier, "Identifier", "[a-z]+");
+    modes.set_mode(modes.add_mode("Other"));
+    modes.add_regex_token((s32)Type::Integer, "Word", "[a-z]+");
+    either_grammar = sigil::Grammar::compile(modes, memo, &statistics);
+    assert(either_grammar.isRight());
+    grammar = std::move(either_grammar.release_right());
+    expect_eq(statistics.reused_nfa_count, Size(1));
+    expect_eq(
+        sigil::dfa::simulate(grammar, "abc", 0),
+        SimulationResult::accept("Identifier"));
+    expect_eq(
+        sigil::dfa::simulate(grammar, "abc", 1),
+        SimulationResult::accept("Word"));
+
+    // A lower repetition limit rejects an automaton built under a higher one
+    sigil::Specification repeated;
+    repeated.add_regex_token((s32)Type::Integer, "Integer", "[0-9]{50}");
+    either_grammar = sigil::Grammar::compile(repeated, memo, &statistics);
+    assert(either_grammar.isRight());
+    repeated.set_repetition_limit(10);
+    expect_eq(
+        sigil::Grammar::compile(repeated, memo, &statistics).left(),
+        "Regex expands beyond the repetition limit"sv);
+    expect_eq(statistics.reused_nfa_count, Size(0));
+}
+
+static void lazy_dfa_scanning()
+{
+    enum class Type : s32
+    {
+        Identifier,
+        Integer,
+        Float,
+        Whitespace,
+        Select,
+        Comment,
+    };
+
+    sigil::Specification specification;
+    specification.add_regex_token(
+        (s32)Type::Identifier, "Identifier", "[a-z_]+");
+    specification.add_regex_token((s32)Type::Integer, "Integer", "[0-9]+");
+    specification.add_regex_token(
+        (s32)Type::Float, "Float", "[0-9]+\\.[0-9]+");
+    specification.add_regex_token((s32)Type::Whitespace, "Whitespace", " +");
+    specification.skip_token_type((s32)Type::Whitespace);
+    specification.add_keyword_token(
+        (s32)Type::Select, "Select", "select", (s32)Type::Identifier);
+    specification.set_mode(specification.add_mode("Comment"));
+    specification.add_regex_token((s32)Type::Comment, "Comment", "[^#]+");
+
+    auto either_grammar = sigil::Grammar::compile(specification);
+    auto grammar = std::move(either_grammar.release_right());
+    auto expected = sigil::DfaTableScannerDriver::create(grammar.dfa());
+
+    const auto input = "select a_b 12 3.25 1. selects 7.0 x"sv;
+    const auto expect_same_tokens = [&](sigil::ScannerDriver &actual) {
+        for (auto pass = 0; pass < 2; ++pass) {
+            expected.initialize("<string>", input);
+            actual.initialize("<string>", input);
+            for (;;) {
+                assert(actual.has_next() == expected.has_next());
+                if (not expected.has_next())
+                    break;
+                const auto a = actual.next();
+                const auto e = expected.next();
+                expect_eq(a.type, e.type);
+                expect_eq(a.lexeme, e.lexeme);
+                expect_eq(a.range.first.column, e.range.first.column);
+                expect_eq(a.range.end.column, e.range.end.column);
+            }
+        }
+
+        expected.initialize("<string>", "a b");
+        actual.initialize("<string>", "a b");
+        expected.set_mode(1);
+        actual.set_mode(1);
+        expect_eq(actual.next().type, expected.next().type);
+    };
+
+    auto either_lazy = sigil::LazyDfaScannerDriver::create(specification);
+    auto lazy = std::move(either_lazy.release_right());
+    // Only the error state, states are constructed when visited
+    expect_eq(lazy.cached_state_count(), Size(1));
+    expect_same_tokens(lazy);
+    expect_eq(lazy.flush_count(), Size(0));
+    assert(lazy.cached_state_count() <= grammar.dfa().states().size());
+
+    // The cache is flushed over and over, but at token boundaries only
+    auto either_small = sigil::LazyDfaScannerDriver::create(specification, 3);
+    auto small = std::move(either_small.release_right());
+    expect_same_tokens(small);
+    assert(small.flush_count() > 0);
+
+    auto either_nfa = sigil::NfaScannerDriver::create(specification);
+    auto nfa = std::move(either_nfa.release_right());
+    expect_same_tokens(nfa);
+
+    auto either_bit_parallel =
+        sigil::BitParallelScannerDriver::create(specification);
+    auto bit_parallel = std::move(either_bit_parallel.release_right());
+    assert(bit_parallel.position_count() <= 128);
+    expect_same_tokens(bit_parallel);
+
+    sigil::Specification invalid;
+    invalid.set_repetition_limit(4);
+    invalid.add_regex_token((s32)Type::Integer, "Integer", "[0-9]{10}");
+    assert(not sigil::LazyDfaScannerDriver::create(invalid).isRight());
+}
+
+static void bit_parallel_scanning()
+{
+    enum class Type : s32
+    {
+        If,
+        Identifier,
+        Long,
+        Whitespace,
+    };
+
+    // The long literal has positions in both words of the mask
+    static const char long_literal[] =
+        "abcdefghijklmnopqrstuvwxyzabcdefghijklmnopqrstuvwxyz"
+        "abcdefghijklmnopqrstuvwxyz";
+    sigil::Specification specification;
+    specification.add_literal_token((s32)Type::If, "If", "if");
+    specification.add_regex_token(
+        (s32)Type::Identifier, "Identifier", "[a-z]+");
+    specification.add_literal_token((s32)Type::Long, "Long", long_literal);
+    specification.add_regex_token((s32)Type::Whitespace, "Whitespace", " +");
+    specification.skip_token_type((s32)Type::Whitespace);
+
+    auto either_driver = sigil::BitParallelScannerDriver::create(specification);
+    auto driver = std::move(either_driver.release_right());
+    assert(driver.position_count() > 80);
+
+    // The identifier was added before the long literal, so it wins
+    char input[128];
+    const auto input_size =
+        snprintf(input, sizeof(input), "if iff %s i", long_literal);
+    driver.initialize("<string>", StringView(input, input_size));
+    expect_eq(driver.next().type, (s32)Type::If);
+    const auto identifier = driver.next();
+    expect_eq(identifier.type, (s32)Type::Identifier);
+    expect_eq(identifier.lexeme, "iff"sv);
+    const auto long_token = driver.next();
+    expect_eq(long_token.type, (s32)Type::Identifier);
+    expect_eq(long_token.lexeme.size(), Size(sizeof(long_literal) - 1));
+    expect_eq(driver.next().lexeme, "i"sv);
+    expect_eq(driver.next().type, (s32)sigil::SpecialTokenType::Eof);
+
+    driver.initialize("<string>", "if 1");
+    expect_eq(driver.next().type, (s32)Type::If);
+    expect_eq(driver.next().type, (s32)sigil::SpecialTokenType::Error);
+
+    specification.add_literal_token(
+        (s32)Type::Long,
+        "Long",
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789");
+    assert(not sigil::BitParallelScannerDriver::create(specification)
+                   .isRight());
+}
+
+static void dfa_budget()
+{
+    enum class Type : s32
+    {
+        Tail,
+        Word,
+        Whitespace,
+    };
+
+    // The DFA has to remember the last eight characters
+    sigil::Specification specification;
+    specification.add_regex_token((s32)Type::Tail, "Tail", "[ab]*a[ab]{8}");
+    specification.add_regex_token((s32)Type::Word, "Word", "[a-z]+");
+    specification.add_regex_token((s32)Type::Whitespace, "Whitespace", " +");
+    specification.skip_token_type((s32)Type::Whitespace);
+
+    auto either_grammar = sigil::Grammar::compile(specification);
+    auto grammar = std::move(either_grammar.release_right());
+    assert(grammar.dfa().states().size() > 512);
+    auto expected = sigil::DfaTableScannerDriver::create(grammar.dfa());
+
+    specification.set_dfa_budget(64, std::numeric_limits<Size>::max());
+    either_grammar = sigil::Grammar::compile(specification);
+    assert(not either_grammar.isRight());
+    expect_eq(either_grammar.left(), sigil::Grammar::dfa_budget_exceeded());
+
+    specification.set_dfa_budget(std::numeric_limits<Size>::max(), 64 * 1024);
+    either_grammar = sigil::Grammar::compile(specification);
+    assert(not either_grammar.isRight());
+    expect_eq(either_grammar.left(), sigil::Grammar::dfa_budget_exceeded());
+    auto either_checked = sigil::Grammar::compile_checked(specification);
+    assert(not either_checked.isRight());
+    assert(
+        either_checked.left().kind ==
+        sigil::CompileError::Kind::DfaBudgetExceeded);
+
+    // Other errors are reported as they are, even with a budget
+    sigil::Specification invalid;
+    invalid.add_regex_token((s32)Type::Word, "Word", "[a-z]+");
+    invalid.add_keyword_token((s32)Type::Tail, "Tail", "ab", (s32)Type::Word);
+    invalid.add_keyword_token((s32)Type::Tail, "Tail", "ab", (s32)Type::Word);
+    invalid.set_dfa_budget(64, 64 * 1024);
+    either_checked = sigil::Grammar::compile_checked(invalid);
+    assert(not either_checked.isRight());
+    assert(either_checked.left().kind == sigil::CompileError::Kind::Invalid);
+    expect_eq(sigil::ScannerDriver::create(invalid).isRight(), false);
+
+    auto either_driver = sigil::ScannerDriver::create(specification);
+    auto driver = std::move(either_driver.release_right());
+    assert(dynamic_cast<sigil::NfaScannerDriver *>(driver.get()) != nullptr);
+
+    const auto input = "abbabababb ab aabbbbbbbbb abc bababababababa  x"sv;
+    expected.initialize("<string>", input);
+    driver->initialize("<string>", input);
+    for (;;) {
+        assert(driver->has_next() == expected.has_next());
+        if (not expected.has_next())
+            break;
+        const auto a = driver->next();
+        const auto e = expected.next();
+        expect_eq(a.type, e.type);
+        expect_eq(a.lexeme, e.lexeme);
+    }
+
+    // Within the budget the table driver is used
+    specification.set_dfa_budget(4096, std::numeric_limits<Size>::max());
+    either_driver = sigil::ScannerDriver::create(specification);
+    driver = std::move(either_driver.release_right());
+    assert(
+        dynamic_cast<sigil::DfaTableScannerDriver *>(driver.get()) != nullptr);
+    driver->initialize("<string>", "abbbbbbbb");
+    expect_eq(driver->next().type, (s32)Type::Tail);
+}
+
+static void incremental_scanning()
+{
+    enum class Type : s32
+    {
+        Identifier,
+        Number,
+        Whitespace,
+    };
+
+    sigil::Specification specification;
+    specification.add_regex_token(
+        (s32)Type::Identifier, "Identifier", "[a-z]+");
+    specification.add_regex_token((s32)Type::Number, "Number", "[0-9]+");
+    specification.add_regex_token(
+        (s32)Type::Whitespace, "Whitespace", "[ \\n]+");
+    specification.skip_token_type((s32)Type::Whitespace);
+
+    auto either_grammar = sigil::Grammar::compile(specification);
+    auto grammar = std::move(either_grammar.release_right());
+    auto driver = sigil::DfaTableScannerDriver::create(grammar.dfa());
+    auto reference_driver =
+        sigil::DfaTableScannerDriver::create(grammar.dfa());
+
+    const auto check = [&](StringView before,
+                           StringView after,
+                           sigil::TextEdit edit,
+                           Index first,
+                           Size removed_count,
+                           Size inserted_count) {
+        sigil::IncrementalScanner scanner(driver);
+        scanner.scan("<string>", before);
+        const auto change = scanner.update(after, edit);
+        expect_eq(change.first, first);
+        expect_eq(change.removed_count, removed_count);
+        expect_eq(change.inserted_count, inserted_count);
+
+        sigil::IncrementalScanner reference(reference_driver);
+        reference.scan("<string>", after);
+        expect_same_tokens(scanner, reference);
+    };
+
+    const auto source = "abc 12 def\nghi 3"sv;
+    check(source, "abxc 12 def\nghi 3"sv, { 2, 0, 1 }, 0, 1, 1);
+    check(source, "a bc 12 def\nghi 3"sv, { 1, 0, 1 }, 0, 1, 2);
+    check(source, "abc 12 defghi 3"sv, { 10, 1, 0 }, 2, 2, 1);
+    check(source, "abc 12 def\nghi 34"sv, { 16, 0, 1 }, 4, 1, 1);
+    check(source, "abc 12 d%f\nghi 3"sv, { 8, 1, 1 }, 2, 4, 2);
+    check("abc %"sv, "abc d"sv, { 4, 1, 1 }, 1, 1, 2);
+
+    // Only the edited word is scanned again
+    constexpr Size word_count = 1000;
+    char before[word_count * 5];
+    char after[word_count * 5];
+    for (Index i = 0; i < word_count; ++i) {
+        for (Index j = 0; j < 4; ++j) before[i * 5 + j] = 'a' + (i + j) % 26;
+        before[i * 5 + 4] = '\n';
+    }
+    for (Index i = 0; i < sizeof(before); ++i) after[i] = before[i];
+    after[2501] = 'z';
+
+    sigil::IncrementalScanner scanner(driver);
+    scanner.scan("<string>", StringView(before, sizeof(before)));
+    expect_eq(scanner.scanned_bytes(), u64(sizeof(before)));
+    const auto change =
+        scanner.update(StringView(after, sizeof(after)), { 2501, 1, 1 });
+    expect_eq(change.first, Index(500));
+    expect_eq(change.removed_count, Size(1));
+    expect_eq(change.inserted_count, Size(1));
+    // The preceding newline, the word and the newline after it
+    expect_eq(scanner.scanned_bytes(), u64(6));
+
+    sigil::IncrementalScanner reference(reference_driver);
+    reference.scan("<string>", StringView(after, sizeof(after)));
+    expect_same_tokens(scanner, reference);
+}
+
+static void unanchored_search()
+{
+    enum class Type : s32
+    {
+        Long,
+        Short,
+        Number,
+        Whitespace,
+    };
+
+    sigil::Specification specification;
+    specification.add_literal_token((s32)Type::Long, "Long", "abcd");
+    specification.add_literal_token((s32)Type::Short, "Short", "bc");
+    specification.add_regex_token((s32)Type::Number, "Number", "[0-9]+");
+    specification.add_regex_token((s32)Type::Whitespace, "Whitespace", " +");
+    specification.skip_token_type((s32)Type::Whitespace);
+
+    auto either_grammar = sigil::Grammar::compile(specification);
+    auto grammar = std::move(either_grammar.release_right());
+    auto driver = sigil::DfaTableScannerDriver::create(grammar.dfa());
+    const auto table = driver.static_table();
+    sigil::Searcher searcher(table);
+
+    // "bc" ends first, but "abcd" starts further left
+    const auto matches = searcher.find_all("xxabcdx bc 123 abcbc"sv);
+    expect_eq(matches.size(), Size(5));
+    expect_eq(matches[0].type, (s32)Type::Long);
+    expect_eq(matches[0].offset, Index(2));
+    expect_eq(matches[0].lexeme, "abcd"sv);
+    expect_eq(matches[1].type, (s32)Type::Short);
+    expect_eq(matches[1].offset, Index(8));
+    expect_eq(matches[2].type, (s32)Type::Number);
+    expect_eq(matches[2].lexeme, "123"sv);
+    expect_eq(matches[3].offset, Index(16));
+    expect_eq(matches[4].offset, Index(18));
+    expect_eq(matches[4].lexeme, "bc"sv);
+
+    assert(searcher.find_all("xyz abd"sv).is_empty());
+    expect_eq(searcher.find_all("abc"sv).size(), Size(1));
+
+    // The thread of "cccd" at 2 reaches the state of the thread at 1, which
+    // "ab" cuts off
+    sigil::Specification overlapping;
+    overlapping.add_literal_token(0, "Ab", "ab");
+    overlapping.add_literal_token(1, "Long", "abcccz");
+    overlapping.add_regex_token(2, "Cd", "[bc]c*d");
+    auto either_overlapping = sigil::Grammar::compile(overlapping);
+    auto overlapping_grammar = std::move(either_overlapping.release_right());
+    auto overlapping_driver =
+        sigil::DfaTableScannerDriver::create(overlapping_grammar.dfa());
+    const auto overlapping_table = overlapping_driver.static_table();
+    sigil::Searcher overlapping_searcher(overlapping_table);
+    const auto cut_off = overlapping_searcher.find_all("abcccd"sv);
+    expect_eq(cut_off.size(), Size(2));
+    expect_eq(cut_off[0].lexeme, "ab"sv);
+    expect_eq(cut_off[1].type, 2);
+    expect_eq(cut_off[1].offset, Index(2));
+    expect_eq(cut_off[1].lexeme, "cccd"sv);
+
+    // Every thread reaches the state of the first one, which only matches
+    // once the input ends
+    sigil::Specification unfinished;
+    unfinished.add_regex_token(0, "Ab", "a+b");
+    unfinished.add_literal_token(1, "A", "a");
+    auto either_unfinished = sigil::Grammar::compile(unfinished);
+    auto unfinished_grammar = std::move(either_unfinished.release_right());
+    auto unfinished_driver =
+        sigil::DfaTableScannerDriver::create(unfinished_grammar.dfa());
+    const auto unfinished_table = unfinished_driver.static_table();
+    sigil::Searcher unfinished_searcher(unfinished_table);
+    const auto as = unfinished_searcher.find_all("aaaaa aab"sv);
+    expect_eq(as.size(), Size(6));
+    for (Index i = 0; i < 5; ++i) {
+        expect_eq(as[i].type, 1);
+        expect_eq(as[i].offset, i);
+    }
+    expect_eq(as[5].offset, Index(6));
+    expect_eq(as[5].lexeme, "aab"sv);
+}
+
+static sigil::RequiredLiterals required_literals(StringView regex_pattern)
+{
+    core::Arena arena;
+    sigil::RegexParser parser(arena);
+    parser.initialize(regex_pattern);
+    return sigil::LiteralPrefilter::required_literals(
+        parser.parse().release_right());
+}
+
+static bool contains_literal(
+    const sigil::RequiredLiterals &required, StringView literal)
+{
+    for (const auto &candidate : required.literals) {
+        if (candidate.size() == literal.size() and
+            memcmp(&candidate[0], literal.data(), literal.size()) == 0)
+            return true;
+    }
+    return false;
+}
+
+static void literal_prefilter()
+{
+    {
+        const auto required = required_literals("ERROR: [0-9]+");
+        expect_eq(required.literals.size(), Size(1));
+        assert(contains_literal(required, "ERROR: "sv));
+        expect_eq(required.max_offset, u32(0));
+    }
+    {
+        const auto required = required_literals("https?://[a-z]+");
+        expect_eq(required.literals.size(), Size(2));
+        assert(contains_literal(required, "http://"sv));
+        assert(contains_literal(required, "https://"sv));
+    }
+    {
+        const auto required = required_literals("[0-9]{1,3}ms|[a-z]+s");
+        expect_eq(required.literals.size(), Size(2));
+        assert(contains_literal(required, "ms"sv));
+        assert(contains_literal(required, "s"sv));
+        expect_eq(required.max_offset, sigil::RequiredLiterals::Unbounded);
+    }
+    expect_eq(required_literals("[0-9]{1,3}ms").max_offset, u32(3));
+    expect_eq(
+        required_literals("[a-z]+://").max_offset,
+        sigil::RequiredLiterals::Unbounded);
+    assert(required_literals("a*b?").is_empty());
+    assert(required_literals("[a-z]+").is_empty());
+
+    enum class Type : s32
+    {
+        Error,
+        Warning,
+        Whitespace,
+        Word,
+    };
+
+    sigil::Specification specification;
+    specification.add_regex_token((s32)Type::Error, "Error", "ERROR [0-9]+");
+    specification.add_literal_token((s32)Type::Warning, "Warning", "WARN");
+    specification.add_regex_token((s32)Type::Whitespace, "Whitespace", " +");
+    specification.skip_token_type((s32)Type::Whitespace);
+
+    auto either_prefilter = sigil::LiteralPrefilter::create(specification);
+    auto prefilter = std::move(either_prefilter.release_right());
+    assert(prefilter.is_active(0));
+    const auto text = "ok ok WARN ok ERROR 42 ERRORS ok WAR"sv;
+    expect_eq(prefilter.skip(text, 0, 0), Index(6));
+    expect_eq(prefilter.skip(text, 10, 0), Index(14));
+    // "ERROR " is required, not just "ERROR"
+    expect_eq(prefilter.skip(text, 15, 0), text.size());
+
+    auto either_grammar = sigil::Grammar::compile(specification);
+    auto grammar = std::move(either_grammar.release_right());
+    auto driver = sigil::DfaTableScannerDriver::create(grammar.dfa());
+    const auto table = driver.static_table();
+    const auto matches = sigil::Searcher(table).find_all(text);
+    const auto filtered_matches =
+        sigil::Searcher(table, std::move(prefilter)).find_all(text);
+    expect_eq(matches.size(), Size(2));
+    expect_eq(filtered_matches.size(), matches.size());
+    for (Index i = 0; i < matches.size(); ++i) {
+        expect_eq(filtered_matches[i].type, matches[i].type);
+        expect_eq(filtered_matches[i].offset, matches[i].offset);
+        expect_eq(filtered_matches[i].lexeme, matches[i].lexeme);
+    }
+
+    // Words can start anywhere
+    specification.add_regex_token((s32)Type::Word, "Word", "[a-z]+");
+    either_prefilter = sigil::LiteralPrefilter::create(specification);
+    assert(not either_prefilter.right().is_active(0));
+}
+
+static void expect_same_tokens(
+    sigil::ScanCursor &cursor, sigil::ScannerDriver &driver)
+{
+    while (driver.has_next()) {
+        const auto expected = driver.next();
+        const auto actual = cursor.next();
+        expect_eq(actual.type, expected.type);
+        expect_eq(actual.lexeme, expected.lexeme);
+        expect_eq(actual.range.first.line, expected.range.first.line);
+        expect_eq(actual.range.first.column, expected.range.first.column);
+        expect_eq(actual.range.end.line, expected.range.end.line);
+        expect_eq(actual.range.end.column, expected.range.end.column);
+    }
+}
+
+static void scan_cursors()
+{
+    enum class Type : s32
+    {
+        Identifier,
+        Number,
+        Whitespace,
+        Return,
+    };
+
+    sigil::Specification specification;
+    specification.add_regex_token(
+        (s32)Type::Identifier, "Identifier", "[a-z]+");
+    specification.add_regex_token((s32)Type::Number, "Number", "[0-9]+");
+    specification.add_regex_token(
+        (s32)Type::Whitespace, "Whitespace", "[ \\n]+");
+    specification.skip_token_type((s32)Type::Whitespace);
+    specification.add_keyword_token(
+        (s32)Type::Return, "Return", "return", (s32)Type::Identifier);
+
+    auto either_scanner = sigil::CompiledScanner::create(specification);
+    const auto scanner = std::move(either_scanner.release_right());
+    auto either_grammar = sigil::Grammar::compile(specification);
+    auto grammar = std::move(either_grammar.release_right());
+    auto driver = sigil::DfaTableScannerDriver::create(grammar.dfa());
+
+    // Cursors on one scanner do not interfere with each other
+    const auto first_input = "return x1\n  42 y "sv;
+    const auto second_input = "abc 12 % d"sv;
+    sigil::ScanCursor first(scanner, "<first>", first_input);
+    sigil::ScanCursor second(scanner, "<second>", second_input);
+    expect_eq(first.next().type, (s32)Type::Return);
+    expect_eq(second.next().lexeme, "abc"sv);
+    expect_eq(first.next().lexeme, "x"sv);
+    expect_eq(second.offset(), u64(3));
+
+    sigil::ScanCursor first_again(scanner, "<first>", first_input);
+    driver.initialize("<first>", first_input);
+    expect_same_tokens(first_again, driver);
+    expect_eq(first_again.next().type, (s32)sigil::SpecialTokenType::Eof);
+
+    sigil::ScanCursor second_again(scanner, "<second>", second_input);
+    driver.initialize("<second>", second_input);
+    expect_same_tokens(second_again, driver);
+    expect_eq(second_again.next().type, (s32)sigil::SpecialTokenType::Error);
+}
+
+static void batch_scanning()
+{
+    enum class Type : s32
+    {
+        Identifier,
+        Number,
+        Whitespace,
+        Return,
+    };
+
+    sigil::Specification specification;
+    specification.add_regex_token(
+        (s32)Type::Identifier, "Identifier", "[a-z]+");
+    specification.add_regex_token((s32)Type::Number, "Number", "[0-9]+");
+    specification.add_regex_token((s32)Type::Whitespace, "Whitespace", " +");
+    specification.skip_token_type((s32)Type::Whitespace);
+    specification.add_keyword_token(
+        (s32)Type::Return, "Return", "return", (s32)Type::Identifier);
+
+    auto either_scanner = sigil::CompiledScanner::create(specification);
+    const auto scanner = std::move(either_scanner.release_right());
+
+    // More inputs than lanes, of different lengths, and more tokens than a
+    // lane records at once
+    const StringView inputs[] = {
+        "return 1"sv,
+        ""sv,
+        "abc  de 42"sv,
+        "x % y"sv,
+        "  "sv,
+        "a1b2c3"sv,
+        "q"sv,
+        "return"sv,
+        "7 7 7"sv,
+        "zz 9"sv,
+        "a b c d e f g h i j k l m n o p q r s t u v w x y z 1 2 3 4 5 6 "sv,
+    };
+    const auto input_count = sizeof(inputs) / sizeof(inputs[0]);
+
+    for (const auto lane_count : { Size(1), Size(4), Size(16) }) {
+        List<List<sigil::Token>> tokens(input_count);
+        for (Index i = 0; i < input_count; ++i) tokens.add({});
+        sigil::BatchScanner batch(scanner, lane_count);
+        batch.scan(
+            core::ListView<StringView>(inputs, input_count),
+            [&](Index input, sigil::TokenType type, StringView lexeme) {
+                tokens[input].add({ type, lexeme, {} });
+            });
+
+        for (Index i = 0; i < input_count; ++i) {
+            sigil::ScanCursor cursor(scanner, "<string>", inputs[i]);
+            for (const auto &actual : tokens[i]) {
+                const auto expected = cursor.next();
+                expect_eq(actual.type, expected.type);
+                expect_eq(actual.lexeme, expected.lexeme);
+            }
+            const auto last = tokens[i][tokens[i].size() - 1].type;
+            assert(
+                last == (s32)sigil::SpecialTokenType::Eof or
+                last == (s32)sigil::SpecialTokenType::Error);
+        }
+        expect_eq(tokens[0][0].type, (s32)Type::Return);
+        expect_eq(tokens[1].size(), Size(1));
+        expect_eq(tokens[3][1].type, (s32)sigil::SpecialTokenType::Error);
+        expect_eq(tokens[5].size(), Size(7));
+    }
+}
+
+static void shuffle_scanning()
+{
+    enum class Type : s32
+    {
+        Identifier,
+        Number,
+        String,
+        Whitespace,
+        Plus,
+        Return,
+    };
+
+    sigil::Specification specification;
+    specification.add_regex_token(
+        (s32)Type::Identifier, "Identifier", "[a-z]+");
+    specification.add_regex_token((s32)Type::Number, "Number", "[0-9]+");
+    specification.add_regex_token((s32)Type::String, "String", "'[^']*'");
+    specification.add_regex_token((s32)Type::Whitespace, "Whitespace", " +");
+    specification.skip_token_type((s32)Type::Whitespace);
+    specification.add_literal_token((s32)Type::Plus, "Plus", "+");
+    specification.add_keyword_token(
+        (s32)Type::Return, "Return", "return", (s32)Type::Identifier);
+
+    auto either_scanner = sigil::CompiledScanner::create(specification);
+    const auto scanner = std::move(either_scanner.release_right());
+    auto either_shuffle = sigil::ShuffleScanner::create(scanner);
+    assert(either_shuffle.isRight());
+    const auto shuffle = std::move(either_shuffle.release_right());
+
+    // Composing the maps of two parts gives the map of the whole
+    const auto start = shuffle.start_state();
+    expect_eq(
+        shuffle.run("9 + abc"sv, start),
+        shuffle.run(" abc"sv, shuffle.run("9 +"sv, start)));
+
+    const StringView inputs[] = {
+        "return a+b  + 42 'x y'+'' zz 1 2 3 return"sv,
+        "a + 1 % b"sv,
+        "x 'unterminated"sv,
+        ""sv,
+        "   "sv,
+    };
+    for (const auto &input : inputs) {
+        for (const auto chunk_count : { Size(1), Size(3), Size(7), Size(64) }) {
+            List<sigil::Token> tokens;
+            shuffle.scan(
+                input,
+                chunk_count,
+                [&](sigil::TokenType type, StringView lexeme) {
+                    tokens.add({ type, lexeme, {} });
+                });
+
+            sigil::ScanCursor cursor(scanner, "<string>", input);
+            for (const auto &actual : tokens) {
+                const auto expected = cursor.next();
+                expect_eq(actual.type, expected.type);
+                expect_eq(actual.lexeme, expected.lexeme);
+            }
+            const auto last = tokens[tokens.size() - 1].type;
+            assert(
+                last == (s32)sigil::SpecialTokenType::Eof or
+                last == (s32)sigil::SpecialTokenType::Error);
+        }
+    }
+
+    // "1." has to back up in front of "1.5"
+    specification.add_regex_token(
+        (s32)Type::Number, "Decimal", "[0-9]+\\.[0-9]+");
+    auto either_backing = sigil::CompiledScanner::create(specification);
+    const auto backing = std::move(either_backing.release_right());
+    assert(not sigil::ShuffleScanner::create(backing).isRight());
+}
+
 void sigil_tests()
 {
     char_set_tests();
@@ -352,6 +1904,28 @@ void sigil_tests()
     dfa_simulation_float_literals();
     scanner_detect_eof_instead_of_error();
     user_controlled_token_values();
+    static_table_file_roundtrip();
+    compile_cache();
+    scanner_modes();
+    skipped_token_types();
+    unicode_code_points();
+    case_insensitive_tokens();
+    keyword_tokens();
+    literal_dictionary();
+    bounded_repetition();
+    regexp_simplification();
+    compile_statistics();
+    scanner_counters();
+    incremental_compilation();
+    lazy_dfa_scanning();
+    bit_parallel_scanning();
+    dfa_budget();
+    incremental_scanning();
+    unanchored_search();
+    literal_prefilter();
+    scan_cursors();
+    batch_scanning();
+    shuffle_scanning();
 }
 
 int main()